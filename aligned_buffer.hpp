@@ -7,6 +7,14 @@
 
 #include <memory>
 #include <cstdlib>
+#include <cstddef>
+#include <iterator>
+#include <functional>
+#include <utility>
+
+#if defined __linux__
+# include <sys/mman.h>
+#endif
 
 #if !defined DIM_ALIGNED_BUFFER_DISABLE_SIMD
 # define DIM_ALIGNED_BUFFER_DISABLE_SIMD 0
@@ -18,6 +26,31 @@
 
 namespace dim {
 
+#if DIM_ALIGNED_BUFFER_DISABLE_SIMD
+constexpr auto default_vector_size=0; // ignored by the kernels
+#else
+constexpr auto default_vector_size=simd::max_vector_size;
+#endif
+
+enum class BufferInit
+{
+  zero, // the constructing thread zeroes the whole buffer
+  none  // elements are left uninitialised (the padding is still zeroed)
+};
+
+enum class BufferPages
+{
+  standard, // usual pages from the C library allocator
+  huge      // huge pages if available (for large buffers only)
+};
+
+enum class BufferBacking
+{
+  heap,             // C library allocator
+  huge_tlb,         // mmap(MAP_HUGETLB), from the reserved huge page pool
+  transparent_huge  // mmap() on 2 MiB boundaries, madvise(MADV_HUGEPAGE)
+};
+
 template<typename T,
          int Alignment=assumed_cacheline_size>
 class AlignedBuffer
@@ -32,6 +65,22 @@ public:
 
   static constexpr auto alignment=Alignment;
 
+  static constexpr auto huge_page_size=std::size_t{2*1024*1024};
+
+#if DIM_ALIGNED_BUFFER_DISABLE_SIMD
+  static constexpr auto max_multi_vector_size=alignment;
+#else
+  // the largest simd::Multi (vector size times unroll) which the padding
+  // at the end of the buffer can accommodate; the Unroll of the kernels is
+  // only known when they are called, thus every buffer is padded for it:
+  // at most three more cachelines (192 bytes with 64-byte vectors) are
+  // allocated and zeroed once per buffer, which only matters for very
+  // many tiny buffers (an AlignedBuffer per small object should be avoided
+  // anyway)
+  static constexpr auto max_multi_vector_size=
+    std::max(alignment, 4*simd::dispatch_vector_size_limit);
+#endif
+
   AlignedBuffer()
   : AlignedBuffer{0}
   {
@@ -39,33 +88,51 @@ public:
   }
 
   explicit
-  AlignedBuffer(int count)
+  AlignedBuffer(std::ptrdiff_t count,
+                BufferInit init=BufferInit::zero,
+                BufferPages pages=BufferPages::standard)
   : count_{count}
   , data_{}
   {
-    const auto requested=count*int(sizeof(T));
+    const auto requested=count*std::ptrdiff_t(sizeof(T));
     // align at the end too (so that simd operations can overflow)
-    const auto padded=requested+alignment-(requested%alignment);
-#if defined __APPLE__ || defined _WIN32
-    // FIXME: some systems lack some standard features!
-    auto *p=static_cast<unsigned char *>(std::malloc(alignment+padded));
-    const auto offset=static_cast<unsigned char>
-      (alignment-reinterpret_cast<std::size_t>(p)%alignment);
-    p+=offset;
-    p[-1]=offset;
-#else
-    auto *p=std::aligned_alloc(alignment, padded);
-#endif
-    data_.reset(reinterpret_cast<T *>(p));
-    std::fill(data_.get(), data_.get()+(padded/int(sizeof(T))), T{});
+    const auto padded=requested+max_multi_vector_size-
+                      (requested%max_multi_vector_size);
+    auto backing=BufferBacking::heap;
+    auto size=std::size_t(padded);
+    void *p=nullptr;
+    if((pages==BufferPages::huge)&&(size>=huge_page_size))
+    {
+      p=map_huge_(size, backing);
+    }
+    if(!p) // standard pages requested, or huge pages not available
+    {
+      p=allocate_(size);
+    }
+    data_=std::unique_ptr<T[], Deleter>{reinterpret_cast<T *>(p),
+                                        Deleter{size, backing}};
+    if(backing==BufferBacking::heap) // mapped pages are already zero
+    {
+      // with BufferInit::none, pages are placed on the numa node of the
+      // thread which first touches them (see first_touch())
+      const auto first=(init==BufferInit::zero) ? 0 : count;
+      std::fill(data_.get()+first,
+                data_.get()+padded/std::ptrdiff_t(sizeof(T)), T{});
+    }
   }
 
-  int
+  std::ptrdiff_t
   count() const
   {
     return count_;
   }
 
+  BufferBacking // what was actually obtained, whatever was requested
+  backing() const
+  {
+    return data_.get_deleter().backing;
+  }
+
   T *
   data() DIM_ASSUME_ALIGNED(alignment)
   {
@@ -84,32 +151,146 @@ public:
   static_assert((alignment%simd_t::vector_size)==0,
                 "alignment should be a multiple of simd vector size");
 
-  int
+  // the VectorSize parameter lets dispatched kernels use wider vectors than
+  // the compiler options allow, and Unroll groups that many vectors in a
+  // simd::Multi (padding is a multiple of max_multi_vector_size anyway)
+
+  template<int VectorSize=simd::max_vector_size,
+           int Unroll=1>
+  std::ptrdiff_t
   simd_count() const
   {
-    return (count_+simd_t::value_count-1)/simd_t::value_count;
+    constexpr auto value_count=
+      simd::multi_t<T, VectorSize, Unroll>::value_count;
+    return (count_+value_count-1)/value_count;
   }
 
-  simd_t *
-  simd_data() DIM_ASSUME_ALIGNED(alignment)
+  template<int VectorSize=simd::max_vector_size,
+           int Unroll=1>
+  DIM_ASSUME_ALIGNED(alignment) // not allowed after a template declarator
+  simd::multi_t<T, VectorSize, Unroll> *
+  simd_data()
   {
-    return reinterpret_cast<simd_t *>(data_.get());
+    check_multi_<VectorSize, Unroll>();
+    return reinterpret_cast<simd::multi_t<T, VectorSize, Unroll> *>(
+      data_.get());
   }
 
-  const simd_t *
-  simd_cdata() const DIM_ASSUME_ALIGNED(alignment)
+  template<int VectorSize=simd::max_vector_size,
+           int Unroll=1>
+  DIM_ASSUME_ALIGNED(alignment)
+  const simd::multi_t<T, VectorSize, Unroll> *
+  simd_cdata() const
   {
-    return reinterpret_cast<const simd_t *>(data_.get());
+    check_multi_<VectorSize, Unroll>();
+    return reinterpret_cast<const simd::multi_t<T, VectorSize, Unroll> *>(
+      data_.get());
   }
 #endif
 
 private:
 
+#if !DIM_ALIGNED_BUFFER_DISABLE_SIMD
+  template<int VectorSize,
+           int Unroll>
+  static constexpr
+  void
+  check_multi_()
+  {
+    static_assert((alignment%VectorSize)==0,
+                  "alignment should be a multiple of simd vector size");
+    static_assert((Unroll>0)&&
+                  ((max_multi_vector_size%(VectorSize*Unroll))==0),
+                  "unrolled vectors should divide max_multi_vector_size");
+  }
+#endif
+
+  static
+  void *
+  allocate_(std::size_t size)
+  {
+#if defined __APPLE__ || defined _WIN32
+    // FIXME: some systems lack some standard features!
+    auto *p=static_cast<unsigned char *>(std::malloc(alignment+size));
+    const auto offset=static_cast<unsigned char>
+      (alignment-reinterpret_cast<std::size_t>(p)%alignment);
+    p+=offset;
+    p[-1]=offset;
+    return p;
+#else
+    return std::aligned_alloc(alignment, size);
+#endif
+  }
+
+  static
+  void * // mapped memory or nullptr (size and backing are updated)
+  map_huge_(std::size_t &size,
+            BufferBacking &backing)
+  {
+#if defined __linux__
+    const auto huge_size=(size+huge_page_size-1)/huge_page_size*
+                         huge_page_size;
+    const auto prot=PROT_READ|PROT_WRITE;
+    const auto flags=MAP_PRIVATE|MAP_ANONYMOUS;
+# if defined MAP_HUGETLB
+    if(auto *p=::mmap(nullptr, huge_size, prot, flags|MAP_HUGETLB, -1, 0);
+       p!=MAP_FAILED)
+    {
+      size=huge_size;
+      backing=BufferBacking::huge_tlb;
+      return p;
+    }
+# endif
+# if defined MADV_HUGEPAGE
+    // map more than needed in order to keep only 2 MiB-aligned pages
+    const auto mapped_size=huge_size+huge_page_size;
+    if(auto *m=::mmap(nullptr, mapped_size, prot, flags, -1, 0);
+       m!=MAP_FAILED)
+    {
+      auto *mb=static_cast<unsigned char *>(m);
+      auto *me=mb+mapped_size;
+      const auto misalign=reinterpret_cast<std::uintptr_t>(mb)%
+                          huge_page_size;
+      auto *p=mb+(misalign ? huge_page_size-misalign : 0);
+      if(p!=mb)
+      {
+        ::munmap(mb, std::size_t(p-mb));
+      }
+      if(p+huge_size!=me)
+      {
+        ::munmap(p+huge_size, std::size_t(me-(p+huge_size)));
+      }
+      if(::madvise(p, huge_size, MADV_HUGEPAGE)==0)
+      {
+        size=huge_size;
+        backing=BufferBacking::transparent_huge;
+        return p;
+      }
+      ::munmap(p, huge_size);
+    }
+# endif
+#else
+    (void)size;
+    (void)backing;
+#endif
+    return nullptr;
+  }
+
   struct Deleter
   {
+    std::size_t size{};
+    BufferBacking backing{BufferBacking::heap};
+
     void
     operator()(void *ptr)
     {
+#if defined __linux__
+      if(backing!=BufferBacking::heap)
+      {
+        ::munmap(ptr, size);
+        return;
+      }
+#endif
 #if defined __APPLE__ || defined _WIN32
       // FIXME: some systems lack some standard features!
       auto *p=static_cast<unsigned char *>(ptr);
@@ -121,7 +302,7 @@ private:
     }
   };
 
-  int count_;
+  std::ptrdiff_t count_;
   std::unique_ptr<T[], Deleter> data_;
 };
 
@@ -143,23 +324,34 @@ private:
     DIM_ALIGNED_BUFFER_UNROLL \
     for(auto [i, i_end]=sequence_part(count, part_id, part_count); \
         i<i_end; ++i) { call; }
+# define DIM_ALIGNED_BUFFER_ITERATE_STREAM(call) \
+    DIM_ALIGNED_BUFFER_ITERATE( \
+      auto v1=T1{}; call; d1[i]=v1)
 #else
 # define DIM_ALIGNED_BUFFER_ACCESS_DATA(id) \
-    auto * DIM_RESTRICT d##id=buffer##id.simd_data(); \
-    using simd_t##id = typename std::decay_t<decltype(buffer##id)>::simd_t; \
+    auto * DIM_RESTRICT d##id= \
+      buffer##id.template simd_data<VectorSize, Unroll>(); \
+    using simd_t##id = std::decay_t<decltype(*d##id)>; \
     static_assert(simd_t1::value_count==simd_t##id::value_count);
 # define DIM_ALIGNED_BUFFER_ACCESS_CDATA(id) \
-    const auto * DIM_RESTRICT d##id=buffer##id.simd_cdata(); \
-    using simd_t##id = typename std::decay_t<decltype(buffer##id)>::simd_t; \
+    const auto * DIM_RESTRICT d##id= \
+      buffer##id.template simd_cdata<VectorSize, Unroll>(); \
+    using simd_t##id = std::decay_t<decltype(*d##id)>; \
     static_assert(simd_t1::value_count==simd_t##id::value_count);
 # define DIM_ALIGNED_BUFFER_ITERATE(call) \
-    const auto count=buffer1.simd_count(); \
+    const auto count=buffer1.template simd_count<VectorSize, Unroll>(); \
     DIM_ALIGNED_BUFFER_UNROLL \
     for(auto [i, i_end]=sequence_part(count, part_id, part_count); \
         i<i_end; ++i) { call; }
+# define DIM_ALIGNED_BUFFER_ITERATE_STREAM(call) \
+    DIM_ALIGNED_BUFFER_ITERATE( \
+      auto v1=simd_t1{}; call; simd::store_stream(d1+i, v1)) \
+    simd::stream_fence();
 #endif
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename Fnct>
 inline
 void
@@ -172,7 +364,9 @@ apply0(int part_id, int part_count,
     fnct(d1[i]))
 }
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename Fnct>
 inline
@@ -188,7 +382,9 @@ apply0(int part_id, int part_count,
     fnct(d1[i], d2[i]))
 }
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename T3,
          typename Fnct>
@@ -207,7 +403,9 @@ apply0(int part_id, int part_count,
     fnct(d1[i], d2[i], d3[i]))
 }
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename T3,
          typename T4,
@@ -229,7 +427,9 @@ apply0(int part_id, int part_count,
     fnct(d1[i], d2[i], d3[i], d4[i]))
 }
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename T3,
          typename T4,
@@ -254,7 +454,9 @@ apply0(int part_id, int part_count,
     fnct(d1[i], d2[i], d3[i], d4[i], d5[i]))
 }
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename T3,
          typename T4,
@@ -282,7 +484,9 @@ apply0(int part_id, int part_count,
     fnct(d1[i], d2[i], d3[i], d4[i], d5[i], d6[i]))
 }
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename T3,
          typename T4,
@@ -315,7 +519,9 @@ apply0(int part_id, int part_count,
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename Fnct>
 inline
 void
@@ -328,7 +534,9 @@ apply1(AlignedBuffer<T1> &buffer1,
     fnct(d1[i]))
 }
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename Fnct>
 inline
@@ -344,7 +552,9 @@ apply1(AlignedBuffer<T1> &buffer1,
     fnct(d1[i], d2[i]))
 }
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename T3,
          typename Fnct>
@@ -363,7 +573,9 @@ apply1(AlignedBuffer<T1> &buffer1,
     fnct(d1[i], d2[i], d3[i]))
 }
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename T3,
          typename T4,
@@ -385,7 +597,9 @@ apply1(AlignedBuffer<T1> &buffer1,
     fnct(d1[i], d2[i], d3[i], d4[i]))
 }
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename T3,
          typename T4,
@@ -410,7 +624,9 @@ apply1(AlignedBuffer<T1> &buffer1,
     fnct(d1[i], d2[i], d3[i], d4[i], d5[i]))
 }
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename T3,
          typename T4,
@@ -438,7 +654,9 @@ apply1(AlignedBuffer<T1> &buffer1,
     fnct(d1[i], d2[i], d3[i], d4[i], d5[i], d6[i]))
 }
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename T3,
          typename T4,
@@ -469,9 +687,183 @@ apply1(AlignedBuffer<T1> &buffer1,
     fnct(d1[i], d2[i], d3[i], d4[i], d5[i], d6[i], d7[i]))
 }
 
+// same as apply1() but fnct() must only write its first argument (without
+// reading it), which is then sent to memory with non-temporal stores; this
+// avoids reading, then evicting, the destination when it exceeds the caches
+
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
+         typename Fnct>
+inline
+void
+apply1_stream(AlignedBuffer<T1> &buffer1,
+              int part_id, int part_count,
+              Fnct fnct)
+{
+  DIM_ALIGNED_BUFFER_ACCESS_DATA(1)
+  DIM_ALIGNED_BUFFER_ITERATE_STREAM(
+    fnct(v1))
+}
+
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
+         typename T2,
+         typename Fnct>
+inline
+void
+apply1_stream(AlignedBuffer<T1> &buffer1,
+              int part_id, int part_count,
+              const AlignedBuffer<T2> &buffer2,
+              Fnct fnct)
+{
+  DIM_ALIGNED_BUFFER_ACCESS_DATA(1)
+  DIM_ALIGNED_BUFFER_ACCESS_CDATA(2)
+  DIM_ALIGNED_BUFFER_ITERATE_STREAM(
+    fnct(v1, d2[i]))
+}
+
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
+         typename T2,
+         typename T3,
+         typename Fnct>
+inline
+void
+apply1_stream(AlignedBuffer<T1> &buffer1,
+              int part_id, int part_count,
+              const AlignedBuffer<T2> &buffer2,
+              const AlignedBuffer<T3> &buffer3,
+              Fnct fnct)
+{
+  DIM_ALIGNED_BUFFER_ACCESS_DATA(1)
+  DIM_ALIGNED_BUFFER_ACCESS_CDATA(2)
+  DIM_ALIGNED_BUFFER_ACCESS_CDATA(3)
+  DIM_ALIGNED_BUFFER_ITERATE_STREAM(
+    fnct(v1, d2[i], d3[i]))
+}
+
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
+         typename T2,
+         typename T3,
+         typename T4,
+         typename Fnct>
+inline
+void
+apply1_stream(AlignedBuffer<T1> &buffer1,
+              int part_id, int part_count,
+              const AlignedBuffer<T2> &buffer2,
+              const AlignedBuffer<T3> &buffer3,
+              const AlignedBuffer<T4> &buffer4,
+              Fnct fnct)
+{
+  DIM_ALIGNED_BUFFER_ACCESS_DATA(1)
+  DIM_ALIGNED_BUFFER_ACCESS_CDATA(2)
+  DIM_ALIGNED_BUFFER_ACCESS_CDATA(3)
+  DIM_ALIGNED_BUFFER_ACCESS_CDATA(4)
+  DIM_ALIGNED_BUFFER_ITERATE_STREAM(
+    fnct(v1, d2[i], d3[i], d4[i]))
+}
+
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
+         typename T2,
+         typename T3,
+         typename T4,
+         typename T5,
+         typename Fnct>
+inline
+void
+apply1_stream(AlignedBuffer<T1> &buffer1,
+              int part_id, int part_count,
+              const AlignedBuffer<T2> &buffer2,
+              const AlignedBuffer<T3> &buffer3,
+              const AlignedBuffer<T4> &buffer4,
+              const AlignedBuffer<T5> &buffer5,
+              Fnct fnct)
+{
+  DIM_ALIGNED_BUFFER_ACCESS_DATA(1)
+  DIM_ALIGNED_BUFFER_ACCESS_CDATA(2)
+  DIM_ALIGNED_BUFFER_ACCESS_CDATA(3)
+  DIM_ALIGNED_BUFFER_ACCESS_CDATA(4)
+  DIM_ALIGNED_BUFFER_ACCESS_CDATA(5)
+  DIM_ALIGNED_BUFFER_ITERATE_STREAM(
+    fnct(v1, d2[i], d3[i], d4[i], d5[i]))
+}
+
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
+         typename T2,
+         typename T3,
+         typename T4,
+         typename T5,
+         typename T6,
+         typename Fnct>
+inline
+void
+apply1_stream(AlignedBuffer<T1> &buffer1,
+              int part_id, int part_count,
+              const AlignedBuffer<T2> &buffer2,
+              const AlignedBuffer<T3> &buffer3,
+              const AlignedBuffer<T4> &buffer4,
+              const AlignedBuffer<T5> &buffer5,
+              const AlignedBuffer<T6> &buffer6,
+              Fnct fnct)
+{
+  DIM_ALIGNED_BUFFER_ACCESS_DATA(1)
+  DIM_ALIGNED_BUFFER_ACCESS_CDATA(2)
+  DIM_ALIGNED_BUFFER_ACCESS_CDATA(3)
+  DIM_ALIGNED_BUFFER_ACCESS_CDATA(4)
+  DIM_ALIGNED_BUFFER_ACCESS_CDATA(5)
+  DIM_ALIGNED_BUFFER_ACCESS_CDATA(6)
+  DIM_ALIGNED_BUFFER_ITERATE_STREAM(
+    fnct(v1, d2[i], d3[i], d4[i], d5[i], d6[i]))
+}
+
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
+         typename T2,
+         typename T3,
+         typename T4,
+         typename T5,
+         typename T6,
+         typename T7,
+         typename Fnct>
+inline
+void
+apply1_stream(AlignedBuffer<T1> &buffer1,
+              int part_id, int part_count,
+              const AlignedBuffer<T2> &buffer2,
+              const AlignedBuffer<T3> &buffer3,
+              const AlignedBuffer<T4> &buffer4,
+              const AlignedBuffer<T5> &buffer5,
+              const AlignedBuffer<T6> &buffer6,
+              const AlignedBuffer<T7> &buffer7,
+              Fnct fnct)
+{
+  DIM_ALIGNED_BUFFER_ACCESS_DATA(1)
+  DIM_ALIGNED_BUFFER_ACCESS_CDATA(2)
+  DIM_ALIGNED_BUFFER_ACCESS_CDATA(3)
+  DIM_ALIGNED_BUFFER_ACCESS_CDATA(4)
+  DIM_ALIGNED_BUFFER_ACCESS_CDATA(5)
+  DIM_ALIGNED_BUFFER_ACCESS_CDATA(6)
+  DIM_ALIGNED_BUFFER_ACCESS_CDATA(7)
+  DIM_ALIGNED_BUFFER_ITERATE_STREAM(
+    fnct(v1, d2[i], d3[i], d4[i], d5[i], d6[i], d7[i]))
+}
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename Fnct>
 inline
@@ -487,7 +879,9 @@ apply2(AlignedBuffer<T1> &buffer1,
     fnct(d1[i], d2[i]))
 }
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename T3,
          typename Fnct>
@@ -506,7 +900,9 @@ apply2(AlignedBuffer<T1> &buffer1,
     fnct(d1[i], d2[i], d3[i]))
 }
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename T3,
          typename T4,
@@ -528,7 +924,9 @@ apply2(AlignedBuffer<T1> &buffer1,
     fnct(d1[i], d2[i], d3[i], d4[i]))
 }
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename T3,
          typename T4,
@@ -553,7 +951,9 @@ apply2(AlignedBuffer<T1> &buffer1,
     fnct(d1[i], d2[i], d3[i], d4[i], d5[i]))
 }
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename T3,
          typename T4,
@@ -581,7 +981,9 @@ apply2(AlignedBuffer<T1> &buffer1,
     fnct(d1[i], d2[i], d3[i], d4[i], d5[i], d6[i]))
 }
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename T3,
          typename T4,
@@ -614,7 +1016,9 @@ apply2(AlignedBuffer<T1> &buffer1,
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename T3,
          typename Fnct>
@@ -633,7 +1037,9 @@ apply3(AlignedBuffer<T1> &buffer1,
     fnct(d1[i], d2[i], d3[i]))
 }
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename T3,
          typename T4,
@@ -655,7 +1061,9 @@ apply3(AlignedBuffer<T1> &buffer1,
     fnct(d1[i], d2[i], d3[i], d4[i]))
 }
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename T3,
          typename T4,
@@ -680,7 +1088,9 @@ apply3(AlignedBuffer<T1> &buffer1,
     fnct(d1[i], d2[i], d3[i], d4[i], d5[i]))
 }
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename T3,
          typename T4,
@@ -708,7 +1118,9 @@ apply3(AlignedBuffer<T1> &buffer1,
     fnct(d1[i], d2[i], d3[i], d4[i], d5[i], d6[i]))
 }
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename T3,
          typename T4,
@@ -741,7 +1153,9 @@ apply3(AlignedBuffer<T1> &buffer1,
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename T3,
          typename T4,
@@ -763,7 +1177,9 @@ apply4(AlignedBuffer<T1> &buffer1,
     fnct(d1[i], d2[i], d3[i], d4[i]))
 }
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename T3,
          typename T4,
@@ -788,7 +1204,9 @@ apply4(AlignedBuffer<T1> &buffer1,
     fnct(d1[i], d2[i], d3[i], d4[i], d5[i]))
 }
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename T3,
          typename T4,
@@ -816,7 +1234,9 @@ apply4(AlignedBuffer<T1> &buffer1,
     fnct(d1[i], d2[i], d3[i], d4[i], d5[i], d6[i]))
 }
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename T3,
          typename T4,
@@ -849,7 +1269,9 @@ apply4(AlignedBuffer<T1> &buffer1,
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename T3,
          typename T4,
@@ -874,7 +1296,9 @@ apply5(AlignedBuffer<T1> &buffer1,
     fnct(d1[i], d2[i], d3[i], d4[i], d5[i]))
 }
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename T3,
          typename T4,
@@ -902,7 +1326,9 @@ apply5(AlignedBuffer<T1> &buffer1,
     fnct(d1[i], d2[i], d3[i], d4[i], d5[i], d6[i]))
 }
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename T3,
          typename T4,
@@ -935,7 +1361,9 @@ apply5(AlignedBuffer<T1> &buffer1,
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename T3,
          typename T4,
@@ -963,7 +1391,9 @@ apply6(AlignedBuffer<T1> &buffer1,
     fnct(d1[i], d2[i], d3[i], d4[i], d5[i], d6[i]))
 }
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename T3,
          typename T4,
@@ -996,7 +1426,9 @@ apply6(AlignedBuffer<T1> &buffer1,
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-template<typename T1,
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T1,
          typename T2,
          typename T3,
          typename T4,
@@ -1030,18 +1462,38 @@ apply6(AlignedBuffer<T1> &buffer1,
 #undef DIM_ALIGNED_BUFFER_ACCESS_DATA
 #undef DIM_ALIGNED_BUFFER_ACCESS_CDATA
 #undef DIM_ALIGNED_BUFFER_ITERATE
+#undef DIM_ALIGNED_BUFFER_ITERATE_STREAM
 #undef DIM_ALIGNED_BUFFER_UNROLL
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-template<typename T>
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T>
 inline
 void
 fill(AlignedBuffer<T> &dst,
      int part_id, int part_count,
      const T &value)
 {
-  apply1(dst,
+  apply1<VectorSize, Unroll>(dst,
+    part_id, part_count,
+    [&](auto &p)
+    {
+      p=value;
+    });
+}
+
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T>
+inline
+void
+fill_stream(AlignedBuffer<T> &dst,
+            int part_id, int part_count,
+            const T &value)
+{
+  apply1_stream<VectorSize, Unroll>(dst,
     part_id, part_count,
     [&](auto &p)
     {
@@ -1049,18 +1501,20 @@ fill(AlignedBuffer<T> &dst,
     });
 }
 
-template<typename T>
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T>
 inline
 void
 fill(AlignedBuffer<T> &dst,
      int part_id, int part_count,
-     int width, [[maybe_unused]] int height,
-     int x, int y, int w, int h,
+     std::ptrdiff_t width, [[maybe_unused]] std::ptrdiff_t height,
+     std::ptrdiff_t x, std::ptrdiff_t y, std::ptrdiff_t w, std::ptrdiff_t h,
      const T &value)
 {
   if((x==0)&&(w==width)&&(y==0)&&(h==height))
   {
-    return fill(dst, part_id, part_count, value);
+    return fill<VectorSize, Unroll>(dst, part_id, part_count, value);
   }
 #if DIM_ALIGNED_BUFFER_DISABLE_SIMD
   auto * DIM_RESTRICT d=dst.data();
@@ -1074,16 +1528,20 @@ fill(AlignedBuffer<T> &dst,
     }
   }
 #else
-  using simd_t = typename AlignedBuffer<T>::simd_t;
+  // independent stores, thus nothing to be gained by unrolling the rows
+  using simd_t = simd::simd_t<T, VectorSize>;
   const auto simd_value=simd_t{value};
   for(auto [yid, yid_end]=sequence_part(y, y+h, part_id, part_count);
       yid<yid_end; ++yid)
   {
     auto * DIM_RESTRICT d=dst.data()+yid*width+x;
     const auto [pfx, count, sfx]=simd::split<simd_t>(d, w);
-    simd::store_prefix(d, pfx, simd_value);
-    d+=pfx;
-    for(auto i=0; i<count; ++i)
+    if(pfx)
+    {
+      simd::store_prefix(d, pfx, simd_value);
+      d+=pfx;
+    }
+    for(auto i=std::ptrdiff_t{}; i<count; ++i)
     {
       simd::store_a(d, simd_value);
       d+=simd_t::value_count;
@@ -1093,74 +1551,466 @@ fill(AlignedBuffer<T> &dst,
 #endif
 }
 
-template<typename T>
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T>
 inline
-T
-sum(const AlignedBuffer<T> &buffer,
-    int part_id, int part_count)
+void
+first_touch(AlignedBuffer<T> &dst,
+            int part_id, int part_count)
 {
+  // each part zeroes, thus places on its own numa node, exactly the
+  // slice it will later process in apply*()
+  fill<VectorSize, Unroll>(dst, part_id, part_count, T{});
+}
+
+//~~~~ reductions ~~~~
+
+// enough independent accumulators to hide the latency of the vector
+// operations, but not so many that they cannot stay in registers (each
+// accumulator being made of Unroll vectors)
+template<int VectorSize=default_vector_size,
+         int Unroll=1>
+constexpr auto reduction_accumulator_count=
+  std::max((VectorSize>=64 ? 8 : 4)/Unroll, 1);
+
+namespace impl_ {
+
 #if DIM_ALIGNED_BUFFER_DISABLE_SIMD
-  auto accum=T{};
+template<typename T,
+         int VectorSize=default_vector_size,
+         int Unroll=1>
+using reduce_elem_t = T;
 #else
-  auto accum=typename AlignedBuffer<T>::simd_t{};
+template<typename T,
+         int VectorSize=default_vector_size,
+         int Unroll=1>
+using reduce_elem_t = simd::multi_t<T, VectorSize, Unroll>;
 #endif
-  apply0(
-    part_id, part_count,
-    buffer,
-    [&](const auto & p)
+
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T>
+inline
+const reduce_elem_t<T, VectorSize, Unroll> *
+reduce_data_(const AlignedBuffer<T> &buffer)
+{
+#if DIM_ALIGNED_BUFFER_DISABLE_SIMD
+  return buffer.cdata();
+#else
+  return buffer.template simd_cdata<VectorSize, Unroll>();
+#endif
+}
+
+struct Ranges_ // the element ranges a part has to consider
+{
+  std::ptrdiff_t first, last; // [first, last) for the first range
+  std::ptrdiff_t stride;      // from one range to the next
+  std::ptrdiff_t count;
+};
+
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T>
+inline
+Ranges_ // the same slice as apply0()
+part_ranges_(const AlignedBuffer<T> &buffer,
+             int part_id, int part_count)
+{
+#if DIM_ALIGNED_BUFFER_DISABLE_SIMD
+  const auto [i, i_end]=sequence_part(buffer.count(), part_id, part_count);
+  return {i, i_end, 0, 1};
+#else
+  constexpr auto vc=simd::multi_t<T, VectorSize, Unroll>::value_count;
+  const auto [i, i_end]=sequence_part(
+    buffer.template simd_count<VectorSize, Unroll>(), part_id, part_count);
+  return {i*vc, std::min(i_end*vc, buffer.count()), 0, 1};
+#endif
+}
+
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T>
+inline
+Ranges_ // some of the rows of a region of interest
+part_ranges_(const AlignedBuffer<T> &buffer,
+             int part_id, int part_count,
+             std::ptrdiff_t width, std::ptrdiff_t height,
+             std::ptrdiff_t x, std::ptrdiff_t y,
+             std::ptrdiff_t w, std::ptrdiff_t h)
+{
+  if((x==0)&&(w==width)&&(y==0)&&(h==height))
+  {
+    return part_ranges_<VectorSize, Unroll>(buffer, part_id, part_count);
+  }
+  const auto [yid, yid_end]=sequence_part(y, y+h, part_id, part_count);
+  return {yid*width+x, yid*width+x+w, width, yid_end-yid};
+}
+
+template<typename SimdType,
+         typename Keep>
+inline
+SimdType // the lanes which are not kept are replaced by identity
+keep_(SimdType s,
+      Keep keep,
+      [[maybe_unused]] SimdType identity)
+{
+  if constexpr(std::is_same_v<Keep, std::true_type>)
+  {
+    return s;
+  }
+  else
+  {
+    return select(keep, s, identity);
+  }
+}
+
+template<typename Fnct,
+         int... Id>
+inline
+void
+unroll_(Fnct fnct,
+        std::integer_sequence<int, Id...>)
+{
+  (fnct(std::integral_constant<int, Id>{}), ...);
+}
+
+template<typename T,
+         int VectorSize,
+         int Unroll,
+         int AccumCount,
+         typename Accum,
+         typename Step>
+inline
+void
+reduce_range_(Accum (&accum_inout)[AccumCount],
+              std::ptrdiff_t first, std::ptrdiff_t last,
+              Step step)
+{
+  // step(accum, i, keep) accumulates the (simd) element i, keep being
+  // std::true_type or the mask of the lanes to be considered; successive
+  // elements go to independent accumulators
+  constexpr auto all=std::true_type{};
+  // a local copy cannot alias the data, thus stays in registers
+  Accum accum[AccumCount];
+  for(auto id=0; id<AccumCount; ++id)
+  {
+    accum[id]=accum_inout[id];
+  }
+#if DIM_ALIGNED_BUFFER_DISABLE_SIMD
+  auto i=first;
+  const auto body_end=last;
+#else
+  if(first>=last)
+  {
+    return;
+  }
+  using simd_t = simd::multi_t<T, VectorSize, Unroll>;
+  constexpr auto vc=simd_t::value_count;
+  auto i=first/vc;
+  const auto body_end=last/vc;
+  if(const auto first_lane=int(first%vc); first_lane)
+  {
+    const auto last_lane=(i==body_end) ? int(last%vc) : vc;
+    step(accum[0], i, simd::lane_mask<simd_t>(first_lane, last_lane));
+    ++i;
+  }
+#endif
+  for(; i+AccumCount<=body_end; i+=AccumCount)
+  {
+    unroll_(
+      [&](auto id)
+      {
+        step(accum[id], i+id, all);
+      },
+      std::make_integer_sequence<int, AccumCount>{});
+  }
+  for(; i<body_end; ++i)
+  {
+    step(accum[0], i, all); // constant index: accum fits in registers
+  }
+#if !DIM_ALIGNED_BUFFER_DISABLE_SIMD
+  if(const auto last_lane=int(last%vc); last_lane&&(i==body_end))
+  {
+    step(accum[0], i, simd::lane_mask<simd_t>(0, last_lane));
+  }
+#endif
+  for(auto id=0; id<AccumCount; ++id)
+  {
+    accum_inout[id]=accum[id];
+  }
+}
+
+template<typename T,
+         int VectorSize=default_vector_size,
+         int Unroll=1,
+         int AccumCount=reduction_accumulator_count<VectorSize, Unroll>,
+         typename Accum,
+         typename Step,
+         typename Merge>
+inline
+Accum // the partial accumulators combined in a balanced tree
+reduce_(const Ranges_ &ranges,
+        const Accum &identity,
+        Step step,
+        Merge merge)
+{
+  constexpr auto accum_count=AccumCount;
+  static_assert((accum_count&(accum_count-1))==0,
+                "power of two expected");
+  Accum accum[accum_count];
+  std::fill(std::begin(accum), std::end(accum), identity);
+  for(auto r=std::ptrdiff_t{}; r<ranges.count; ++r)
+  {
+    reduce_range_<T, VectorSize, Unroll>(accum,
+                     ranges.first+r*ranges.stride,
+                     ranges.last+r*ranges.stride,
+                     step);
+  }
+  for(auto half=accum_count/2; half>0; half/=2)
+  {
+    for(auto id=0; id<half; ++id)
     {
-      accum+=p;
-    });
+      accum[id]=merge(accum[id], accum[id+half]);
+    }
+  }
+  return accum[0];
+}
+
+template<typename Accum,
+         typename BinaryOp>
+inline
+auto
+horizontal_(const Accum &accum,
+            [[maybe_unused]] BinaryOp op)
+{
 #if DIM_ALIGNED_BUFFER_DISABLE_SIMD
   return accum;
 #else
-  return horizontal_sum(accum);
+  return simd::horizontal_reduce(accum, op);
 #endif
 }
 
-template<typename T>
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T>
+inline
+T
+sum_(const AlignedBuffer<T> &buffer,
+     const Ranges_ &ranges)
+{
+  using elem_t = reduce_elem_t<T, VectorSize, Unroll>;
+  const auto * DIM_RESTRICT d=reduce_data_<VectorSize, Unroll>(buffer);
+  const auto op=std::plus<>{};
+  return horizontal_(
+    reduce_<T, VectorSize, Unroll>(ranges, elem_t{},
+      [&](auto &accum, std::ptrdiff_t i, auto keep)
+      {
+        accum+=keep_(d[i], keep, elem_t{});
+      },
+      op),
+    op);
+}
+
+} // namespace impl_
+
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T>
+inline
+T
+sum(const AlignedBuffer<T> &buffer,
+    int part_id, int part_count)
+{
+  return impl_::sum_<VectorSize, Unroll>(buffer,
+    impl_::part_ranges_<VectorSize, Unroll>(buffer, part_id, part_count));
+}
+
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T>
 inline
 T
 sum(const AlignedBuffer<T> &buffer,
     int part_id, int part_count,
-    int width, [[maybe_unused]] int height,
-    int x, int y, int w, int h)
+    std::ptrdiff_t width, std::ptrdiff_t height,
+    std::ptrdiff_t x, std::ptrdiff_t y, std::ptrdiff_t w, std::ptrdiff_t h)
 {
-  if((x==0)&&(w==width)&&(y==0)&&(h==height))
+  return impl_::sum_<VectorSize, Unroll>(buffer,
+    impl_::part_ranges_<VectorSize, Unroll>(buffer, part_id, part_count,
+                        width, height, x, y, w, h));
+}
+
+//~~~~ stream compaction ~~~~
+
+struct CompactedPart // what compact() stored for one part
+{
+  std::ptrdiff_t first; // index in dst of the first stored element
+  std::ptrdiff_t count; // number of stored elements
+};
+
+// The elements of the slice of src processed by a part (the same as in
+// apply0()) which satisfy cond() are stored contiguously in dst (at least
+// as large as src), from the beginning of the same slice; the remaining of
+// the slice in dst is unspecified.  cond() receives a simd vector (or an
+// element when simd is disabled) and returns a mask (or a bool).
+// dst may be src.  Once every part is done, they can be stitched by moving
+// each part to the exclusive prefix sum of the counts of the preceding ones
+// (into another buffer, or in place in the order of the parts since none
+// of them moves forward).
+
+template<int VectorSize=default_vector_size,
+         int Unroll=1,
+         typename T,
+         typename Cond>
+inline
+CompactedPart
+compact(AlignedBuffer<T> &dst,
+        const AlignedBuffer<T> &src,
+        int part_id, int part_count,
+        Cond cond)
+{
+  const auto ranges=
+    impl_::part_ranges_<VectorSize, Unroll>(src, part_id, part_count);
+  if(ranges.first>=ranges.last)
   {
-    return sum(buffer, part_id, part_count);
+    return {ranges.first, 0};
   }
+  // no DIM_RESTRICT: dst and src may be the same buffer, but what is
+  // stored never goes beyond what has already been loaded
+  auto *d=dst.data()+ranges.first;
+  auto n=std::ptrdiff_t{};
 #if DIM_ALIGNED_BUFFER_DISABLE_SIMD
-  auto accum=T{};
-  const auto * DIM_RESTRICT p=buffer.cdata();
-  for(auto [yid, yid_end]=sequence_part(y, y+h, part_id, part_count);
-      yid<yid_end; ++yid)
+  const auto *s=src.cdata();
+  for(auto i=ranges.first; i<ranges.last; ++i)
   {
-    const auto xid=yid*width+x;
-    for(auto id=xid, id_end=xid+w; id<id_end; ++id)
-    {
-      accum+=p[id];
-    }
+    const auto value=s[i];
+    d[n]=value; // no branch: overwritten if not kept
+    n+=cond(value) ? 1 : 0;
   }
-  return accum;
 #else
-  using simd_t = typename AlignedBuffer<T>::simd_t;
-  auto accum=simd_t{};
-  for(auto [yid, yid_end]=sequence_part(y, y+h, part_id, part_count);
-      yid<yid_end; ++yid)
+  using simd_t = simd::multi_t<T, VectorSize, Unroll>;
+  using mask_t = typename simd_t::mask_type;
+  constexpr auto vc=simd_t::value_count;
+  const auto *s=src.template simd_cdata<VectorSize, Unroll>();
+  auto i=ranges.first/vc;
+  for(const auto body_end=ranges.last/vc; i<body_end; ++i)
   {
-    const auto * DIM_RESTRICT p=buffer.cdata()+yid*width+x;
-    const auto [pfx, count, sfx]=simd::split<simd_t>(p, w);
-    accum+=simd::load_prefix<simd_t>(p, pfx);
-    p+=pfx;
-    for(auto i=0; i<count; ++i)
-    {
-      accum+=simd::load_a<simd_t>(p);
-      p+=simd_t::value_count;
-    }
-    accum+=simd::load_suffix<simd_t>(p, sfx);
+    const auto v=s[i];
+    n+=simd::compress_store(d+n, v, mask_t{cond(v)});
+  }
+  if(const auto last_lane=int(ranges.last%vc); last_lane)
+  {
+    const auto v=s[i];
+    n+=simd::compress_store(d+n, v,
+      mask_t{cond(v)}&simd::lane_mask<simd_t>(0, last_lane));
+  }
+#endif
+  return {ranges.first, n};
+}
+
+//~~~~ interleaved components ~~~~
+
+// xyz holds x.count() triples xyzxyz... (an array of structures such as
+// dim::Real3) while x, y and z hold the separate components (a structure
+// of arrays); a part converts the same slice as apply0() on x.
+
+template<int VectorSize=default_vector_size,
+         typename T>
+inline
+void
+deinterleave(AlignedBuffer<T> &x,
+             AlignedBuffer<T> &y,
+             AlignedBuffer<T> &z,
+             const AlignedBuffer<T> &xyz,
+             int part_id, int part_count)
+{
+#if DIM_ALIGNED_BUFFER_DISABLE_SIMD
+  auto * DIM_RESTRICT dx=x.data();
+  auto * DIM_RESTRICT dy=y.data();
+  auto * DIM_RESTRICT dz=z.data();
+  const auto * DIM_RESTRICT s=xyz.cdata();
+  for(auto [i, i_end]=sequence_part(x.count(), part_id, part_count);
+      i<i_end; ++i)
+  {
+    dx[i]=s[3*i+0];
+    dy[i]=s[3*i+1];
+    dz[i]=s[3*i+2];
+  }
+#else
+  using simd_t = simd::simd_t<T, VectorSize>;
+  constexpr auto vc=simd_t::value_count;
+  auto * DIM_RESTRICT dx=x.template simd_data<VectorSize>();
+  auto * DIM_RESTRICT dy=y.template simd_data<VectorSize>();
+  auto * DIM_RESTRICT dz=z.template simd_data<VectorSize>();
+  const auto * DIM_RESTRICT s=xyz.cdata();
+  const auto [i_begin, i_end]=sequence_part(
+    x.template simd_count<VectorSize>(), part_id, part_count);
+  const auto body_end=std::min(i_end, x.count()/vc);
+  for(auto i=i_begin; i<body_end; ++i)
+  {
+    std::tie(dx[i], dy[i], dz[i])=
+      simd::impl_::load_interleaved_<simd_t, 3>(s+3*vc*i,
+        std::make_integer_sequence<int, 3>{});
+  }
+  // the remaining triples one by one: the padding of xyz may be shorter
+  // than the three vectors a full load would read
+  for(auto id=body_end*vc, id_end=std::min(i_end*vc, x.count());
+      id<id_end; ++id)
+  {
+    x.data()[id]=s[3*id+0];
+    y.data()[id]=s[3*id+1];
+    z.data()[id]=s[3*id+2];
+  }
+#endif
+}
+
+template<int VectorSize=default_vector_size,
+         typename T>
+inline
+void
+interleave(AlignedBuffer<T> &xyz,
+           const AlignedBuffer<T> &x,
+           const AlignedBuffer<T> &y,
+           const AlignedBuffer<T> &z,
+           int part_id, int part_count)
+{
+#if DIM_ALIGNED_BUFFER_DISABLE_SIMD
+  auto * DIM_RESTRICT d=xyz.data();
+  const auto * DIM_RESTRICT sx=x.cdata();
+  const auto * DIM_RESTRICT sy=y.cdata();
+  const auto * DIM_RESTRICT sz=z.cdata();
+  for(auto [i, i_end]=sequence_part(x.count(), part_id, part_count);
+      i<i_end; ++i)
+  {
+    d[3*i+0]=sx[i];
+    d[3*i+1]=sy[i];
+    d[3*i+2]=sz[i];
+  }
+#else
+  using simd_t = simd::simd_t<T, VectorSize>;
+  constexpr auto vc=simd_t::value_count;
+  auto * DIM_RESTRICT d=xyz.data();
+  const auto * DIM_RESTRICT sx=x.template simd_cdata<VectorSize>();
+  const auto * DIM_RESTRICT sy=y.template simd_cdata<VectorSize>();
+  const auto * DIM_RESTRICT sz=z.template simd_cdata<VectorSize>();
+  const auto [i_begin, i_end]=sequence_part(
+    x.template simd_count<VectorSize>(), part_id, part_count);
+  constexpr auto components=std::make_integer_sequence<int, 3>{};
+  const auto body_end=std::min(i_end, x.count()/vc);
+  for(auto i=i_begin; i<body_end; ++i)
+  {
+    const simd_t in[3]={sx[i], sy[i], sz[i]};
+    simd::impl_::store_interleaved_(d+3*vc*i, in, components);
+  }
+  // the remaining triples one by one: xyz may be used beyond them
+  for(auto id=body_end*vc, id_end=std::min(i_end*vc, x.count());
+      id<id_end; ++id)
+  {
+    d[3*id+0]=x.cdata()[id];
+    d[3*id+1]=y.cdata()[id];
+    d[3*id+2]=z.cdata()[id];
   }
-  return horizontal_sum(accum);
 #endif
 }
 
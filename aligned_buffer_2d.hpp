@@ -0,0 +1,429 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef DIM_ALIGNED_BUFFER_2D_HPP
+#define DIM_ALIGNED_BUFFER_2D_HPP
+
+#include "aligned_buffer.hpp"
+
+namespace dim {
+
+template<typename T,
+         int Alignment=assumed_cacheline_size>
+class AlignedBuffer2D
+{
+public:
+
+  static constexpr auto alignment=Alignment;
+
+  static_assert((alignment%int(sizeof(T)))==0,
+                "alignment should be a multiple of value size");
+
+  AlignedBuffer2D()
+  : AlignedBuffer2D{0, 0}
+  {
+    // nothing more to be done
+  }
+
+  AlignedBuffer2D(std::ptrdiff_t width,
+                  std::ptrdiff_t height,
+                  BufferInit init=BufferInit::zero,
+                  BufferPages pages=BufferPages::standard)
+  : width_{width}
+  , height_{height}
+  // every row starts on an alignment boundary
+  , pitch_{(width*std::ptrdiff_t(sizeof(T))+alignment-1)/alignment*
+           alignment/std::ptrdiff_t(sizeof(T))}
+  , buffer_{pitch_*height, init, pages}
+  {
+    // nothing more to be done
+  }
+
+  std::ptrdiff_t
+  width() const
+  {
+    return width_;
+  }
+
+  std::ptrdiff_t
+  height() const
+  {
+    return height_;
+  }
+
+  std::ptrdiff_t // distance in values between two consecutive rows
+  pitch() const
+  {
+    return pitch_;
+  }
+
+  BufferBacking
+  backing() const
+  {
+    return buffer_.backing();
+  }
+
+  T *
+  data() DIM_ASSUME_ALIGNED(alignment)
+  {
+    return buffer_.data();
+  }
+
+  const T *
+  cdata() const DIM_ASSUME_ALIGNED(alignment)
+  {
+    return buffer_.cdata();
+  }
+
+  T *
+  row(std::ptrdiff_t y) DIM_ASSUME_ALIGNED(alignment)
+  {
+    return buffer_.data()+y*pitch_;
+  }
+
+  const T *
+  crow(std::ptrdiff_t y) const DIM_ASSUME_ALIGNED(alignment)
+  {
+    return buffer_.cdata()+y*pitch_;
+  }
+
+#if !DIM_ALIGNED_BUFFER_DISABLE_SIMD
+  using simd_t = typename AlignedBuffer<T, Alignment>::simd_t;
+
+  std::ptrdiff_t // simd vectors needed for one row
+  simd_width() const
+  {
+    return (width_+simd_t::value_count-1)/simd_t::value_count;
+  }
+
+  std::ptrdiff_t // distance in simd vectors between two consecutive rows
+  simd_pitch() const
+  {
+    return pitch_/simd_t::value_count;
+  }
+
+  simd_t *
+  simd_data() DIM_ASSUME_ALIGNED(alignment)
+  {
+    return buffer_.simd_data();
+  }
+
+  const simd_t *
+  simd_cdata() const DIM_ASSUME_ALIGNED(alignment)
+  {
+    return buffer_.simd_cdata();
+  }
+#endif
+
+private:
+  std::ptrdiff_t width_;
+  std::ptrdiff_t height_;
+  std::ptrdiff_t pitch_;
+  AlignedBuffer<T, Alignment> buffer_;
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// rows are shared out between the parts; as with AlignedBuffer, the
+// last simd vector of each row may overflow into the padding
+
+#if DIM_ALIGNED_BUFFER_DISABLE_SIMD
+# define DIM_ALIGNED_BUFFER_2D_ACCESS_DATA(id) \
+    auto * DIM_RESTRICT d##id=buffer##id.data(); \
+    const auto pitch##id=buffer##id.pitch();
+# define DIM_ALIGNED_BUFFER_2D_ACCESS_CDATA(id) \
+    const auto * DIM_RESTRICT d##id=buffer##id.cdata(); \
+    const auto pitch##id=buffer##id.pitch();
+# define DIM_ALIGNED_BUFFER_2D_ITERATE(call) \
+    const auto width=buffer1.width(); \
+    for(auto [y, y_end]=sequence_part(buffer1.height(), \
+                                      part_id, part_count); \
+        y<y_end; ++y) \
+    { \
+      for(auto i=std::ptrdiff_t{}; i<width; ++i) { call; } \
+    }
+#else
+# define DIM_ALIGNED_BUFFER_2D_ACCESS_DATA(id) \
+    auto * DIM_RESTRICT d##id=buffer##id.simd_data(); \
+    const auto pitch##id=buffer##id.simd_pitch(); \
+    using simd_t##id = typename std::decay_t<decltype(buffer##id)>::simd_t; \
+    static_assert(simd_t1::value_count==simd_t##id::value_count);
+# define DIM_ALIGNED_BUFFER_2D_ACCESS_CDATA(id) \
+    const auto * DIM_RESTRICT d##id=buffer##id.simd_cdata(); \
+    const auto pitch##id=buffer##id.simd_pitch(); \
+    using simd_t##id = typename std::decay_t<decltype(buffer##id)>::simd_t; \
+    static_assert(simd_t1::value_count==simd_t##id::value_count);
+# define DIM_ALIGNED_BUFFER_2D_ITERATE(call) \
+    const auto width=buffer1.simd_width(); \
+    for(auto [y, y_end]=sequence_part(buffer1.height(), \
+                                      part_id, part_count); \
+        y<y_end; ++y) \
+    { \
+      for(auto i=std::ptrdiff_t{}; i<width; ++i) { call; } \
+    }
+#endif
+
+template<typename T1,
+         typename Fnct>
+inline
+void
+apply0(int part_id, int part_count,
+       const AlignedBuffer2D<T1> &buffer1,
+       Fnct fnct)
+{
+  DIM_ALIGNED_BUFFER_2D_ACCESS_CDATA(1)
+  DIM_ALIGNED_BUFFER_2D_ITERATE(
+    fnct(d1[y*pitch1+i]))
+}
+
+template<typename T1,
+         typename T2,
+         typename Fnct>
+inline
+void
+apply0(int part_id, int part_count,
+       const AlignedBuffer2D<T1> &buffer1,
+       const AlignedBuffer2D<T2> &buffer2,
+       Fnct fnct)
+{
+  DIM_ALIGNED_BUFFER_2D_ACCESS_CDATA(1)
+  DIM_ALIGNED_BUFFER_2D_ACCESS_CDATA(2)
+  DIM_ALIGNED_BUFFER_2D_ITERATE(
+    fnct(d1[y*pitch1+i], d2[y*pitch2+i]))
+}
+
+template<typename T1,
+         typename T2,
+         typename T3,
+         typename Fnct>
+inline
+void
+apply0(int part_id, int part_count,
+       const AlignedBuffer2D<T1> &buffer1,
+       const AlignedBuffer2D<T2> &buffer2,
+       const AlignedBuffer2D<T3> &buffer3,
+       Fnct fnct)
+{
+  DIM_ALIGNED_BUFFER_2D_ACCESS_CDATA(1)
+  DIM_ALIGNED_BUFFER_2D_ACCESS_CDATA(2)
+  DIM_ALIGNED_BUFFER_2D_ACCESS_CDATA(3)
+  DIM_ALIGNED_BUFFER_2D_ITERATE(
+    fnct(d1[y*pitch1+i], d2[y*pitch2+i], d3[y*pitch3+i]))
+}
+
+template<typename T1,
+         typename Fnct>
+inline
+void
+apply1(AlignedBuffer2D<T1> &buffer1,
+       int part_id, int part_count,
+       Fnct fnct)
+{
+  DIM_ALIGNED_BUFFER_2D_ACCESS_DATA(1)
+  DIM_ALIGNED_BUFFER_2D_ITERATE(
+    fnct(d1[y*pitch1+i]))
+}
+
+template<typename T1,
+         typename T2,
+         typename Fnct>
+inline
+void
+apply1(AlignedBuffer2D<T1> &buffer1,
+       int part_id, int part_count,
+       const AlignedBuffer2D<T2> &buffer2,
+       Fnct fnct)
+{
+  DIM_ALIGNED_BUFFER_2D_ACCESS_DATA(1)
+  DIM_ALIGNED_BUFFER_2D_ACCESS_CDATA(2)
+  DIM_ALIGNED_BUFFER_2D_ITERATE(
+    fnct(d1[y*pitch1+i], d2[y*pitch2+i]))
+}
+
+template<typename T1,
+         typename T2,
+         typename T3,
+         typename Fnct>
+inline
+void
+apply1(AlignedBuffer2D<T1> &buffer1,
+       int part_id, int part_count,
+       const AlignedBuffer2D<T2> &buffer2,
+       const AlignedBuffer2D<T3> &buffer3,
+       Fnct fnct)
+{
+  DIM_ALIGNED_BUFFER_2D_ACCESS_DATA(1)
+  DIM_ALIGNED_BUFFER_2D_ACCESS_CDATA(2)
+  DIM_ALIGNED_BUFFER_2D_ACCESS_CDATA(3)
+  DIM_ALIGNED_BUFFER_2D_ITERATE(
+    fnct(d1[y*pitch1+i], d2[y*pitch2+i], d3[y*pitch3+i]))
+}
+
+template<typename T1,
+         typename T2,
+         typename Fnct>
+inline
+void
+apply2(AlignedBuffer2D<T1> &buffer1,
+       AlignedBuffer2D<T2> &buffer2,
+       int part_id, int part_count,
+       Fnct fnct)
+{
+  DIM_ALIGNED_BUFFER_2D_ACCESS_DATA(1)
+  DIM_ALIGNED_BUFFER_2D_ACCESS_DATA(2)
+  DIM_ALIGNED_BUFFER_2D_ITERATE(
+    fnct(d1[y*pitch1+i], d2[y*pitch2+i]))
+}
+
+template<typename T1,
+         typename T2,
+         typename T3,
+         typename Fnct>
+inline
+void
+apply2(AlignedBuffer2D<T1> &buffer1,
+       AlignedBuffer2D<T2> &buffer2,
+       int part_id, int part_count,
+       const AlignedBuffer2D<T3> &buffer3,
+       Fnct fnct)
+{
+  DIM_ALIGNED_BUFFER_2D_ACCESS_DATA(1)
+  DIM_ALIGNED_BUFFER_2D_ACCESS_DATA(2)
+  DIM_ALIGNED_BUFFER_2D_ACCESS_CDATA(3)
+  DIM_ALIGNED_BUFFER_2D_ITERATE(
+    fnct(d1[y*pitch1+i], d2[y*pitch2+i], d3[y*pitch3+i]))
+}
+
+#undef DIM_ALIGNED_BUFFER_2D_ACCESS_DATA
+#undef DIM_ALIGNED_BUFFER_2D_ACCESS_CDATA
+#undef DIM_ALIGNED_BUFFER_2D_ITERATE
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// since rows are aligned and padded, the first and last simd vectors of
+// a row section always lie in the same row, thus they are accessed with
+// aligned operations and masked instead of scalar prefix/suffix loops
+
+template<typename T>
+inline
+void
+fill(AlignedBuffer2D<T> &dst,
+     int part_id, int part_count,
+     std::ptrdiff_t x, std::ptrdiff_t y, std::ptrdiff_t w, std::ptrdiff_t h,
+     const T &value)
+{
+  if(w<=0)
+  {
+    return;
+  }
+#if DIM_ALIGNED_BUFFER_DISABLE_SIMD
+  for(auto [yid, yid_end]=sequence_part(y, y+h, part_id, part_count);
+      yid<yid_end; ++yid)
+  {
+    auto * DIM_RESTRICT d=dst.row(yid);
+    for(auto id=x, id_end=x+w; id<id_end; ++id)
+    {
+      d[id]=value;
+    }
+  }
+#else
+  using simd_t = typename AlignedBuffer2D<T>::simd_t;
+  constexpr auto vc=simd_t::value_count;
+  const auto simd_value=simd_t{value};
+  const auto first=x/vc, last=(x+w-1)/vc;
+  const auto first_lane=int(x%vc), last_lane=int((x+w-1)%vc+1);
+  const auto first_mask=
+    simd::lane_mask<simd_t>(first_lane, (first==last) ? last_lane : vc);
+  const auto last_mask=simd::lane_mask<simd_t>(0, last_lane);
+  for(auto [yid, yid_end]=sequence_part(y, y+h, part_id, part_count);
+      yid<yid_end; ++yid)
+  {
+    auto * DIM_RESTRICT d=dst.simd_data()+yid*dst.simd_pitch();
+    d[first]=select(first_mask, simd_value, d[first]);
+    for(auto i=first+1; i<last; ++i)
+    {
+      simd::store_a(d+i, simd_value);
+    }
+    if(last!=first)
+    {
+      d[last]=select(last_mask, simd_value, d[last]);
+    }
+  }
+#endif
+}
+
+template<typename T>
+inline
+void
+fill(AlignedBuffer2D<T> &dst,
+     int part_id, int part_count,
+     const T &value)
+{
+  fill(dst, part_id, part_count, 0, 0, dst.width(), dst.height(), value);
+}
+
+template<typename T>
+inline
+T
+sum(const AlignedBuffer2D<T> &buffer,
+    int part_id, int part_count,
+    std::ptrdiff_t x, std::ptrdiff_t y, std::ptrdiff_t w, std::ptrdiff_t h)
+{
+  if(w<=0)
+  {
+    return T{};
+  }
+#if DIM_ALIGNED_BUFFER_DISABLE_SIMD
+  auto accum=T{};
+  for(auto [yid, yid_end]=sequence_part(y, y+h, part_id, part_count);
+      yid<yid_end; ++yid)
+  {
+    const auto * DIM_RESTRICT p=buffer.crow(yid);
+    for(auto id=x, id_end=x+w; id<id_end; ++id)
+    {
+      accum+=p[id];
+    }
+  }
+  return accum;
+#else
+  using simd_t = typename AlignedBuffer2D<T>::simd_t;
+  constexpr auto vc=simd_t::value_count;
+  const auto zero=simd_t{};
+  const auto first=x/vc, last=(x+w-1)/vc;
+  const auto first_lane=int(x%vc), last_lane=int((x+w-1)%vc+1);
+  const auto first_mask=
+    simd::lane_mask<simd_t>(first_lane, (first==last) ? last_lane : vc);
+  const auto last_mask=simd::lane_mask<simd_t>(0, last_lane);
+  auto accum=simd_t{};
+  for(auto [yid, yid_end]=sequence_part(y, y+h, part_id, part_count);
+      yid<yid_end; ++yid)
+  {
+    const auto * DIM_RESTRICT p=buffer.simd_cdata()+yid*buffer.simd_pitch();
+    accum+=select(first_mask, simd::load_a(p+first), zero);
+    for(auto i=first+1; i<last; ++i)
+    {
+      accum+=simd::load_a(p+i);
+    }
+    if(last!=first)
+    {
+      accum+=select(last_mask, simd::load_a(p+last), zero);
+    }
+  }
+  return horizontal_sum(accum);
+#endif
+}
+
+template<typename T>
+inline
+T
+sum(const AlignedBuffer2D<T> &buffer,
+    int part_id, int part_count)
+{
+  return sum(buffer, part_id, part_count,
+             0, 0, buffer.width(), buffer.height());
+}
+
+} // namespace dim
+
+#endif // DIM_ALIGNED_BUFFER_2D_HPP
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -0,0 +1,510 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef DIM_AOSOA_HPP
+#define DIM_AOSOA_HPP
+
+#include "aligned_buffer.hpp"
+#include "simd_real3.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// AoSoA<RealType, VectorSize, Fields...> stores points as an array of
+// chunks, each of them holding value_count points (the lane count of a
+// simd vector) as a structure of arrays: x[], y[] and z[], which are
+// exposed in place as a simd::Real3, then one array per extra field.
+// Thus a kernel streams through the chunks with full simd vectors, while
+// all the data of a point stays within the same chunk.
+// The points are contiguous: index i is lane i%value_count of chunk
+// i/value_count; the lanes of the last chunk beyond count() are zero on
+// insertion but may be altered by the kernels, they are simply ignored.
+
+namespace dim {
+
+namespace impl_ {
+
+template<int VectorSize,
+         int ValueCount,
+         typename... Fields>
+inline constexpr
+auto // offset of each field array in a chunk, then chunk size
+aosoa_layout_()
+{
+  auto layout=std::array<std::ptrdiff_t, sizeof...(Fields)+1>{};
+  auto offset=std::ptrdiff_t{3*VectorSize}; // after x[], y[] and z[]
+  auto id=0;
+  const auto place=
+    [&](std::ptrdiff_t size)
+    {
+      // on the largest power of two dividing the array size (up to the
+      // vector size), so that it can be loaded as a simd vector when its
+      // size is suitable
+      auto align=std::ptrdiff_t{VectorSize};
+      while(size%align)
+      {
+        align/=2;
+      }
+      offset=(offset+align-1)/align*align;
+      layout[id++]=offset;
+      offset+=size;
+    };
+  (place(ValueCount*std::ptrdiff_t(sizeof(Fields))), ...);
+  (void)place; // no fields
+  layout[id]=(offset+VectorSize-1)/VectorSize*VectorSize;
+  return layout;
+}
+
+} // namespace impl_
+
+template<typename RealType,
+         int VectorSize=simd::max_vector_size,
+         typename... Fields>
+class AoSoA
+{
+public:
+
+  using real_t = RealType;
+  using simd_t = simd::simd_t<real_t, VectorSize>;
+  using real3_t = simd::Real3<simd_t>;
+  using mask_t = typename simd_t::mask_type;
+
+  template<int I>
+  using field_t = std::tuple_element_t<I, std::tuple<Fields...>>;
+
+  static_assert(std::is_floating_point_v<real_t>,
+                "floating point expected for template type");
+
+  static_assert(((std::is_standard_layout_v<Fields>&&
+                  std::is_trivial_v<Fields>)&&...),
+                "plain-old-data fields expected");
+
+  static_assert(sizeof(real3_t)==3*VectorSize,
+                "unexpected simd::Real3 layout");
+
+  static constexpr auto value_count=simd_t::value_count; // per chunk
+  static constexpr auto field_count=int(sizeof...(Fields));
+  static constexpr auto alignment=std::max(assumed_cacheline_size,
+                                           VectorSize);
+
+  // offset in bytes of each field array in a chunk, then chunk size
+  static constexpr auto layout=
+    impl_::aosoa_layout_<VectorSize, value_count, Fields...>();
+
+  static constexpr auto chunk_size=layout[field_count];
+
+  AoSoA()
+  : AoSoA{0}
+  {
+    // nothing more to be done
+  }
+
+  explicit
+  AoSoA(std::ptrdiff_t count, // zero points
+        BufferPages pages=BufferPages::standard)
+  : count_{}
+  , pages_{pages}
+  , buffer_{}
+  {
+    resize(count);
+  }
+
+  std::ptrdiff_t // number of points
+  count() const
+  {
+    return count_;
+  }
+
+  std::ptrdiff_t // number of chunks, the last one may be incomplete
+  chunk_count() const
+  {
+    return (count_+value_count-1)/value_count;
+  }
+
+  std::ptrdiff_t // number of points storable without reallocation
+  capacity() const
+  {
+    return buffer_.count()/chunk_size*value_count;
+  }
+
+  int // number of actual points in a chunk
+  chunk_value_count(std::ptrdiff_t chunk_id) const
+  {
+    return int(std::min(std::ptrdiff_t{value_count},
+                        count_-chunk_id*value_count));
+  }
+
+  mask_t // lanes of a chunk holding actual points
+  chunk_mask(std::ptrdiff_t chunk_id) const
+  {
+    return simd::lane_mask<mask_t>(0, chunk_value_count(chunk_id));
+  }
+
+  real3_t &
+  chunk(std::ptrdiff_t chunk_id)
+  {
+    return *reinterpret_cast<real3_t *>(chunk_(chunk_id));
+  }
+
+  const real3_t &
+  cchunk(std::ptrdiff_t chunk_id) const
+  {
+    return *reinterpret_cast<const real3_t *>(cchunk_(chunk_id));
+  }
+
+  template<int I>
+  field_t<I> * // the value_count values of a field in a chunk
+  field(std::ptrdiff_t chunk_id)
+  {
+    return reinterpret_cast<field_t<I> *>(chunk_(chunk_id)+layout[I]);
+  }
+
+  template<int I>
+  const field_t<I> *
+  cfield(std::ptrdiff_t chunk_id) const
+  {
+    return reinterpret_cast<const field_t<I> *>(
+      cchunk_(chunk_id)+layout[I]);
+  }
+
+  auto // tuple of the pointers to the field arrays of a chunk
+  fields(std::ptrdiff_t chunk_id)
+  {
+    return fields_(chunk_id,
+                   std::make_integer_sequence<int, field_count>{});
+  }
+
+  dim::Real3<real_t>
+  position(std::ptrdiff_t id) const
+  {
+    const auto &c=cchunk(id/value_count);
+    const auto lane=int(id%value_count);
+    return {c.x[lane], c.y[lane], c.z[lane]};
+  }
+
+  void
+  set_position(std::ptrdiff_t id,
+               const dim::Real3<real_t> &p)
+  {
+    auto *c=reinterpret_cast<real_t *>(chunk_(id/value_count));
+    const auto lane=id%value_count;
+    c[0*value_count+lane]=p.x;
+    c[1*value_count+lane]=p.y;
+    c[2*value_count+lane]=p.z;
+  }
+
+  template<int I>
+  field_t<I> &
+  value(std::ptrdiff_t id)
+  {
+    return field<I>(id/value_count)[id%value_count];
+  }
+
+  template<int I>
+  const field_t<I> &
+  cvalue(std::ptrdiff_t id) const
+  {
+    return cfield<I>(id/value_count)[id%value_count];
+  }
+
+  void // capacity becomes at least count points (never shrinks)
+  reserve(std::ptrdiff_t count)
+  {
+    if(count<=capacity())
+    {
+      return;
+    }
+    const auto chunks=(count+value_count-1)/value_count;
+    auto buffer=AlignedBuffer<unsigned char, alignment>{
+      chunks*chunk_size, BufferInit::zero, pages_};
+    if(const auto used=chunk_count()*chunk_size; used)
+    {
+      std::memcpy(buffer.data(), buffer_.cdata(), std::size_t(used));
+    }
+    buffer_=std::move(buffer);
+  }
+
+  void // the new points are zero
+  resize(std::ptrdiff_t count)
+  {
+    if(count>capacity())
+    {
+      reserve(count);
+    }
+    // the lanes beyond count_ may hold anything (erase_if(), apply()...)
+    if(count<count_)
+    {
+      clear_(count, count_);
+    }
+    else
+    {
+      clear_(count_, count);
+    }
+    count_=count;
+  }
+
+  void
+  clear()
+  {
+    resize(0);
+  }
+
+  std::ptrdiff_t // index of the new point
+  push_back(const dim::Real3<real_t> &p,
+            const Fields &... values)
+  {
+    if(count_==capacity())
+    {
+      // doubling amortises the copies
+      reserve(std::max(2*count_, std::ptrdiff_t{value_count}));
+    }
+    const auto id=count_++;
+    set_position(id, p);
+    for_each_field_(
+      [&](auto field_id, const auto &f)
+      {
+        value<decltype(field_id)::value>(id)=f;
+      }, values...);
+    return id;
+  }
+
+  void // the last point fills the hole (the order is not preserved)
+  erase(std::ptrdiff_t id)
+  {
+    const auto last=--count_;
+    if(id!=last)
+    {
+      set_position(id, position(last));
+      for_each_field_(
+        [&](auto field_id)
+        {
+          constexpr auto i=decltype(field_id)::value;
+          value<i>(id)=value<i>(last);
+        });
+    }
+    clear_(last, last+1);
+  }
+
+  // The points for which pred() sets a lane are erased and the remaining
+  // ones are packed at the beginning, keeping their order.  pred() receives
+  // a chunk (simd::Real3, then a pointer to each field) and returns a mask
+  // of the points to be erased; the lanes beyond count() are ignored.
+  // This is a sequential operation (each chunk moves down to the first
+  // hole), thus it should be called once all the parts are done.
+
+  template<typename Pred>
+  std::ptrdiff_t // number of erased points
+  erase_if(Pred pred)
+  {
+    // the kept values of each chunk are appended to a two-chunk staging
+    // area, whose first chunk is flushed as soon as it is complete
+    alignas(alignment) unsigned char stage[2*chunk_size];
+    auto *sx=reinterpret_cast<real_t *>(stage);
+    auto *sy=sx+2*value_count;
+    auto *sz=sy+2*value_count;
+    const auto stage_field=
+      [&](auto field_id)
+      {
+        constexpr auto i=decltype(field_id)::value;
+        return reinterpret_cast<field_t<i> *>(stage+2*layout[i]);
+      };
+    const auto chunks=chunk_count();
+    auto staged=0;
+    auto out=std::ptrdiff_t{};
+    const auto flush=
+      [&](int n)
+      {
+        auto &d=chunk(out);
+        d.x=simd::load_a(reinterpret_cast<const simd_t *>(sx));
+        d.y=simd::load_a(reinterpret_cast<const simd_t *>(sy));
+        d.z=simd::load_a(reinterpret_cast<const simd_t *>(sz));
+        for_each_field_(
+          [&](auto field_id)
+          {
+            constexpr auto i=decltype(field_id)::value;
+            std::memcpy(field<i>(out), stage_field(field_id),
+                        sizeof(field_t<i>)*value_count);
+          });
+        ++out;
+        // what exceeds a chunk moves to the beginning of the stage
+        const auto excess=n-value_count;
+        if(excess>0)
+        {
+          const auto move=
+            [&](auto *s)
+            {
+              std::memmove(s, s+value_count, sizeof(*s)*std::size_t(excess));
+            };
+          move(sx);
+          move(sy);
+          move(sz);
+          for_each_field_(
+            [&](auto field_id)
+            {
+              move(stage_field(field_id));
+            });
+        }
+      };
+    for(auto c=std::ptrdiff_t{}; c<chunks; ++c)
+    {
+      const auto &s=cchunk(c);
+      const auto keep=mask_t{~mask_t{std::apply(
+        [&](auto... f)
+        {
+          return pred(s, f...);
+        }, fields(c))}}&chunk_mask(c);
+      const auto bits=simd::movemask(keep);
+      simd::compress_store(sx+staged, s.x, keep);
+      simd::compress_store(sy+staged, s.y, keep);
+      simd::compress_store(sz+staged, s.z, keep);
+      for_each_field_(
+        [&](auto field_id)
+        {
+          constexpr auto i=decltype(field_id)::value;
+          const auto *f=cfield<i>(c);
+          auto *d=stage_field(field_id)+staged;
+          auto n=0;
+          for(auto lane=0; lane<value_count; ++lane)
+          {
+            d[n]=f[lane]; // no branch: overwritten if not kept
+            n+=int((bits>>lane)&1u);
+          }
+        });
+      staged+=simd::count_true(keep);
+      if(staged>=value_count)
+      {
+        flush(staged);
+        staged-=value_count;
+      }
+    }
+    const auto erased=count_-(out*value_count+staged);
+    if(staged)
+    {
+      // the unused lanes of the stage are uninitialised
+      const auto zero=
+        [&](auto *s)
+        {
+          std::fill(s+staged, s+value_count,
+                    std::remove_pointer_t<decltype(s)>{});
+        };
+      zero(sx);
+      zero(sy);
+      zero(sz);
+      for_each_field_(
+        [&](auto field_id)
+        {
+          zero(stage_field(field_id));
+        });
+      flush(staged);
+    }
+    const auto old_count=count_;
+    count_-=erased;
+    clear_(count_, old_count);
+    return erased;
+  }
+
+private:
+
+  unsigned char *
+  chunk_(std::ptrdiff_t chunk_id) DIM_ASSUME_ALIGNED(VectorSize)
+  {
+    return buffer_.data()+chunk_id*chunk_size;
+  }
+
+  const unsigned char *
+  cchunk_(std::ptrdiff_t chunk_id) const DIM_ASSUME_ALIGNED(VectorSize)
+  {
+    return buffer_.cdata()+chunk_id*chunk_size;
+  }
+
+  template<typename Fnct,
+           typename... Args>
+  static
+  void // fnct(integral_constant<I>, args[I]...) for each field
+  for_each_field_(Fnct fnct,
+                  const Args &... args)
+  {
+    for_each_field_(fnct, std::make_integer_sequence<int, field_count>{},
+                    args...);
+  }
+
+  template<typename Fnct,
+           int... I,
+           typename... Args>
+  static
+  void
+  for_each_field_(Fnct fnct,
+                  std::integer_sequence<int, I...>,
+                  const Args &... args)
+  {
+    if constexpr(sizeof...(Args)==0)
+    {
+      (fnct(std::integral_constant<int, I>{}), ...);
+    }
+    else
+    {
+      (fnct(std::integral_constant<int, I>{}, args), ...);
+    }
+  }
+
+  template<int... I>
+  auto
+  fields_([[maybe_unused]] std::ptrdiff_t chunk_id, // if no field
+          std::integer_sequence<int, I...>)
+  {
+    return std::make_tuple(field<I>(chunk_id)...);
+  }
+
+  void // zero the points in [first, last)
+  clear_(std::ptrdiff_t first,
+         std::ptrdiff_t last)
+  {
+    for(auto id=first; id<last; ++id)
+    {
+      set_position(id, dim::Real3<real_t>{});
+      for_each_field_(
+        [&](auto field_id)
+        {
+          value<decltype(field_id)::value>(id)={};
+        });
+    }
+  }
+
+  std::ptrdiff_t count_;
+  BufferPages pages_;
+  AlignedBuffer<unsigned char, alignment> buffer_;
+};
+
+// fnct(simd::Real3 &, Fields *...) is called on each chunk of the slice
+// processed by a part; the last chunk may be incomplete (see chunk_mask())
+
+template<typename RealType,
+         int VectorSize,
+         typename... Fields,
+         typename Fnct>
+inline
+void
+apply(AoSoA<RealType, VectorSize, Fields...> &points,
+      int part_id, int part_count,
+      Fnct fnct)
+{
+  for(auto [c, c_end]=sequence_part(points.chunk_count(),
+                                    part_id, part_count);
+      c<c_end; ++c)
+  {
+    std::apply(
+      [&](auto... f)
+      {
+        fnct(points.chunk(c), f...);
+      }, points.fields(c));
+  }
+}
+
+} // namespace dim
+
+#endif // DIM_AOSOA_HPP
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
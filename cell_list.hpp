@@ -0,0 +1,446 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef DIM_CELL_LIST_HPP
+#define DIM_CELL_LIST_HPP
+
+#include "aligned_buffer.hpp"
+#include "real3.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// CellList bins points, given as x, y and z AlignedBuffer, into a uniform
+// grid of cells at least cutoff+skin wide, so that the neighbours of a
+// point within cutoff are in the 27 surrounding cells.
+// The cells are ordered x first, then y, then z, and a counting sort
+// stores their points contiguously (as a structure of arrays), thus the
+// three cells along x around a cell form a single range which is tested
+// with full simd vectors.
+// The points outside the bounds are put in the border cells, which is
+// correct but slower if there are many of them.
+// As long as no point has moved more than skin/2 since the last build,
+// update() only refreshes the sorted positions (see Verlet lists).
+
+namespace dim {
+
+template<typename RealType,
+         int VectorSize=default_vector_size>
+class CellList
+{
+public:
+
+  using real_t = RealType;
+
+  static_assert(std::is_floating_point_v<real_t>,
+                "floating point expected for template type");
+
+  CellList(std::ptrdiff_t count, // number of points
+           const Real3<real_t> &lower,
+           const Real3<real_t> &upper,
+           real_t cutoff,
+           real_t skin=real_t{})
+  : count_{count}
+  , cutoff_{cutoff}
+  , skin_{skin}
+  , lower_{lower}
+  , dims_{grid_dims_(count, upper-lower, cutoff+skin)}
+  , inv_size_{cell_inv_size_(dims_[0], upper.x-lower.x),
+              cell_inv_size_(dims_[1], upper.y-lower.y),
+              cell_inv_size_(dims_[2], upper.z-lower.z)}
+  , cell_count_{std::ptrdiff_t{dims_[0]}*dims_[1]*dims_[2]}
+  , fill_count_{std::make_unique<std::atomic<std::ptrdiff_t>[]>(
+                std::size_t(cell_count_))}
+  , cell_start_{cell_count_+1}
+  , cell_{count}
+  , rank_{count}
+  , index_{count}
+  , x_{count+scan_padding_}
+  , y_{count+scan_padding_}
+  , z_{count+scan_padding_}
+  , ref_x_{count}, ref_y_{count}, ref_z_{count}
+  {
+    // nothing more to be done
+  }
+
+  std::ptrdiff_t
+  count() const
+  {
+    return count_;
+  }
+
+  std::ptrdiff_t
+  cell_count() const
+  {
+    return cell_count_;
+  }
+
+  real_t
+  cutoff() const
+  {
+    return cutoff_;
+  }
+
+  real_t
+  skin() const
+  {
+    return skin_;
+  }
+
+  // A build consists in three steps; each of them must be done by every
+  // part before the next one starts (bin() and fill() share the points
+  // out, index() runs in a single thread).
+  // With several parts, the order of the points within a cell depends on
+  // the scheduling.
+
+  void // step 1: count the points in each cell, and rank them
+  bin(const AlignedBuffer<real_t> &x,
+      const AlignedBuffer<real_t> &y,
+      const AlignedBuffer<real_t> &z,
+      int part_id, int part_count)
+  {
+    const auto * DIM_RESTRICT px=x.cdata();
+    const auto * DIM_RESTRICT py=y.cdata();
+    const auto * DIM_RESTRICT pz=z.cdata();
+    auto * DIM_RESTRICT cell=cell_.data();
+    auto * DIM_RESTRICT rank=rank_.data();
+    for(auto [i, i_end]=sequence_part(count_, part_id, part_count);
+        i<i_end; ++i)
+    {
+      const auto c=cell_id_(px[i], py[i], pz[i]);
+      cell[i]=c;
+      rank[i]=fill_count_[c].fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  void // step 2: place the cells (single thread)
+  index()
+  {
+    auto *start=cell_start_.data();
+    auto offset=std::ptrdiff_t{};
+    for(auto c=std::ptrdiff_t{}; c<cell_count_; ++c)
+    {
+      start[c]=offset;
+      // reset for the next build
+      offset+=fill_count_[c].exchange(0, std::memory_order_relaxed);
+    }
+    start[cell_count_]=offset;
+  }
+
+  void // step 3: store the points in their cell
+  fill(const AlignedBuffer<real_t> &x,
+       const AlignedBuffer<real_t> &y,
+       const AlignedBuffer<real_t> &z,
+       int part_id, int part_count)
+  {
+    const auto * DIM_RESTRICT px=x.cdata();
+    const auto * DIM_RESTRICT py=y.cdata();
+    const auto * DIM_RESTRICT pz=z.cdata();
+    const auto * DIM_RESTRICT cell=cell_.cdata();
+    const auto * DIM_RESTRICT rank=rank_.cdata();
+    const auto * DIM_RESTRICT start=cell_start_.cdata();
+    auto * DIM_RESTRICT index=index_.data();
+    auto * DIM_RESTRICT sx=x_.data();
+    auto * DIM_RESTRICT sy=y_.data();
+    auto * DIM_RESTRICT sz=z_.data();
+    auto * DIM_RESTRICT rx=ref_x_.data();
+    auto * DIM_RESTRICT ry=ref_y_.data();
+    auto * DIM_RESTRICT rz=ref_z_.data();
+    for(auto [i, i_end]=sequence_part(count_, part_id, part_count);
+        i<i_end; ++i)
+    {
+      // no atomic operation here: it would wait for the previous stores,
+      // which are mostly cache misses
+      const auto s=start[cell[i]]+rank[i];
+      index[s]=i;
+      sx[s]=rx[s]=px[i];
+      sy[s]=ry[s]=py[i];
+      sz[s]=rz[s]=pz[i];
+    }
+  }
+
+  void // the three steps in the calling thread
+  build(const AlignedBuffer<real_t> &x,
+        const AlignedBuffer<real_t> &y,
+        const AlignedBuffer<real_t> &z)
+  {
+    bin(x, y, z, 0, 1);
+    index();
+    fill(x, y, z, 0, 1);
+  }
+
+  bool // false if a point of the part moved beyond skin/2 (build again)
+  update(const AlignedBuffer<real_t> &x,
+         const AlignedBuffer<real_t> &y,
+         const AlignedBuffer<real_t> &z,
+         int part_id, int part_count)
+  {
+    const auto * DIM_RESTRICT px=x.cdata();
+    const auto * DIM_RESTRICT py=y.cdata();
+    const auto * DIM_RESTRICT pz=z.cdata();
+    const auto * DIM_RESTRICT index=index_.cdata();
+    auto * DIM_RESTRICT sx=x_.data();
+    auto * DIM_RESTRICT sy=y_.data();
+    auto * DIM_RESTRICT sz=z_.data();
+    const auto * DIM_RESTRICT rx=ref_x_.cdata();
+    const auto * DIM_RESTRICT ry=ref_y_.cdata();
+    const auto * DIM_RESTRICT rz=ref_z_.cdata();
+    auto max_sqr_move=real_t{};
+    for(auto [s, s_end]=sequence_part(count_, part_id, part_count);
+        s<s_end; ++s)
+    {
+      const auto i=index[s];
+      sx[s]=px[i];
+      sy[s]=py[i];
+      sz[s]=pz[i];
+      const auto dx=sx[s]-rx[s], dy=sy[s]-ry[s], dz=sz[s]-rz[s];
+      max_sqr_move=std::max(max_sqr_move, dx*dx+dy*dy+dz*dz);
+    }
+    return max_sqr_move<=skin_*skin_/4;
+  }
+
+  // fnct(i, j, sqr_distance) is called once for each pair of points
+  // closer than cutoff (i and j are their indices in x, y and z); the
+  // parts share out the points.
+
+  template<typename Fnct>
+  void
+  for_each_pair(int part_id, int part_count,
+                Fnct fnct) const
+  {
+    const auto * DIM_RESTRICT sx=x_.cdata();
+    const auto * DIM_RESTRICT sy=y_.cdata();
+    const auto * DIM_RESTRICT sz=z_.cdata();
+    const auto * DIM_RESTRICT index=index_.cdata();
+    const auto [s_begin, s_end]=sequence_part(count_, part_id, part_count);
+    auto cell=std::ptrdiff_t{-1};
+    std::ptrdiff_t ranges[5][2];
+    auto range_count=0;
+    for(auto s=s_begin; s<s_end; ++s)
+    {
+      if(s>=cell_start_.cdata()[cell+1]) // entering another cell
+      {
+        cell=cell_of_sorted_(s);
+        // the cells following this one (rows dz>0, or dz==0 and dy>=0),
+        // the pairs with points of the previous ones being already seen
+        range_count=0;
+        const int rows[5][2]={{0, 0}, {1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+        for(const auto &[dy, dz]: rows)
+        {
+          if(auto r=row_range_(cell, dy, dz); r[0]<r[1])
+          {
+            ranges[range_count][0]=r[0];
+            ranges[range_count][1]=r[1];
+            ++range_count;
+          }
+        }
+      }
+      const auto p=Real3<real_t>{sx[s], sy[s], sz[s]};
+      const auto i=index[s];
+      for(auto r=0; r<range_count; ++r)
+      {
+        // within the first row, only the points after this one
+        const auto first=r ? ranges[r][0] : s+1;
+        scan_(p, first, ranges[r][1],
+          [&](std::ptrdiff_t j, real_t sqr_distance)
+          {
+            fnct(i, j, sqr_distance);
+          });
+      }
+    }
+  }
+
+  // fnct(j, sqr_distance) is called for each point closer than cutoff to
+  // p (including the point itself if p is one of them)
+
+  template<typename Fnct>
+  void
+  for_each_neighbour(const Real3<real_t> &p,
+                     Fnct fnct) const
+  {
+    const auto cell=cell_id_(p.x, p.y, p.z);
+    for(auto dz=-1; dz<=1; ++dz)
+    {
+      for(auto dy=-1; dy<=1; ++dy)
+      {
+        if(const auto r=row_range_(cell, dy, dz); r[0]<r[1])
+        {
+          scan_(p, r[0], r[1], fnct);
+        }
+      }
+    }
+  }
+
+  void // indices of the points closer than cutoff to p, appended to list
+  neighbours(const Real3<real_t> &p,
+             std::vector<std::ptrdiff_t> &list) const
+  {
+    for_each_neighbour(p,
+      [&](std::ptrdiff_t j, real_t)
+      {
+        list.push_back(j);
+      });
+  }
+
+private:
+
+  static
+  std::array<int, 3>
+  grid_dims_(std::ptrdiff_t count,
+             const Real3<real_t> &extent,
+             real_t min_size)
+  {
+    const auto dim=
+      [&](real_t e)
+      {
+        const auto n=min_size>real_t{} ? std::floor(e/min_size) : real_t{1};
+        return int(std::clamp(n, real_t{1}, real_t{1<<20}));
+      };
+    auto dims=std::array<int, 3>{dim(extent.x), dim(extent.y), dim(extent.z)};
+    // far more cells than points would only waste memory and time, so
+    // larger cells are used (still correct, just more distance tests)
+    const auto max_cells=std::max(std::ptrdiff_t{1}, 2*count);
+    while(std::ptrdiff_t{dims[0]}*dims[1]*dims[2]>max_cells)
+    {
+      auto &d=*std::max_element(begin(dims), end(dims));
+      d=(d+1)/2;
+    }
+    return dims;
+  }
+
+  static
+  real_t
+  cell_inv_size_(int dim,
+                 real_t extent)
+  {
+    return extent>real_t{} ? real_t(dim)/extent : real_t{};
+  }
+
+  std::ptrdiff_t
+  cell_id_(real_t x,
+           real_t y,
+           real_t z) const
+  {
+    const auto coord=
+      [&](real_t v, real_t lower, real_t inv_size, int dim)
+      {
+        // clamped as real values first, to avoid any integer overflow
+        const auto c=std::clamp((v-lower)*inv_size,
+                                real_t{}, real_t(dim-1));
+        return std::ptrdiff_t(c);
+      };
+    return (coord(z, lower_.z, inv_size_.z, dims_[2])*dims_[1]+
+            coord(y, lower_.y, inv_size_.y, dims_[1]))*dims_[0]+
+           coord(x, lower_.x, inv_size_.x, dims_[0]);
+  }
+
+  std::ptrdiff_t // cell holding the sorted point s
+  cell_of_sorted_(std::ptrdiff_t s) const
+  {
+    const auto *start=cell_start_.cdata();
+    // first cell starting after s, minus one
+    return std::upper_bound(start, start+cell_count_+1, s)-start-1;
+  }
+
+  std::array<std::ptrdiff_t, 2> // sorted points of cells x-1, x, x+1
+  row_range_(std::ptrdiff_t cell,
+             int dy,
+             int dz) const
+  {
+    const auto cx=int(cell%dims_[0]);
+    const auto cy=int(cell/dims_[0]%dims_[1])+dy;
+    const auto cz=int(cell/dims_[0]/dims_[1])+dz;
+    if((cy<0)||(cy>=dims_[1])||(cz<0)||(cz>=dims_[2]))
+    {
+      return {0, 0};
+    }
+    const auto row=(std::ptrdiff_t{cz}*dims_[1]+cy)*dims_[0];
+    const auto *start=cell_start_.cdata();
+    return {start[row+std::max(cx-1, 0)],
+            start[row+std::min(cx+1, dims_[0]-1)+1]};
+  }
+
+  template<typename Fnct>
+  void // fnct(j, sqr_distance) for the sorted points [first, last) closer
+       // than cutoff to p
+  scan_(const Real3<real_t> &p,
+        std::ptrdiff_t first,
+        std::ptrdiff_t last,
+        Fnct &&fnct) const
+  {
+    const auto * DIM_RESTRICT sx=x_.cdata();
+    const auto * DIM_RESTRICT sy=y_.cdata();
+    const auto * DIM_RESTRICT sz=z_.cdata();
+    const auto * DIM_RESTRICT index=index_.cdata();
+    const auto sqr_cutoff=cutoff_*cutoff_;
+#if DIM_ALIGNED_BUFFER_DISABLE_SIMD
+    for(auto s=first; s<last; ++s)
+    {
+      const auto dx=sx[s]-p.x, dy=sy[s]-p.y, dz=sz[s]-p.z;
+      if(const auto d2=dx*dx+dy*dy+dz*dz; d2<sqr_cutoff)
+      {
+        fnct(index[s], d2);
+      }
+    }
+#else
+    using simd_t = simd::simd_t<real_t, VectorSize>;
+    using mask_t = typename simd_t::mask_type;
+    constexpr auto vc=simd_t::value_count;
+    const auto px=simd_t{p.x}, py=simd_t{p.y}, pz=simd_t{p.z};
+    // the last vector may read beyond the points, but x_, y_ and z_ hold
+    // scan_padding_ more values (AlignedBuffer itself may pad a single one)
+    for(auto s=first; s<last; s+=vc)
+    {
+      const auto dx=simd::load_u(reinterpret_cast<const simd_t *>(sx+s))-px;
+      const auto dy=simd::load_u(reinterpret_cast<const simd_t *>(sy+s))-py;
+      const auto dz=simd::load_u(reinterpret_cast<const simd_t *>(sz+s))-pz;
+      const auto d2=dx*dx+dy*dy+dz*dz;
+      auto mask=mask_t{d2<sqr_cutoff};
+      if(last-s<vc)
+      {
+        mask=mask&simd::lane_mask<simd_t>(0, int(last-s));
+      }
+      for(auto bits=std::uint64_t(simd::movemask(mask));
+          bits; bits&=bits-1)
+      {
+        const auto lane=__builtin_ctzll(bits);
+        fnct(index[s+lane], d2[lane]);
+      }
+    }
+#endif
+  }
+
+#if DIM_ALIGNED_BUFFER_DISABLE_SIMD
+  static constexpr auto scan_padding_=std::ptrdiff_t{};
+#else
+  // the last vector of scan_() may start at the last point
+  static constexpr auto scan_padding_=std::ptrdiff_t{
+    simd::simd_t<real_t, VectorSize>::value_count-1};
+#endif
+
+  std::ptrdiff_t count_;
+  real_t cutoff_;
+  real_t skin_;
+  Real3<real_t> lower_;
+  std::array<int, 3> dims_;
+  Real3<real_t> inv_size_;
+  std::ptrdiff_t cell_count_;
+  std::unique_ptr<std::atomic<std::ptrdiff_t>[]> fill_count_;
+  AlignedBuffer<std::ptrdiff_t> cell_start_; // first sorted point of cells
+  AlignedBuffer<std::ptrdiff_t> cell_;       // cell of each point
+  AlignedBuffer<std::ptrdiff_t> rank_;       // place in its cell
+  AlignedBuffer<std::ptrdiff_t> index_;      // point of each sorted point
+  AlignedBuffer<real_t> x_, y_, z_;          // sorted positions
+  AlignedBuffer<real_t> ref_x_, ref_y_, ref_z_; // same at the last build
+};
+
+} // namespace dim
+
+#endif // DIM_CELL_LIST_HPP
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -12,8 +12,10 @@
 # endif
 # include <windows.h>
 #else
+# include <cstddef> // size_t is required by some system headers
 # if defined __linux__
 #  include <linux/sysctl.h>
+#  include <sched.h>
 # else
 #  include <sys/sysctl.h>
 # endif
@@ -281,6 +283,21 @@ bind_current_thread(CpuId cpu)
   return false;
 }
 
+inline
+CpuId // cpu currently running the calling thread, -1 if unknown
+current_cpu()
+{
+#if defined __linux__
+  return CpuId{::sched_getcpu()};
+#elif defined _WIN32
+  PROCESSOR_NUMBER number;
+  ::GetCurrentProcessorNumberEx(&number);
+  return CpuId{64*int(number.Group)+int(number.Number)};
+#else
+  return CpuId{};
+#endif
+}
+
 namespace impl_ {
 
 #if defined CTL_HW
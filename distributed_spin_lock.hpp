@@ -0,0 +1,226 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef DIM_DISTRIBUTED_SPIN_LOCK_HPP
+#define DIM_DISTRIBUTED_SPIN_LOCK_HPP
+
+#include "cpu_platform.hpp"
+#include "synchro.hpp"
+#include "utils.hpp"
+
+#include <memory>
+#include <atomic>
+#include <algorithm>
+
+// DistributedSpinLock offers the same operations as SpinLock, but the
+// readers are counted in distinct slots (one cacheline each), one per cpu
+// or one per numa node of a cpu::Platform, thus the readers on distinct
+// slots never write to the same cacheline (see brlock): read-mostly data
+// scales with the number of readers, while a writer has to inspect every
+// slot.
+// A reader chooses its slot with reader_slot(), from the cpu it is bound
+// to (the cpu index of a Team part is part_id%platform.cpu_count()) or
+// from the cpu currently running it, then gives the same slot to all the
+// operations until unlock_r() (even if it has migrated meanwhile).
+// As with SpinLock, a writer waits until there are no more readers, and
+// two readers which upgrade() at the same time wait for each other.
+
+namespace dim {
+
+class DistributedSpinLock
+{
+public:
+
+  explicit
+  DistributedSpinLock(const cpu::Platform &platform,
+                      bool per_numa=false) // one slot per numa node
+  : slot_count_{per_numa ? platform.numa_count() : platform.cpu_count()}
+  , cpu_slots_{std::make_unique<int[]>(platform.cpu_count())}
+  , sys_slot_count_{}
+  , sys_slots_{}
+  , readers_{std::make_unique<Slot_[]>(slot_count_)}
+  , writer_{}
+  {
+    for(auto cpu=0; cpu<platform.cpu_count(); ++cpu)
+    {
+      cpu_slots_[cpu]=per_numa ? std::max(0, platform.numa(cpu)) : cpu;
+      sys_slot_count_=std::max(sys_slot_count_, platform.cpu_id(cpu).id+1);
+    }
+    sys_slots_=std::make_unique<int[]>(sys_slot_count_);
+    for(auto cpu=0; cpu<platform.cpu_count(); ++cpu)
+    {
+      if(const auto sys_id=platform.cpu_id(cpu).id; sys_id>=0)
+      {
+        sys_slots_[sys_id]=cpu_slots_[cpu];
+      }
+    }
+  }
+
+  DistributedSpinLock(const DistributedSpinLock &) =delete;
+  DistributedSpinLock & operator=(const DistributedSpinLock &) =delete;
+  DistributedSpinLock(DistributedSpinLock &&) =delete;
+  DistributedSpinLock & operator=(DistributedSpinLock &&) =delete;
+
+  int
+  slot_count() const
+  {
+    return slot_count_;
+  }
+
+  int // slot for a reader bound to this cpu index
+  reader_slot(int cpu_index) const
+  {
+    return cpu_slots_[cpu_index];
+  }
+
+  int // slot for the cpu currently running the calling thread
+  reader_slot() const
+  {
+    const auto sys_id=cpu::current_cpu().id;
+    return (sys_id>=0)&&(sys_id<sys_slot_count_) ? sys_slots_[sys_id] : 0;
+  }
+
+  bool // success
+  try_lock_w()
+  {
+    auto expected=false;
+    if(!writer_.compare_exchange_weak(expected, true,
+                                      std::memory_order_seq_cst,
+                                      std::memory_order_relaxed))
+    {
+      return false;
+    }
+    // sequentially consistent, as in try_lock_r(), so that either the
+    // reader sees the writer or the writer sees the reader
+    if(reader_count_()!=0)
+    {
+      writer_.store(false, std::memory_order_release);
+      return false;
+    }
+    return true;
+  }
+
+  void
+  lock_w()
+  {
+    while(!try_lock_w())
+    {
+      while(writer_.load(std::memory_order_relaxed)||
+            (reader_count_(std::memory_order_relaxed)!=0))
+      {
+        impl_::cpu_pause_();
+      }
+    }
+  }
+
+  void
+  unlock_w()
+  {
+    writer_.store(false, std::memory_order_release);
+  }
+
+  bool // success
+  try_lock_r(int slot)
+  {
+    // a writer is seen before touching the slot, not to undo in vain
+    if(writer_.load(std::memory_order_relaxed))
+    {
+      return false;
+    }
+    auto &count=readers_[slot].count;
+    count.fetch_add(1, std::memory_order_seq_cst);
+    if(writer_.load(std::memory_order_seq_cst))
+    {
+      count.fetch_sub(1, std::memory_order_relaxed);
+      return false;
+    }
+    return true;
+  }
+
+  void
+  lock_r(int slot)
+  {
+    while(!try_lock_r(slot))
+    {
+      while(writer_.load(std::memory_order_relaxed))
+      {
+        impl_::cpu_pause_();
+      }
+    }
+  }
+
+  void
+  unlock_r(int slot)
+  {
+    readers_[slot].count.fetch_sub(1, std::memory_order_release);
+  }
+
+  bool // success
+  try_upgrade(int slot)
+  {
+    auto expected=false;
+    if(!writer_.compare_exchange_weak(expected, true,
+                                      std::memory_order_seq_cst,
+                                      std::memory_order_relaxed))
+    {
+      return false;
+    }
+    if(reader_count_()!=1) // not the only reader
+    {
+      writer_.store(false, std::memory_order_release);
+      return false;
+    }
+    readers_[slot].count.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  void
+  upgrade(int slot)
+  {
+    while(!try_upgrade(slot))
+    {
+      while(writer_.load(std::memory_order_relaxed)||
+            (reader_count_(std::memory_order_relaxed)!=1))
+      {
+        impl_::cpu_pause_();
+      }
+    }
+  }
+
+  void
+  downgrade(int slot)
+  {
+    readers_[slot].count.fetch_add(1, std::memory_order_relaxed);
+    writer_.store(false, std::memory_order_release);
+  }
+
+private:
+
+  int
+  reader_count_(std::memory_order order=std::memory_order_seq_cst) const
+  {
+    auto count=0;
+    for(auto slot=0; slot<slot_count_; ++slot)
+    {
+      count+=readers_[slot].count.load(order);
+    }
+    return count;
+  }
+
+  struct alignas(assumed_cacheline_size) Slot_
+  {
+    std::atomic<int> count{};
+  };
+
+  int slot_count_;
+  std::unique_ptr<int[]> cpu_slots_;
+  int sys_slot_count_;
+  std::unique_ptr<int[]> sys_slots_;
+  std::unique_ptr<Slot_[]> readers_;
+  alignas(assumed_cacheline_size) std::atomic<bool> writer_;
+};
+
+} // namespace dim
+
+#endif // DIM_DISTRIBUTED_SPIN_LOCK_HPP
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
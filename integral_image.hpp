@@ -0,0 +1,212 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef DIM_INTEGRAL_IMAGE_HPP
+#define DIM_INTEGRAL_IMAGE_HPP
+
+#include "aligned_buffer_2d.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
+namespace dim {
+
+namespace impl_ {
+
+template<typename T>
+using integral_accum_t =
+  std::conditional_t<std::is_floating_point_v<T>, double,
+  std::conditional_t<std::is_unsigned_v<T>, std::uint64_t,
+  std::int64_t>>;
+
+#if !DIM_ALIGNED_BUFFER_DISABLE_SIMD
+template<int Shift,
+         typename SimdType>
+inline
+SimdType
+inclusive_scan_(SimdType s)
+{
+  // log-step scan: add the vector shifted up by 1, 2, 4... lanes
+  if constexpr(Shift<SimdType::value_count)
+  {
+    return inclusive_scan_<2*Shift>(s+simd::up<Shift>(s, SimdType{}));
+  }
+  else
+  {
+    return s;
+  }
+}
+#endif
+
+} // namespace impl_
+
+// summed-area table: element (x, y) holds the sum of the source values
+// in [0, x)*[0, y), so that any rectangle sum needs only four loads
+template<typename T,
+         typename AccumType=impl_::integral_accum_t<T>>
+class IntegralImage
+{
+public:
+
+  using accum_t = AccumType;
+
+  static_assert(std::is_arithmetic_v<T>&&std::is_arithmetic_v<accum_t>,
+                "arithmetic types expected");
+
+  IntegralImage()
+  : IntegralImage{0, 0}
+  {
+    // nothing more to be done
+  }
+
+  IntegralImage(std::ptrdiff_t width,
+                std::ptrdiff_t height)
+  : width_{width}
+  , height_{height}
+  , table_{width+1, height+1}
+  , saved_row_{table_.pitch()}
+  {
+    // nothing more to be done
+  }
+
+  std::ptrdiff_t
+  width() const
+  {
+    return width_;
+  }
+
+  std::ptrdiff_t
+  height() const
+  {
+    return height_;
+  }
+
+  const AlignedBuffer2D<accum_t> &
+  table() const
+  {
+    return table_;
+  }
+
+  accum_t // sum of the source values in [x, x+w)*[y, y+h)
+  sum(std::ptrdiff_t x, std::ptrdiff_t y,
+      std::ptrdiff_t w, std::ptrdiff_t h) const
+  {
+    const auto *top=table_.crow(y);
+    const auto *bottom=table_.crow(y+h);
+    return (bottom[x+w]-bottom[x])-(top[x+w]-top[x]);
+  }
+
+  // first phase of a (re)build: horizontal prefix sums of the source rows
+  // in [y_begin, y_end), shared out between the parts
+  void
+  build_rows(const AlignedBuffer2D<T> &src,
+             int part_id, int part_count,
+             std::ptrdiff_t y_begin=0,
+             std::ptrdiff_t y_end=-1)
+  {
+    if(y_end<0)
+    {
+      y_end=height_;
+    }
+    for(auto [y, y_id_end]=sequence_part(y_begin, y_end, part_id, part_count);
+        y<y_id_end; ++y)
+    {
+      auto * DIM_RESTRICT d=table_.row(y+1)+1;
+      if((y+1==y_end)&&(y_end<height_))
+      {
+        // the rows below the band will be shifted by the difference
+        std::copy(d-1, d+width_, saved_row_.data());
+      }
+      const auto * DIM_RESTRICT s=src.crow(y);
+      auto carry=accum_t{};
+      auto x=std::ptrdiff_t{};
+#if !DIM_ALIGNED_BUFFER_DISABLE_SIMD
+      using simd_t = typename AlignedBuffer2D<accum_t>::simd_t;
+      constexpr auto vc=simd_t::value_count;
+      for(; x+vc<=width_; x+=vc)
+      {
+        auto v=simd_t{};
+        for(auto lane=0; lane<vc; ++lane)
+        {
+          v.vec()[lane]=accum_t(s[x+lane]);
+        }
+        v=impl_::inclusive_scan_<1>(v)+carry;
+        simd::store_u(d+x, v);
+        carry=v[vc-1];
+      }
+#endif
+      for(; x<width_; ++x)
+      {
+        carry+=accum_t(s[x]);
+        d[x]=carry;
+      }
+    }
+  }
+
+  // second phase of a (re)build, once all the parts have completed
+  // build_rows() with the same band: vertical accumulation of the band
+  // and shift of the rows below it, columns are shared out between parts
+  void
+  build_columns(int part_id, int part_count,
+                std::ptrdiff_t y_begin=0,
+                std::ptrdiff_t y_end=-1)
+  {
+    if(y_end<0)
+    {
+      y_end=height_;
+    }
+#if DIM_ALIGNED_BUFFER_DISABLE_SIMD
+    auto * DIM_RESTRICT d=table_.data();
+    auto * DIM_RESTRICT saved=saved_row_.data();
+    const auto pitch=table_.pitch();
+    const auto [i_begin, i_end]=
+      sequence_part(table_.width(), part_id, part_count);
+#else
+    auto * DIM_RESTRICT d=table_.simd_data();
+    auto * DIM_RESTRICT saved=saved_row_.simd_data();
+    const auto pitch=table_.simd_pitch();
+    const auto [i_begin, i_end]=
+      sequence_part(table_.simd_width(), part_id, part_count);
+#endif
+    for(auto y=y_begin+1; y<=y_end; ++y)
+    {
+      for(auto i=i_begin; i<i_end; ++i)
+      {
+        d[y*pitch+i]+=d[(y-1)*pitch+i];
+      }
+    }
+    if(y_end<height_)
+    {
+      for(auto i=i_begin; i<i_end; ++i)
+      {
+        saved[i]=d[y_end*pitch+i]-saved[i];
+      }
+      for(auto y=y_end+1; y<=height_; ++y)
+      {
+        for(auto i=i_begin; i<i_end; ++i)
+        {
+          d[y*pitch+i]+=saved[i];
+        }
+      }
+    }
+  }
+
+  void
+  build(const AlignedBuffer2D<T> &src) // sequential convenience
+  {
+    build_rows(src, 0, 1);
+    build_columns(0, 1);
+  }
+
+private:
+  std::ptrdiff_t width_;
+  std::ptrdiff_t height_;
+  AlignedBuffer2D<accum_t> table_;
+  AlignedBuffer<accum_t> saved_row_;
+};
+
+} // namespace dim
+
+#endif // DIM_INTEGRAL_IMAGE_HPP
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -0,0 +1,291 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef DIM_QUEUE_LOCK_HPP
+#define DIM_QUEUE_LOCK_HPP
+
+#include "cpu_platform.hpp"
+#include "synchro.hpp"
+#include "utils.hpp"
+
+#include <memory>
+#include <atomic>
+#include <algorithm>
+
+// McsLock is a queued mutual-exclusion lock (Mellor-Crummey and Scott):
+// each thread waiting for the lock provides a node (usually on its stack,
+// the same one for lock() and unlock()) which is appended to the queue,
+// then it spins on its own node until its predecessor hands the lock
+// over, thus the waiters do not contend on a shared cacheline and obtain
+// the lock in arrival order.
+// CohortLock uses one such queue per numa node of a cpu::Platform, and a
+// global ticket lock between the nodes: the lock is handed over to the
+// next waiter of the same node, which also inherits the global lock,
+// until pass_limit consecutive hand-overs have been done; then the
+// global lock is released so that the other nodes get their turn.
+// Thus the data protected by the lock mostly stays within a node.
+
+namespace dim {
+
+namespace impl_ {
+
+class McsQueue_
+{
+public:
+
+  struct alignas(assumed_cacheline_size) Node
+  {
+    std::atomic<Node *> next{};
+    std::atomic<int> state{};
+  };
+
+  // state of a node once it obtains the lock
+  static constexpr auto waiting=0;
+  static constexpr auto granted=1; // alone in the queue or handed over
+  static constexpr auto passed=2;  // handed over with the global lock
+
+  McsQueue_()
+  : tail_{}
+  {
+    // nothing more to be done
+  }
+
+  bool // success
+  try_acquire(Node &node)
+  {
+    node.next.store(nullptr, std::memory_order_relaxed);
+    auto expected=static_cast<Node *>(nullptr);
+    return tail_.compare_exchange_strong(expected, &node,
+                                         std::memory_order_acquire,
+                                         std::memory_order_relaxed);
+  }
+
+  int // granted or passed
+  acquire(Node &node)
+  {
+    node.next.store(nullptr, std::memory_order_relaxed);
+    node.state.store(waiting, std::memory_order_relaxed);
+    auto *pred=tail_.exchange(&node, std::memory_order_acq_rel);
+    if(!pred)
+    {
+      return granted;
+    }
+    pred->next.store(&node, std::memory_order_release);
+    for(;;)
+    {
+      if(const auto state=node.state.load(std::memory_order_acquire);
+         state!=waiting)
+      {
+        return state;
+      }
+      cpu_pause_();
+    }
+  }
+
+  bool // another thread is queued after node
+  has_successor(const Node &node) const
+  {
+    return node.next.load(std::memory_order_relaxed)||
+           (tail_.load(std::memory_order_relaxed)!=&node);
+  }
+
+  void
+  release(Node &node,
+          int state) // for the successor, if any
+  {
+    auto *next=node.next.load(std::memory_order_acquire);
+    if(!next)
+    {
+      auto expected=&node;
+      if(tail_.compare_exchange_strong(expected, nullptr,
+                                       std::memory_order_release,
+                                       std::memory_order_relaxed))
+      {
+        return;
+      }
+      // a successor is being queued
+      while(!(next=node.next.load(std::memory_order_acquire)))
+      {
+        cpu_pause_();
+      }
+    }
+    next->state.store(state, std::memory_order_release);
+  }
+
+private:
+  std::atomic<Node *> tail_;
+};
+
+} // namespace impl_
+
+class McsLock
+{
+public:
+
+  using Node = impl_::McsQueue_::Node;
+
+  McsLock()
+  : queue_{}
+  {
+    // nothing more to be done
+  }
+
+  McsLock(const McsLock &) =delete;
+  McsLock & operator=(const McsLock &) =delete;
+  McsLock(McsLock &&) =delete;
+  McsLock & operator=(McsLock &&) =delete;
+
+  bool // success
+  try_lock(Node &node)
+  {
+    return queue_.try_acquire(node);
+  }
+
+  void
+  lock(Node &node)
+  {
+    queue_.acquire(node);
+  }
+
+  void
+  unlock(Node &node)
+  {
+    queue_.release(node, impl_::McsQueue_::granted);
+  }
+
+private:
+  impl_::McsQueue_ queue_;
+};
+
+class CohortLock
+{
+public:
+
+  using Node = impl_::McsQueue_::Node;
+
+  static constexpr auto default_pass_limit=64;
+
+  explicit
+  CohortLock(const cpu::Platform &platform,
+             int pass_limit=default_pass_limit) // hand-overs within a node
+  : pass_limit_{pass_limit}
+  , cohort_count_{platform.numa_count()}
+  , cpu_cohorts_{std::make_unique<int[]>(platform.cpu_count())}
+  , sys_cohort_count_{}
+  , sys_cohorts_{}
+  , cohorts_{std::make_unique<Cohort_[]>(cohort_count_)}
+  , next_ticket_{}
+  , now_serving_{}
+  {
+    for(auto cpu=0; cpu<platform.cpu_count(); ++cpu)
+    {
+      cpu_cohorts_[cpu]=std::max(0, platform.numa(cpu));
+      sys_cohort_count_=std::max(sys_cohort_count_,
+                                 platform.cpu_id(cpu).id+1);
+    }
+    sys_cohorts_=std::make_unique<int[]>(sys_cohort_count_);
+    for(auto cpu=0; cpu<platform.cpu_count(); ++cpu)
+    {
+      if(const auto sys_id=platform.cpu_id(cpu).id; sys_id>=0)
+      {
+        sys_cohorts_[sys_id]=cpu_cohorts_[cpu];
+      }
+    }
+  }
+
+  CohortLock(const CohortLock &) =delete;
+  CohortLock & operator=(const CohortLock &) =delete;
+  CohortLock(CohortLock &&) =delete;
+  CohortLock & operator=(CohortLock &&) =delete;
+
+  int
+  cohort_count() const
+  {
+    return cohort_count_;
+  }
+
+  int // cohort for a thread bound to this cpu index
+  cohort(int cpu_index) const
+  {
+    return cpu_cohorts_[cpu_index];
+  }
+
+  int // cohort for the cpu currently running the calling thread
+  cohort() const
+  {
+    const auto sys_id=cpu::current_cpu().id;
+    return (sys_id>=0)&&(sys_id<sys_cohort_count_) ? sys_cohorts_[sys_id]
+                                                   : 0;
+  }
+
+  void // the same cohort must be given to unlock()
+  lock(Node &node,
+       int cohort)
+  {
+    if(cohorts_[cohort].queue.acquire(node)!=impl_::McsQueue_::passed)
+    {
+      lock_global_();
+    }
+  }
+
+  void
+  unlock(Node &node,
+         int cohort)
+  {
+    auto &c=cohorts_[cohort];
+    // pass_count is only used by the owner of the lock of the cohort
+    if((c.pass_count<pass_limit_)&&c.queue.has_successor(node))
+    {
+      ++c.pass_count;
+      c.queue.release(node, impl_::McsQueue_::passed);
+    }
+    else
+    {
+      c.pass_count=0;
+      unlock_global_();
+      c.queue.release(node, impl_::McsQueue_::granted);
+    }
+  }
+
+private:
+
+  void
+  lock_global_()
+  {
+    // a ticket lock can be released by another thread of the cohort
+    const auto ticket=next_ticket_.fetch_add(1, std::memory_order_relaxed);
+    while(now_serving_.load(std::memory_order_acquire)!=ticket)
+    {
+      impl_::cpu_pause_();
+    }
+  }
+
+  void
+  unlock_global_()
+  {
+    now_serving_.store(now_serving_.load(std::memory_order_relaxed)+1,
+                       std::memory_order_release);
+  }
+
+  struct alignas(assumed_cacheline_size) Cohort_
+  {
+    impl_::McsQueue_ queue{};
+    int pass_count{};
+  };
+
+  using ticket_t = unsigned int; // overflow is correct
+
+  int pass_limit_;
+  int cohort_count_;
+  std::unique_ptr<int[]> cpu_cohorts_;
+  int sys_cohort_count_;
+  std::unique_ptr<int[]> sys_cohorts_;
+  std::unique_ptr<Cohort_[]> cohorts_;
+  alignas(assumed_cacheline_size) std::atomic<ticket_t> next_ticket_;
+  alignas(assumed_cacheline_size) std::atomic<ticket_t> now_serving_;
+};
+
+} // namespace dim
+
+#endif // DIM_QUEUE_LOCK_HPP
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
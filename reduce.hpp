@@ -0,0 +1,800 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef DIM_REDUCE_HPP
+#define DIM_REDUCE_HPP
+
+#include "aligned_buffer.hpp"
+
+#include <cstdint>
+#include <limits>
+
+namespace dim {
+
+// every reduction considers the same slice of the buffer as apply0() for
+// a given part (or some rows of a region of interest), the results of the
+// parts must then be combined (see Team)
+
+template<typename T>
+struct IndexedValue
+{
+  T value;
+  std::ptrdiff_t index; // -1 when the part had no element to consider
+};
+
+template<typename T>
+inline
+IndexedValue<T> // combines the argmin() of two parts
+merge_argmin(const IndexedValue<T> &a,
+             const IndexedValue<T> &b)
+{
+  if((a.index<0)||
+     ((b.index>=0)&&((b.value<a.value)||
+                     ((b.value==a.value)&&(b.index<a.index)))))
+  {
+    return b;
+  }
+  return a;
+}
+
+template<typename T>
+inline
+IndexedValue<T> // combines the argmax() of two parts
+merge_argmax(const IndexedValue<T> &a,
+             const IndexedValue<T> &b)
+{
+  if((a.index<0)||
+     ((b.index>=0)&&((b.value>a.value)||
+                     ((b.value==a.value)&&(b.index<a.index)))))
+  {
+    return b;
+  }
+  return a;
+}
+
+namespace impl_ {
+
+template<typename T>
+constexpr
+T
+highest_()
+{
+  if constexpr(std::numeric_limits<T>::has_infinity)
+  {
+    return std::numeric_limits<T>::infinity();
+  }
+  else
+  {
+    return std::numeric_limits<T>::max();
+  }
+}
+
+template<typename T>
+constexpr
+T
+lowest_()
+{
+  if constexpr(std::numeric_limits<T>::has_infinity)
+  {
+    return -std::numeric_limits<T>::infinity();
+  }
+  else
+  {
+    return std::numeric_limits<T>::lowest();
+  }
+}
+
+struct MinOp_
+{
+  template<typename A>
+  A
+  operator()(const A &a,
+             const A &b) const
+  {
+    if constexpr(std::is_arithmetic_v<A>)
+    {
+      return (a<b) ? a : b;
+    }
+    else
+    {
+      return fmin(a, b);
+    }
+  }
+};
+
+struct MaxOp_
+{
+  template<typename A>
+  A
+  operator()(const A &a,
+             const A &b) const
+  {
+    if constexpr(std::is_arithmetic_v<A>)
+    {
+      return (a>b) ? a : b;
+    }
+    else
+    {
+      return fmax(a, b);
+    }
+  }
+};
+
+template<typename V>
+inline
+V
+abs_(const V &v)
+{
+#if !DIM_ALIGNED_BUFFER_DISABLE_SIMD
+  if constexpr(!std::is_arithmetic_v<V>)
+  {
+    return select(v<V{}, -v, v);
+  }
+  else
+#endif
+  {
+    return (v<V{}) ? V(-v) : v;
+  }
+}
+
+template<typename T,
+         typename Op>
+inline
+T
+extremum_(const AlignedBuffer<T> &buffer,
+          const Ranges_ &ranges,
+          T identity,
+          Op op)
+{
+  using elem_t = reduce_elem_t<T>;
+  const auto * DIM_RESTRICT d=reduce_data_(buffer);
+  const auto simd_identity=elem_t{identity};
+  return horizontal_(
+    reduce_<T>(ranges, simd_identity,
+      [&](auto &accum, std::ptrdiff_t i, auto keep)
+      {
+        // op(a, b) is b when the comparison fails, thus a NaN value must
+        // come first so that it never replaces the accumulator
+        accum=op(keep_(d[i], keep, simd_identity), accum);
+      },
+      op),
+    op);
+}
+
+template<typename T>
+inline
+std::ptrdiff_t
+find_first_(const AlignedBuffer<T> &buffer,
+            const Ranges_ &ranges,
+            T value)
+{
+  for(auto r=std::ptrdiff_t{}; r<ranges.count; ++r)
+  {
+    const auto first=ranges.first+r*ranges.stride;
+    const auto last=ranges.last+r*ranges.stride;
+#if DIM_ALIGNED_BUFFER_DISABLE_SIMD
+    const auto * DIM_RESTRICT d=buffer.cdata();
+    for(auto id=first; id<last; ++id)
+    {
+      if(d[id]==value)
+      {
+        return id;
+      }
+    }
+#else
+    using simd_t = typename AlignedBuffer<T>::simd_t;
+    constexpr auto vc=simd_t::value_count;
+    const auto * DIM_RESTRICT d=buffer.simd_cdata();
+    const auto simd_value=simd_t{value};
+    for(auto i=first/vc, i_end=(last+vc-1)/vc; i<i_end; ++i)
+    {
+      if(!horizontal_null(d[i]==simd_value))
+      {
+        for(auto lane=0; lane<vc; ++lane)
+        {
+          const auto id=i*vc+lane;
+          if((id>=first)&&(id<last)&&(d[i][lane]==value))
+          {
+            return id;
+          }
+        }
+      }
+    }
+#endif
+  }
+  return -1;
+}
+
+template<typename T>
+inline
+IndexedValue<T>
+argmin_(const AlignedBuffer<T> &buffer,
+        const Ranges_ &ranges)
+{
+  // a fast vector reduction, then a search that usually stops early,
+  // rather than dragging lane indices through the whole reduction
+  const auto value=extremum_(buffer, ranges, highest_<T>(), MinOp_{});
+  return {value, find_first_(buffer, ranges, value)};
+}
+
+template<typename T>
+inline
+IndexedValue<T>
+argmax_(const AlignedBuffer<T> &buffer,
+        const Ranges_ &ranges)
+{
+  const auto value=extremum_(buffer, ranges, lowest_<T>(), MaxOp_{});
+  return {value, find_first_(buffer, ranges, value)};
+}
+
+template<typename T>
+inline
+T
+dot_(const AlignedBuffer<T> &buffer1,
+     const AlignedBuffer<T> &buffer2,
+     const Ranges_ &ranges)
+{
+  using elem_t = reduce_elem_t<T>;
+  const auto * DIM_RESTRICT d1=reduce_data_(buffer1);
+  const auto * DIM_RESTRICT d2=reduce_data_(buffer2);
+  const auto op=std::plus<>{};
+  return horizontal_(
+    reduce_<T>(ranges, elem_t{},
+      [&](auto &accum, std::ptrdiff_t i, auto keep)
+      {
+        accum+=keep_(elem_t(d1[i]*d2[i]), keep, elem_t{});
+      },
+      op),
+    op);
+}
+
+template<typename T>
+inline
+T
+norm_l1_(const AlignedBuffer<T> &buffer,
+         const Ranges_ &ranges)
+{
+  using elem_t = reduce_elem_t<T>;
+  const auto * DIM_RESTRICT d=reduce_data_(buffer);
+  const auto op=std::plus<>{};
+  return horizontal_(
+    reduce_<T>(ranges, elem_t{},
+      [&](auto &accum, std::ptrdiff_t i, auto keep)
+      {
+        accum+=abs_(keep_(d[i], keep, elem_t{}));
+      },
+      op),
+    op);
+}
+
+template<typename T>
+inline
+T
+sqr_norm_l2_(const AlignedBuffer<T> &buffer,
+             const Ranges_ &ranges)
+{
+  using elem_t = reduce_elem_t<T>;
+  const auto * DIM_RESTRICT d=reduce_data_(buffer);
+  const auto op=std::plus<>{};
+  return horizontal_(
+    reduce_<T>(ranges, elem_t{},
+      [&](auto &accum, std::ptrdiff_t i, auto keep)
+      {
+        const auto v=keep_(d[i], keep, elem_t{});
+        accum+=v*v;
+      },
+      op),
+    op);
+}
+
+inline
+std::uint64_t
+sum_abs_diff_(const AlignedBuffer<std::uint8_t> &buffer1,
+              const AlignedBuffer<std::uint8_t> &buffer2,
+              const Ranges_ &ranges)
+{
+  using T = std::uint8_t;
+  const auto * DIM_RESTRICT d1=reduce_data_(buffer1);
+  const auto * DIM_RESTRICT d2=reduce_data_(buffer2);
+  const auto op=std::plus<>{};
+#if DIM_ALIGNED_BUFFER_DISABLE_SIMD
+  return reduce_<T>(ranges, std::uint64_t{},
+    [&](auto &accum, std::ptrdiff_t i, auto)
+    {
+      accum+=(d1[i]>d2[i]) ? d1[i]-d2[i] : d2[i]-d1[i];
+    },
+    op);
+#else
+  // psadbw sums groups of 8 bytes into 64-bit lanes: nothing to flush
+  using elem_t = reduce_elem_t<T>;
+  using accum_t = simd::simd_t<std::uint64_t, elem_t::vector_size>;
+  return horizontal_(
+    reduce_<T>(ranges, accum_t{},
+      [&](auto &accum, std::ptrdiff_t i, auto keep)
+      {
+        accum+=sad(keep_(d1[i], keep, elem_t{}),
+                   keep_(d2[i], keep, elem_t{}));
+      },
+      op),
+    op);
+#endif
+}
+
+template<typename V>
+struct Compensated_
+{
+  V sum;
+  V comp; // what was lost when rounding sum
+
+  void
+  add(V x)
+  {
+    // Neumaier's compensation, but with Knuth's branch-free two-sum
+    // for the rounding error (the compiler must not reassociate these,
+    // thus no -ffast-math)
+    const auto s=sum;
+    auto t=s+x; // not const: gcc would then keep sum in memory
+    const auto z=t-s;
+    comp+=(s-(t-z))+(x-z);
+    sum=t;
+  }
+
+  void
+  add(const Compensated_ &other)
+  {
+    add(other.sum);
+    comp+=other.comp;
+  }
+};
+
+#if !DIM_ALIGNED_BUFFER_DISABLE_SIMD
+template<typename MaskType>
+struct CountAccum_
+{
+  MaskType lanes; // per-lane counts, flushed before they can overflow
+  int steps;
+  std::ptrdiff_t total;
+
+  void
+  flush()
+  {
+    for(auto lane=0; lane<lanes.value_count; ++lane)
+    {
+      total+=std::ptrdiff_t(lanes[lane]);
+    }
+    lanes=MaskType{};
+    steps=0;
+  }
+};
+#endif
+
+template<typename T,
+         typename Pred>
+inline
+std::ptrdiff_t
+count_if_(const AlignedBuffer<T> &buffer,
+          const Ranges_ &ranges,
+          Pred pred)
+{
+  const auto * DIM_RESTRICT d=reduce_data_(buffer);
+#if DIM_ALIGNED_BUFFER_DISABLE_SIMD
+  return reduce_<T>(ranges, std::ptrdiff_t{},
+    [&](auto &accum, std::ptrdiff_t i, auto)
+    {
+      accum+=pred(d[i]) ? 1 : 0;
+    },
+    std::plus<>{});
+#else
+  using mask_t = typename AlignedBuffer<T>::simd_t::mask_type;
+  using lane_t = typename mask_t::value_type;
+  using accum_t = CountAccum_<mask_t>;
+  constexpr auto max_steps=
+    int(std::min<std::ptrdiff_t>(std::numeric_limits<lane_t>::max(),
+                                 std::numeric_limits<int>::max()));
+  auto accum=reduce_<T>(ranges, accum_t{},
+    [&](auto &accum, std::ptrdiff_t i, auto keep)
+    {
+      accum.lanes-=keep_(mask_t{pred(d[i])}, keep, mask_t{}); // true is -1
+      if(++accum.steps==max_steps)
+      {
+        accum.flush();
+      }
+    },
+    [&](accum_t a, accum_t b)
+    {
+      a.flush();
+      b.flush();
+      a.total+=b.total;
+      return a;
+    });
+  accum.flush();
+  return accum.total;
+#endif
+}
+
+} // namespace impl_
+
+template<typename T>
+inline
+T
+dot(const AlignedBuffer<T> &buffer1,
+    const AlignedBuffer<T> &buffer2,
+    int part_id, int part_count)
+{
+  return impl_::dot_(buffer1, buffer2,
+    impl_::part_ranges_(buffer1, part_id, part_count));
+}
+
+template<typename T>
+inline
+T
+dot(const AlignedBuffer<T> &buffer1,
+    const AlignedBuffer<T> &buffer2,
+    int part_id, int part_count,
+    std::ptrdiff_t width, std::ptrdiff_t height,
+    std::ptrdiff_t x, std::ptrdiff_t y, std::ptrdiff_t w, std::ptrdiff_t h)
+{
+  return impl_::dot_(buffer1, buffer2,
+    impl_::part_ranges_(buffer1, part_id, part_count,
+                        width, height, x, y, w, h));
+}
+
+// min(), max(), argmin() and argmax() ignore NaN values: a part holding
+// only NaNs gives the same result as an empty part
+
+template<typename T>
+inline
+T // highest value (or +inf) for an empty part
+min(const AlignedBuffer<T> &buffer,
+    int part_id, int part_count)
+{
+  return impl_::extremum_(buffer,
+    impl_::part_ranges_(buffer, part_id, part_count),
+    impl_::highest_<T>(), impl_::MinOp_{});
+}
+
+template<typename T>
+inline
+T // highest value (or +inf) for an empty part
+min(const AlignedBuffer<T> &buffer,
+    int part_id, int part_count,
+    std::ptrdiff_t width, std::ptrdiff_t height,
+    std::ptrdiff_t x, std::ptrdiff_t y, std::ptrdiff_t w, std::ptrdiff_t h)
+{
+  return impl_::extremum_(buffer,
+    impl_::part_ranges_(buffer, part_id, part_count,
+                        width, height, x, y, w, h),
+    impl_::highest_<T>(), impl_::MinOp_{});
+}
+
+template<typename T>
+inline
+T // lowest value (or -inf) for an empty part
+max(const AlignedBuffer<T> &buffer,
+    int part_id, int part_count)
+{
+  return impl_::extremum_(buffer,
+    impl_::part_ranges_(buffer, part_id, part_count),
+    impl_::lowest_<T>(), impl_::MaxOp_{});
+}
+
+template<typename T>
+inline
+T // lowest value (or -inf) for an empty part
+max(const AlignedBuffer<T> &buffer,
+    int part_id, int part_count,
+    std::ptrdiff_t width, std::ptrdiff_t height,
+    std::ptrdiff_t x, std::ptrdiff_t y, std::ptrdiff_t w, std::ptrdiff_t h)
+{
+  return impl_::extremum_(buffer,
+    impl_::part_ranges_(buffer, part_id, part_count,
+                        width, height, x, y, w, h),
+    impl_::lowest_<T>(), impl_::MaxOp_{});
+}
+
+template<typename T>
+inline
+IndexedValue<T> // first occurrence of the minimum
+argmin(const AlignedBuffer<T> &buffer,
+       int part_id, int part_count)
+{
+  return impl_::argmin_(buffer,
+    impl_::part_ranges_(buffer, part_id, part_count));
+}
+
+template<typename T>
+inline
+IndexedValue<T> // first occurrence of the minimum (index in the buffer)
+argmin(const AlignedBuffer<T> &buffer,
+       int part_id, int part_count,
+       std::ptrdiff_t width, std::ptrdiff_t height,
+       std::ptrdiff_t x, std::ptrdiff_t y, std::ptrdiff_t w, std::ptrdiff_t h)
+{
+  return impl_::argmin_(buffer,
+    impl_::part_ranges_(buffer, part_id, part_count,
+                        width, height, x, y, w, h));
+}
+
+template<typename T>
+inline
+IndexedValue<T> // first occurrence of the maximum
+argmax(const AlignedBuffer<T> &buffer,
+       int part_id, int part_count)
+{
+  return impl_::argmax_(buffer,
+    impl_::part_ranges_(buffer, part_id, part_count));
+}
+
+template<typename T>
+inline
+IndexedValue<T> // first occurrence of the maximum (index in the buffer)
+argmax(const AlignedBuffer<T> &buffer,
+       int part_id, int part_count,
+       std::ptrdiff_t width, std::ptrdiff_t height,
+       std::ptrdiff_t x, std::ptrdiff_t y, std::ptrdiff_t w, std::ptrdiff_t h)
+{
+  return impl_::argmax_(buffer,
+    impl_::part_ranges_(buffer, part_id, part_count,
+                        width, height, x, y, w, h));
+}
+
+template<typename T>
+inline
+T
+norm_l1(const AlignedBuffer<T> &buffer,
+        int part_id, int part_count)
+{
+  return impl_::norm_l1_(buffer,
+    impl_::part_ranges_(buffer, part_id, part_count));
+}
+
+template<typename T>
+inline
+T
+norm_l1(const AlignedBuffer<T> &buffer,
+        int part_id, int part_count,
+        std::ptrdiff_t width, std::ptrdiff_t height,
+        std::ptrdiff_t x, std::ptrdiff_t y, std::ptrdiff_t w, std::ptrdiff_t h)
+{
+  return impl_::norm_l1_(buffer,
+    impl_::part_ranges_(buffer, part_id, part_count,
+                        width, height, x, y, w, h));
+}
+
+template<typename T>
+inline
+T // the squared norms of the parts add up, not the norms
+sqr_norm_l2(const AlignedBuffer<T> &buffer,
+            int part_id, int part_count)
+{
+  return impl_::sqr_norm_l2_(buffer,
+    impl_::part_ranges_(buffer, part_id, part_count));
+}
+
+template<typename T>
+inline
+T // the squared norms of the parts add up, not the norms
+sqr_norm_l2(const AlignedBuffer<T> &buffer,
+            int part_id, int part_count,
+            std::ptrdiff_t width, std::ptrdiff_t height,
+            std::ptrdiff_t x, std::ptrdiff_t y,
+            std::ptrdiff_t w, std::ptrdiff_t h)
+{
+  return impl_::sqr_norm_l2_(buffer,
+    impl_::part_ranges_(buffer, part_id, part_count,
+                        width, height, x, y, w, h));
+}
+
+inline
+std::uint64_t // sum of |buffer1[i]-buffer2[i]|, as for block matching
+sum_abs_diff(const AlignedBuffer<std::uint8_t> &buffer1,
+             const AlignedBuffer<std::uint8_t> &buffer2,
+             int part_id, int part_count)
+{
+  return impl_::sum_abs_diff_(buffer1, buffer2,
+    impl_::part_ranges_(buffer1, part_id, part_count));
+}
+
+inline
+std::uint64_t // sum of |buffer1[i]-buffer2[i]|, as for block matching
+sum_abs_diff(const AlignedBuffer<std::uint8_t> &buffer1,
+             const AlignedBuffer<std::uint8_t> &buffer2,
+             int part_id, int part_count,
+             std::ptrdiff_t width, std::ptrdiff_t height,
+             std::ptrdiff_t x, std::ptrdiff_t y,
+             std::ptrdiff_t w, std::ptrdiff_t h)
+{
+  return impl_::sum_abs_diff_(buffer1, buffer2,
+    impl_::part_ranges_(buffer1, part_id, part_count,
+                        width, height, x, y, w, h));
+}
+
+template<typename T,
+         typename Pred>
+inline
+std::ptrdiff_t // pred(simd_t) --> mask, or pred(T) --> bool without simd
+count_if(const AlignedBuffer<T> &buffer,
+         int part_id, int part_count,
+         Pred pred)
+{
+  return impl_::count_if_(buffer,
+    impl_::part_ranges_(buffer, part_id, part_count), pred);
+}
+
+template<typename T,
+         typename Pred>
+inline
+std::ptrdiff_t // pred(simd_t) --> mask, or pred(T) --> bool without simd
+count_if(const AlignedBuffer<T> &buffer,
+         int part_id, int part_count,
+         std::ptrdiff_t width, std::ptrdiff_t height,
+         std::ptrdiff_t x, std::ptrdiff_t y, std::ptrdiff_t w, std::ptrdiff_t h,
+         Pred pred)
+{
+  return impl_::count_if_(buffer,
+    impl_::part_ranges_(buffer, part_id, part_count,
+                        width, height, x, y, w, h), pred);
+}
+
+//~~~~ reproducible sum ~~~~
+
+// the buffer is cut into blocks of fixed size whose partial sums are
+// combined along a fixed pairwise tree, thus the result only depends on
+// the buffer (and the simd width of the build), not on part_count.
+// The plain summation stays within 20% of sum() (see
+// tests/reproducible_sum_bench.cpp, SSE2 and AVX-512, 4096 to 16M values).
+// Known limitation: the compensated summation costs six operations per
+// vector instead of one, thus it stays 3 to 6 times slower than sum()
+// while the buffer fits in the caches, and only gets within about 1.2 to
+// 1.5 times once the memory bandwidth dominates (16M values); no cheaper
+// scheme keeps the same error bound.
+template<typename T,
+         bool Compensated=false> // compensated summation in each lane
+class ReproducibleSum
+{
+public:
+
+  static_assert(!Compensated||std::is_floating_point_v<T>,
+                "compensation only makes sense for floating point");
+
+  static constexpr auto block_size=std::ptrdiff_t{4096};
+
+  explicit
+  ReproducibleSum(std::ptrdiff_t count)
+  : count_{count}
+  , block_count_{(count+block_size-1)/block_size}
+  , partials_{std::make_unique<Partial_[]>(std::max(block_count_,
+                                                    std::ptrdiff_t{1}))}
+  {
+    // nothing more to be done
+  }
+
+  ReproducibleSum(const ReproducibleSum &) =delete;
+  ReproducibleSum & operator=(const ReproducibleSum &) =delete;
+  ReproducibleSum(ReproducibleSum &&) =default;
+  ReproducibleSum & operator=(ReproducibleSum &&) =default;
+
+  std::ptrdiff_t // the blocks were cut for this buffer count
+  count() const
+  {
+    return count_;
+  }
+
+  std::ptrdiff_t
+  block_count() const
+  {
+    return block_count_;
+  }
+
+  // first phase: each part computes the partial sums of some blocks; the
+  // caller checks that buffer.count() is count() beforehand (within a part
+  // job, an exception would leave the other parts behind)
+  void
+  accumulate(const AlignedBuffer<T> &buffer,
+             int part_id, int part_count)
+  {
+    for(auto [b, b_end]=sequence_part(block_count_, part_id, part_count);
+        b<b_end; ++b)
+    {
+      const auto first=b*block_size;
+      const auto last=std::min(first+block_size, count_);
+      partials_[b]=block_sum_(buffer, {first, last, 0, 1});
+    }
+  }
+
+  // second phase, once all the parts have completed accumulate()
+  T
+  result() const
+  {
+    if(block_count_==0)
+    {
+      return T{};
+    }
+    const auto p=combine_(0, block_count_);
+    if constexpr(Compensated)
+    {
+      return p.sum+p.comp;
+    }
+    else
+    {
+      return p.sum;
+    }
+  }
+
+private:
+
+  using Partial_ = impl_::Compensated_<T>;
+
+  static
+  Partial_
+  block_sum_(const AlignedBuffer<T> &buffer,
+             const impl_::Ranges_ &ranges)
+  {
+    if constexpr(!Compensated)
+    {
+      return {impl_::sum_(buffer, ranges), T{}};
+    }
+    else
+    {
+      using elem_t = impl_::reduce_elem_t<T>;
+      using accum_t = impl_::Compensated_<elem_t>;
+      const auto * DIM_RESTRICT d=impl_::reduce_data_(buffer);
+      // each accumulator holds two vectors
+      constexpr auto accum_count=
+        std::max(reduction_accumulator_count<>/2, 1);
+      const auto accum=
+        impl_::reduce_<T, default_vector_size, 1, accum_count>(
+          ranges, accum_t{},
+          [&](auto &accum, std::ptrdiff_t i, auto keep)
+          {
+            accum.add(impl_::keep_(d[i], keep, elem_t{}));
+          },
+          [&](accum_t a, const accum_t &b)
+          {
+            a.add(b);
+            return a;
+          });
+#if DIM_ALIGNED_BUFFER_DISABLE_SIMD
+      return accum;
+#else
+      auto p=Partial_{};
+      for(auto lane=0; lane<elem_t::value_count; ++lane)
+      {
+        p.add(Partial_{accum.sum[lane], accum.comp[lane]});
+      }
+      return p;
+#endif
+    }
+  }
+
+  Partial_
+  combine_(std::ptrdiff_t first,
+           std::ptrdiff_t count) const
+  {
+    if(count==1)
+    {
+      return partials_[first];
+    }
+    const auto half=count/2;
+    auto p=combine_(first, half);
+    const auto other=combine_(first+half, count-half);
+    if constexpr(Compensated)
+    {
+      p.add(other);
+    }
+    else
+    {
+      p.sum+=other.sum;
+    }
+    return p;
+  }
+
+  std::ptrdiff_t count_;
+  std::ptrdiff_t block_count_;
+  std::unique_ptr<Partial_[]> partials_;
+};
+
+} // namespace dim
+
+#endif // DIM_REDUCE_HPP
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
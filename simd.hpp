@@ -9,10 +9,12 @@
 # include <arm_neon.h>
 #endif
 #include <cstdint>
+#include <cstddef>
 #include <type_traits>
 #include <tuple>
 #include <cmath>
 #include <algorithm>
+#include <functional>
 #include <string>
 #include <iostream>
 
@@ -160,11 +162,22 @@ using expect_value_count =
 
 constexpr auto max_vector_size=DIM_SIMD_MAX_VECTOR_SIZE;
 
+// on x86, the types for wider vectors than the compiler options allow are
+// defined too, so that kernels can be compiled for them in functions with
+// a target attribute (see simd_dispatch.hpp)
+#if __i386__ || __x86_64__
+# define DIM_SIMD_DISPATCH_VECTOR_SIZE 64
+#else
+# define DIM_SIMD_DISPATCH_VECTOR_SIZE DIM_SIMD_MAX_VECTOR_SIZE
+#endif
+
+constexpr auto dispatch_vector_size_limit=DIM_SIMD_DISPATCH_VECTOR_SIZE;
+
 #define DIM_SIMD_DEFINE_TYPE(name, base, vec_size) \
   using name = Simd<base __attribute__((__vector_size__(vec_size)))>; \
   template<> struct impl_::simd_helper<base, vec_size> { using type = name; };
 
-#if DIM_SIMD_MAX_VECTOR_SIZE>=64
+#if DIM_SIMD_DISPATCH_VECTOR_SIZE>=64
   DIM_SIMD_DEFINE_TYPE( u8x64_t,  std::uint8_t, 64)
   DIM_SIMD_DEFINE_TYPE( i8x64_t,   std::int8_t, 64)
   DIM_SIMD_DEFINE_TYPE(u16x32_t, std::uint16_t, 64)
@@ -177,7 +190,7 @@ constexpr auto max_vector_size=DIM_SIMD_MAX_VECTOR_SIZE;
   DIM_SIMD_DEFINE_TYPE( r64x8_t,        double, 64)
 #endif
 
-#if DIM_SIMD_MAX_VECTOR_SIZE>=32
+#if DIM_SIMD_DISPATCH_VECTOR_SIZE>=32
   DIM_SIMD_DEFINE_TYPE( u8x32_t,  std::uint8_t, 32)
   DIM_SIMD_DEFINE_TYPE( i8x32_t,   std::int8_t, 32)
   DIM_SIMD_DEFINE_TYPE(u16x16_t, std::uint16_t, 32)
@@ -190,7 +203,7 @@ constexpr auto max_vector_size=DIM_SIMD_MAX_VECTOR_SIZE;
   DIM_SIMD_DEFINE_TYPE( r64x4_t,        double, 32)
 #endif
 
-#if DIM_SIMD_MAX_VECTOR_SIZE>=16
+#if DIM_SIMD_DISPATCH_VECTOR_SIZE>=16
   DIM_SIMD_DEFINE_TYPE( u8x16_t,  std::uint8_t, 16)
   DIM_SIMD_DEFINE_TYPE( i8x16_t,   std::int8_t, 16)
   DIM_SIMD_DEFINE_TYPE( u16x8_t, std::uint16_t, 16)
@@ -204,6 +217,7 @@ constexpr auto max_vector_size=DIM_SIMD_MAX_VECTOR_SIZE;
 #endif
 
 #undef DIM_SIMD_MAX_VECTOR_SIZE
+#undef DIM_SIMD_DISPATCH_VECTOR_SIZE
 #undef DIM_SIMD_DEFINE_TYPE
 
 using u8_t  = simd_t< std::uint8_t, max_vector_size>;
@@ -731,7 +745,8 @@ inline
 auto
 load_u(const Simd<VectorType> *unaligned_addr)
 {
-  struct unaligned { VectorType v; } __attribute__((__packed__));
+  // may_alias: the values may be members of any structure (dim::Real3...)
+  struct unaligned { VectorType v; } __attribute__((__packed__, __may_alias__));
   return Simd{reinterpret_cast<const unaligned *>(unaligned_addr)->v};
 }
 
@@ -765,7 +780,7 @@ void
 store_u(Simd<VectorType> *unaligned_addr,
         Simd<VectorType> s)
 {
-  struct unaligned { VectorType v; } __attribute__((__packed__));
+  struct unaligned { VectorType v; } __attribute__((__packed__, __may_alias__));
   reinterpret_cast<unaligned *>(unaligned_addr)->v=s.vec();
 }
 
@@ -796,240 +811,1443 @@ store_a(typename Simd<VectorType>::value_type *aligned_addr,
   store_a(reinterpret_cast<Simd<VectorType> *>(aligned_addr), s);
 }
 
+template<typename VectorType>
+inline
+void // non-temporal: bypasses the caches (see stream_fence())
+store_stream(Simd<VectorType> *aligned_addr,
+             Simd<VectorType> s)
+{
+  constexpr auto vector_size=Simd<VectorType>::vector_size;
+#if __AVX512F__
+  if constexpr(vector_size==64)
+  {
+    _mm512_stream_si512(reinterpret_cast<__m512i *>(aligned_addr),
+                        reinterpret_cast<__m512i>(s.vec()));
+    return;
+  }
+#endif
+#if __AVX__
+  if constexpr(vector_size==32)
+  {
+    _mm256_stream_si256(reinterpret_cast<__m256i *>(aligned_addr),
+                        reinterpret_cast<__m256i>(s.vec()));
+    return;
+  }
+#endif
+#if __SSE2__
+  if constexpr(vector_size==16)
+  {
+    _mm_stream_si128(reinterpret_cast<__m128i *>(aligned_addr),
+                     reinterpret_cast<__m128i>(s.vec()));
+    return;
+  }
+#endif
+  store_a(aligned_addr, s);
+}
+
+template<typename VectorType>
+inline
+void
+store_stream(typename Simd<VectorType>::value_type *aligned_addr,
+             Simd<VectorType> s)
+{
+  store_stream(reinterpret_cast<Simd<VectorType> *>(aligned_addr), s);
+}
+
+inline
+void // orders the previous store_stream() before any subsequent store
+stream_fence()
+{
+#if __SSE__
+  _mm_sfence();
+#endif
+}
+
+template<typename SimdType,
+         typename =typename SimdType::vector_type>
+inline
+auto // mask selecting the lanes in [first_lane, last_lane)
+lane_mask(int first_lane,
+          int last_lane)
+{
+  using mask_t = typename SimdType::mask_type;
+  using lane_t = typename mask_t::value_type;
+  auto index=typename mask_t::vector_type{};
+  for(auto i=0; i<SimdType::value_count; ++i)
+  {
+    index[i]=lane_t(i);
+  }
+  return mask_t{(index>=lane_t(first_lane))&(index<lane_t(last_lane))};
+}
+
 template<typename SimdType>
 inline
 auto
 split(const typename SimdType::value_type *values,
-      int count)
+      std::ptrdiff_t count)
 {
   constexpr auto vector_size=SimdType::vector_size;
   constexpr auto value_size=SimdType::value_size;
   constexpr auto value_count=SimdType::value_count;
   const auto offset=int(reinterpret_cast<std::intptr_t>(values)%vector_size);
-  const auto prefix=offset ? (vector_size-offset)/value_size : 0;
+  const auto prefix=int(std::min<std::ptrdiff_t>(
+    offset ? (vector_size-offset)/value_size : 0, count));
   const auto simd_count=(count-prefix)/value_count;
-  const auto suffix=(count-prefix)%value_count;
+  const auto suffix=int((count-prefix)%value_count);
   return std::make_tuple(prefix, simd_count, suffix);
 }
 
+namespace impl_ {
+
 template<typename SimdType>
 inline
-auto
-load_prefix(const typename SimdType::value_type *values,
-            int prefix_length)
+auto // one bit per lane in [first_lane, last_lane), for avx512 masks
+lane_bits_(int first_lane,
+           int last_lane)
+{
+  constexpr auto value_count=SimdType::value_count;
+  using bits_t =
+    std::conditional_t<value_count==64, std::uint64_t,
+    std::conditional_t<value_count==32, std::uint32_t,
+    std::conditional_t<value_count==16, std::uint16_t,
+    std::uint8_t>>>;
+  if(first_lane>=last_lane)
+  {
+    return bits_t{}; // first_lane may be 64, too large a shift
+  }
+  const auto width=last_lane-first_lane;
+  const auto bits=(width>=64) ? ~std::uint64_t{}
+                              : ((std::uint64_t{1}<<width)-1);
+  return bits_t(bits<<first_lane);
+}
+
+template<typename SimdType>
+inline
+SimdType // lanes in [first_lane, last_lane) from addr, zero elsewhere
+masked_load_(const typename SimdType::value_type *addr,
+             int first_lane,
+             int last_lane)
 {
+  // addr designates lane 0, but only the selected lanes are accessed
   using vector_t = typename SimdType::vector_type;
+  [[maybe_unused]] constexpr auto vector_size=SimdType::vector_size;
+  [[maybe_unused]] constexpr auto value_size=SimdType::value_size;
+  [[maybe_unused]] const auto *p=static_cast<const void *>(addr);
+#if __AVX512F__
+  [[maybe_unused]] const auto k=lane_bits_<SimdType>(first_lane, last_lane);
+  if constexpr(vector_size==64)
+  {
+    if constexpr(value_size==4)
+    {
+      return {reinterpret_cast<vector_t>(_mm512_maskz_loadu_epi32(k, p))};
+    }
+    else if constexpr(value_size==8)
+    {
+      return {reinterpret_cast<vector_t>(_mm512_maskz_loadu_epi64(k, p))};
+    }
+# if __AVX512BW__
+    else if constexpr(value_size==2)
+    {
+      return {reinterpret_cast<vector_t>(_mm512_maskz_loadu_epi16(k, p))};
+    }
+    else
+    {
+      return {reinterpret_cast<vector_t>(_mm512_maskz_loadu_epi8(k, p))};
+    }
+# endif
+  }
+#endif
+#if __AVX2__
+  if constexpr((vector_size==32)&&(value_size>=4))
+  {
+    const auto m=reinterpret_cast<__m256i>(
+      lane_mask<SimdType>(first_lane, last_lane).vec());
+    if constexpr(value_size==4)
+    {
+      return {reinterpret_cast<vector_t>(
+        _mm256_maskload_epi32(static_cast<const int *>(p), m))};
+    }
+    else
+    {
+      return {reinterpret_cast<vector_t>(
+        _mm256_maskload_epi64(static_cast<const long long *>(p), m))};
+    }
+  }
+  if constexpr((vector_size==16)&&(value_size>=4))
+  {
+    const auto m=reinterpret_cast<__m128i>(
+      lane_mask<SimdType>(first_lane, last_lane).vec());
+    if constexpr(value_size==4)
+    {
+      return {reinterpret_cast<vector_t>(
+        _mm_maskload_epi32(static_cast<const int *>(p), m))};
+    }
+    else
+    {
+      return {reinterpret_cast<vector_t>(
+        _mm_maskload_epi64(static_cast<const long long *>(p), m))};
+    }
+  }
+#endif
+  if((first_lane<last_lane)&&
+     !(reinterpret_cast<std::intptr_t>(addr)%vector_size))
+  {
+    // an aligned vector never crosses a page, thus loading the lanes
+    // outside the (non-empty) range cannot fault; they are then blended away
+    const auto s=load_a<SimdType>(addr);
+    return select(lane_mask<SimdType>(first_lane, last_lane), s, SimdType{});
+  }
   auto result=vector_t{};
-  const auto offset=SimdType::value_count-prefix_length;
-  for(auto i=0; i<prefix_length; ++i)
+  for(auto i=first_lane; i<last_lane; ++i)
   {
-    result[i+offset]=values[i];
+    result[i]=addr[i];
   }
-  return Simd{result};
+  return {result};
 }
 
 template<typename VectorType>
 inline
-void
-store_prefix(typename Simd<VectorType>::value_type *values,
-             int prefix_length,
-             Simd<VectorType> s)
+void // lanes in [first_lane, last_lane) of s to addr, nothing elsewhere
+masked_store_(typename Simd<VectorType>::value_type *addr,
+              int first_lane,
+              int last_lane,
+              Simd<VectorType> s)
 {
-  const auto offset=Simd<VectorType>::value_count-prefix_length;
-  for(auto i=0; i<prefix_length; ++i)
+  // addr designates lane 0, but only the selected lanes are accessed
+  using simd_t = Simd<VectorType>;
+  [[maybe_unused]] constexpr auto vector_size=simd_t::vector_size;
+  [[maybe_unused]] constexpr auto value_size=simd_t::value_size;
+  [[maybe_unused]] auto *p=static_cast<void *>(addr);
+#if __AVX512F__
+  [[maybe_unused]] const auto k=lane_bits_<simd_t>(first_lane, last_lane);
+  if constexpr(vector_size==64)
+  {
+    const auto v=reinterpret_cast<__m512i>(s.vec());
+    if constexpr(value_size==4)
+    {
+      _mm512_mask_storeu_epi32(p, k, v);
+      return;
+    }
+    else if constexpr(value_size==8)
+    {
+      _mm512_mask_storeu_epi64(p, k, v);
+      return;
+    }
+# if __AVX512BW__
+    else if constexpr(value_size==2)
+    {
+      _mm512_mask_storeu_epi16(p, k, v);
+      return;
+    }
+    else
+    {
+      _mm512_mask_storeu_epi8(p, k, v);
+      return;
+    }
+# endif
+  }
+#endif
+#if __AVX2__
+  if constexpr((vector_size==32)&&(value_size>=4))
+  {
+    const auto m=reinterpret_cast<__m256i>(
+      lane_mask<simd_t>(first_lane, last_lane).vec());
+    const auto v=reinterpret_cast<__m256i>(s.vec());
+    if constexpr(value_size==4)
+    {
+      _mm256_maskstore_epi32(static_cast<int *>(p), m, v);
+    }
+    else
+    {
+      _mm256_maskstore_epi64(static_cast<long long *>(p), m, v);
+    }
+    return;
+  }
+  if constexpr((vector_size==16)&&(value_size>=4))
+  {
+    const auto m=reinterpret_cast<__m128i>(
+      lane_mask<simd_t>(first_lane, last_lane).vec());
+    const auto v=reinterpret_cast<__m128i>(s.vec());
+    if constexpr(value_size==4)
+    {
+      _mm_maskstore_epi32(static_cast<int *>(p), m, v);
+    }
+    else
+    {
+      _mm_maskstore_epi64(static_cast<long long *>(p), m, v);
+    }
+    return;
+  }
+#endif
+  // no blend of a whole vector here: the lanes outside the range may be
+  // concurrently written by another thread
+  for(auto i=first_lane; i<last_lane; ++i)
   {
-    values[i]=s[i+offset];
+    addr[i]=s[i];
   }
 }
 
+} // namespace impl_
+
 template<typename SimdType>
 inline
-auto
-load_suffix(const typename SimdType::value_type *values,
-            int suffix_length)
+auto // values in the last prefix_length lanes, zero elsewhere
+load_prefix(const typename SimdType::value_type *values,
+            int prefix_length)
 {
-  using vector_t = typename SimdType::vector_type;
-  auto result=vector_t{};
-  for(auto i=0; i<suffix_length; ++i)
+  if(!prefix_length)
   {
-    result[i]=values[i];
+    return SimdType{}; // values-offset could be before the array
   }
-  return Simd{result};
+  const auto offset=SimdType::value_count-prefix_length;
+  return impl_::masked_load_<SimdType>(values-offset,
+                                       offset, SimdType::value_count);
 }
 
 template<typename VectorType>
 inline
-void
-store_suffix(typename Simd<VectorType>::value_type *values,
-             int suffix_length,
+void // the last prefix_length lanes of s
+store_prefix(typename Simd<VectorType>::value_type *values,
+             int prefix_length,
              Simd<VectorType> s)
 {
-  for(auto i=0; i<suffix_length; ++i)
+  if(!prefix_length)
   {
-    values[i]=s[i];
+    return; // values-offset could be before the array
   }
+  const auto offset=Simd<VectorType>::value_count-prefix_length;
+  impl_::masked_store_(values-offset,
+                       offset, Simd<VectorType>::value_count, s);
 }
 
-template<typename IndexVectorType,
-         typename ValueType>
+template<typename SimdType>
 inline
-auto
-gather(Simd<IndexVectorType> index,
-       const ValueType *aligned_source)
+auto // values in the first suffix_length lanes, zero elsewhere
+load_suffix(const typename SimdType::value_type *values,
+            int suffix_length)
 {
-  constexpr auto value_count=Simd<IndexVectorType>::value_count;
-  using result_t = simd_t<ValueType, value_count*sizeof(ValueType)>;
-  auto result=result_t{};
-  for(auto i=0; i<value_count; ++i)
-  {
-    result.vec()[i]=aligned_source[index[i]];
-  }
-  return result;
+  return impl_::masked_load_<SimdType>(values, 0, suffix_length);
 }
 
-template<typename VectorType,
-         typename IndexVectorType>
+template<typename VectorType>
 inline
-void
-scatter(Simd<VectorType> values,
-        Simd<IndexVectorType> index,
-        typename Simd<VectorType>::value_type *aligned_destination)
+void // the first suffix_length lanes of s
+store_suffix(typename Simd<VectorType>::value_type *values,
+             int suffix_length,
+             Simd<VectorType> s)
 {
-  constexpr auto value_count=Simd<IndexVectorType>::value_count;
-  static_assert(value_count==Simd<VectorType>::value_count,
-                "index/value count mismatch");
-  for(auto i=0; i<value_count; ++i)
-  {
-    aligned_destination[index[i]]=values[i];
-  }
+  impl_::masked_store_(values, 0, suffix_length, s);
 }
 
-//~~~~ math functions ~~~~
+//~~~~ interleaved load/store ~~~~
 
-template<typename VectorType,
-         typename Fnct>
-auto
-transform(Simd<VectorType> s,
-          Fnct fnct)
+// N-tuples stored contiguously (xyzxyz...) are transposed into N vectors
+// (xx..., yy..., zz...) and back with shuffles of two vectors whose lanes
+// are constant, which the compiler turns into the permutes and blends of
+// the target; 32-bit values are first moved by blocks of four lanes (128
+// bits), then transposed within each block as with SSE (shufps, unpck)
+
+namespace impl_ {
+
+template<int N,
+         int Count,
+         int Block>
+struct Interleave_ // N-tuples of blocks of Block lanes
 {
-  // hopefuly, for simple math functions, the compiler will be able
-  // to call the appropriate simd instruction; in other cases it
-  // will serialise the calls
-  VectorType result;
-  for(auto i=0; i<s.value_count; ++i)
+  static constexpr auto blocks=Count/Block;
+
+  static constexpr
+  int // block b of component m, when merging input vector j (j>0)
+  deinterleave(int m,
+               int j,
+               int b)
   {
-    result[i]=fnct(s[i]);
+    const auto k=N*b+m; // in the interleaved sequence
+    if(j==1)
+    {
+      return (k<2*blocks) ? k : 0;
+    }
+    return (k/blocks==j) ? blocks+k%blocks : b;
   }
-  return Simd{result};
-}
-
-#define DIM_SIMD_TRANSFORM_STD_MATH(name) \
-        template<typename VectorType> \
-        auto \
-        name(Simd<VectorType> s) \
-        { \
-          using value_t = typename Simd<VectorType>::value_type; \
-          return transform(s, static_cast<value_t (*)(value_t)>(std::name)); \
-        }
 
-DIM_SIMD_TRANSFORM_STD_MATH(fabs)
-DIM_SIMD_TRANSFORM_STD_MATH(exp)
-DIM_SIMD_TRANSFORM_STD_MATH(log)
-DIM_SIMD_TRANSFORM_STD_MATH(sqrt)
-DIM_SIMD_TRANSFORM_STD_MATH(cbrt)
-DIM_SIMD_TRANSFORM_STD_MATH(sin)
-DIM_SIMD_TRANSFORM_STD_MATH(cos)
-DIM_SIMD_TRANSFORM_STD_MATH(tan)
-DIM_SIMD_TRANSFORM_STD_MATH(asin)
-DIM_SIMD_TRANSFORM_STD_MATH(acos)
-DIM_SIMD_TRANSFORM_STD_MATH(atan)
-DIM_SIMD_TRANSFORM_STD_MATH(sinh)
-DIM_SIMD_TRANSFORM_STD_MATH(cosh)
-DIM_SIMD_TRANSFORM_STD_MATH(tanh)
-DIM_SIMD_TRANSFORM_STD_MATH(ceil)
-DIM_SIMD_TRANSFORM_STD_MATH(floor)
-DIM_SIMD_TRANSFORM_STD_MATH(trunc)
-DIM_SIMD_TRANSFORM_STD_MATH(round)
+  static constexpr
+  int // block b of output vector j, when merging component m (m>0)
+  interleave(int j,
+             int m,
+             int b)
+  {
+    const auto k=j*blocks+b; // in the interleaved sequence
+    if(m==1)
+    {
+      return (k%N==0) ? k/N : (k%N==1) ? blocks+k/N : 0;
+    }
+    return (k%N==m) ? blocks+k/N : b;
+  }
+};
 
-#undef DIM_SIMD_TRANSFORM
+template<int N,
+         int M,
+         int J,
+         int Count,
+         int Block>
+struct DeinterleaveLanes_
+{
+  static constexpr
+  int
+  lane(int i)
+  {
+    using interleave_t = Interleave_<N, Count, Block>;
+    return Block*interleave_t::deinterleave(M, J, i/Block)+i%Block;
+  }
+};
 
-//~~~~ horizontal operations ~~~~
+template<int N,
+         int J,
+         int M,
+         int Count,
+         int Block>
+struct InterleaveLanes_
+{
+  static constexpr
+  int
+  lane(int i)
+  {
+    using interleave_t = Interleave_<N, Count, Block>;
+    return Block*interleave_t::interleave(J, M, i/Block)+i%Block;
+  }
+};
 
-template<typename VectorType>
-inline
-auto
-horizontal_sum(const Simd<VectorType> &s)
+template<int Count,
+         int L0, int L1, int L2, int L3>
+struct QuadLanes_ // the same selection in each block of four lanes
 {
-  auto sum=typename Simd<VectorType>::value_type{};
-  for(auto i=0; i<s.value_count; ++i)
+  static constexpr
+  int
+  lane(int i)
   {
-    sum+=s[i];
+    constexpr int l[4]={L0, L1, L2, L3}; // 4 and beyond: second vector
+    const auto base=i-i%4;
+    return (l[i%4]<4) ? base+l[i%4] : Count+base+l[i%4]-4;
   }
-  return sum;
+};
+
+template<typename Lanes,
+         int... I>
+constexpr
+auto
+lane_sequence_(std::integer_sequence<int, I...>)
+{
+  return std::integer_sequence<int, Lanes::lane(I)...>{};
 }
 
-template<typename VectorType>
+template<typename VectorType,
+         int... Lane>
 inline
 auto
-horizontal_product(const Simd<VectorType> &s)
+shuffle_sequence_(Simd<VectorType> a,
+                  Simd<VectorType> b,
+                  std::integer_sequence<int, Lane...>)
 {
-  auto product=typename Simd<VectorType>::value_type{1};
-  for(auto i=0; i<s.value_count; ++i)
-  {
-    product*=s[i];
-  }
-  return product;
+#if defined __clang__
+  return Simd{__builtin_shufflevector(a.vec(), b.vec(), Lane...)};
+#else
+  using mask_t = typename Simd<VectorType>::mask_type::vector_type;
+  return Simd{__builtin_shuffle(a.vec(), b.vec(), mask_t{Lane...})};
+#endif
 }
 
-template<typename VectorType>
+template<typename Lanes,
+         typename VectorType>
 inline
-auto
-horizontal_fmin(const Simd<VectorType> &s)
+auto // lane i is Lanes::lane(i) of the concatenation of a and b
+shuffle_lanes_(Simd<VectorType> a,
+               Simd<VectorType> b)
 {
-  auto min_elem=s[0];
-  for(auto i=0; i<s.value_count; ++i)
-  {
-    min_elem=std::fmin(min_elem, s[i]);
-  }
-  return min_elem;
+  constexpr auto count=Simd<VectorType>::value_count;
+  return shuffle_sequence_(a, b,
+    lane_sequence_<Lanes>(std::make_integer_sequence<int, count>{}));
 }
 
-template<typename VectorType>
+template<int L0, int L1, int L2, int L3,
+         typename VectorType>
 inline
 auto
-horizontal_fmax(const Simd<VectorType> &s)
+shuffle_quads_(Simd<VectorType> a,
+               Simd<VectorType> b)
 {
-  auto max_elem=s[0];
-  for(auto i=0; i<s.value_count; ++i)
-  {
-    max_elem=std::fmax(max_elem, s[i]);
-  }
-  return max_elem;
+  constexpr auto count=Simd<VectorType>::value_count;
+  return shuffle_lanes_<QuadLanes_<count, L0, L1, L2, L3>>(a, b);
 }
 
-template<typename VectorType>
+template<int N,
+         int M,
+         int Block,
+         int J=1,
+         typename SimdType>
 inline
-bool
-horizontal_null(const Simd<VectorType> &s)
+SimdType // component m, the inputs up to j being merged into partial
+deinterleave_merge_(const SimdType (&in)[N],
+                    SimdType partial)
 {
-  using value_t = typename Simd<VectorType>::value_type;
-  constexpr auto zero=value_t{};
-  auto r=zero;
-  for(auto i=0; i<s.value_count; ++i)
+  using lanes_t =
+    DeinterleaveLanes_<N, M, J, SimdType::value_count, Block>;
+  const auto merged=(J==1) ? shuffle_lanes_<lanes_t>(in[0], in[1])
+                           : shuffle_lanes_<lanes_t>(partial, in[J]);
+  if constexpr(J+1<N)
+  {
+    return deinterleave_merge_<N, M, Block, J+1>(in, merged);
+  }
+  else
   {
-    r|=s[i];
+    return merged;
   }
-  return r==zero;
 }
 
-//~~~~ display operations ~~~~
-
-template<typename VectorType>
+template<int N,
+         int J,
+         int Block,
+         int M=1,
+         typename SimdType>
 inline
-std::string
-to_string(const Simd<VectorType> &s)
+SimdType // output vector j, the components up to m being merged
+interleave_merge_(const SimdType (&in)[N],
+                  SimdType partial)
 {
-  auto result=std::string{'{'};
+  using lanes_t =
+    InterleaveLanes_<N, J, M, SimdType::value_count, Block>;
+  const auto merged=(M==1) ? shuffle_lanes_<lanes_t>(in[0], in[1])
+                           : shuffle_lanes_<lanes_t>(partial, in[M]);
+  if constexpr(M+1<N)
+  {
+    return interleave_merge_<N, J, Block, M+1>(in, merged);
+  }
+  else
+  {
+    return merged;
+  }
+}
+
+#if __AVX512F__
+// vpermt2ps/vpermt2d select any lane from two vectors, thus directly
+constexpr auto quads_max_vector_size_=32;
+#else
+constexpr auto quads_max_vector_size_=64;
+#endif
+
+template<typename SimdType>
+constexpr auto interleave_by_quads_=
+  (SimdType::value_size==4)&&(SimdType::value_count%4==0)&&
+  (SimdType::vector_size<=quads_max_vector_size_);
+
+template<typename SimdType>
+inline
+void // in each block of four lanes, as _MM_TRANSPOSE4_PS()
+transpose_quads_(SimdType (&inout)[4])
+{
+  const auto t0=shuffle_quads_<0, 4, 1, 5>(inout[0], inout[1]);
+  const auto t1=shuffle_quads_<0, 4, 1, 5>(inout[2], inout[3]);
+  const auto t2=shuffle_quads_<2, 6, 3, 7>(inout[0], inout[1]);
+  const auto t3=shuffle_quads_<2, 6, 3, 7>(inout[2], inout[3]);
+  inout[0]=shuffle_quads_<0, 1, 4, 5>(t0, t1);
+  inout[1]=shuffle_quads_<2, 3, 6, 7>(t0, t1);
+  inout[2]=shuffle_quads_<0, 1, 4, 5>(t2, t3);
+  inout[3]=shuffle_quads_<2, 3, 6, 7>(t2, t3);
+}
+
+template<typename SimdType,
+         int N,
+         int... M>
+inline
+auto // {components 0, 1... N-1} of the N-tuples read at unaligned_addr
+load_interleaved_(const typename SimdType::value_type *unaligned_addr,
+                  std::integer_sequence<int, M...>)
+{
+  constexpr auto c=SimdType::value_count;
+  SimdType in[N];
+  for(auto j=0; j<N; ++j)
+  {
+    in[j]=load_u<SimdType>(unaligned_addr+j*c);
+  }
+  if constexpr(interleave_by_quads_<SimdType>&&(N==3))
+  {
+    // block b of w[j] is the block j of the b-th xyzx yzxy zxyz sequence
+    const SimdType w[N]={deinterleave_merge_<N, M, 4>(in, in[0])...};
+    const auto xy=shuffle_quads_<2, 3, 5, 6>(w[1], w[2]);
+    const auto yz=shuffle_quads_<1, 2, 4, 5>(w[0], w[1]);
+    return std::make_tuple(shuffle_quads_<0, 3, 4, 6>(w[0], xy),
+                           shuffle_quads_<0, 2, 5, 7>(yz, xy),
+                           shuffle_quads_<1, 3, 4, 7>(yz, w[2]));
+  }
+  else if constexpr(interleave_by_quads_<SimdType>&&(N==4))
+  {
+    SimdType w[N]={deinterleave_merge_<N, M, 4>(in, in[0])...};
+    transpose_quads_(w);
+    return std::make_tuple(w[M]...);
+  }
+  else
+  {
+    return std::make_tuple(deinterleave_merge_<N, M, 1>(in, in[0])...);
+  }
+}
+
+template<typename SimdType,
+         int N,
+         int... J>
+inline
+void // the N components, as N-tuples written at unaligned_addr
+store_interleaved_(typename SimdType::value_type *unaligned_addr,
+                   const SimdType (&in)[N],
+                   std::integer_sequence<int, J...>)
+{
+  constexpr auto c=SimdType::value_count;
+  if constexpr(interleave_by_quads_<SimdType>&&(N==3))
+  {
+    const auto xy=shuffle_quads_<0, 2, 4, 6>(in[0], in[1]);
+    const auto yz=shuffle_quads_<1, 3, 5, 7>(in[1], in[2]);
+    const auto zx=shuffle_quads_<0, 2, 5, 7>(in[2], in[0]);
+    const SimdType w[N]={shuffle_quads_<0, 2, 4, 6>(xy, zx),
+                         shuffle_quads_<0, 2, 5, 7>(yz, xy),
+                         shuffle_quads_<1, 3, 5, 7>(zx, yz)};
+    (store_u(unaligned_addr+J*c, interleave_merge_<N, J, 4>(w, w[0])), ...);
+  }
+  else if constexpr(interleave_by_quads_<SimdType>&&(N==4))
+  {
+    SimdType w[N]={in[J]...};
+    transpose_quads_(w);
+    (store_u(unaligned_addr+J*c, interleave_merge_<N, J, 4>(w, w[0])), ...);
+  }
+  else
+  {
+    (store_u(unaligned_addr+J*c, interleave_merge_<N, J, 1>(in, in[0])), ...);
+  }
+}
+
+} // namespace impl_
+
+template<typename SimdType>
+inline
+auto // {xx..., yy..., zz..., ww...} from value_count xyzw quadruples
+load4(const typename SimdType::value_type *unaligned_addr)
+{
+  return impl_::load_interleaved_<SimdType, 4>(unaligned_addr,
+    std::make_integer_sequence<int, 4>{});
+}
+
+template<typename VectorType>
+inline
+void // value_count xyzw quadruples
+store4(typename Simd<VectorType>::value_type *unaligned_addr,
+       Simd<VectorType> x,
+       Simd<VectorType> y,
+       Simd<VectorType> z,
+       Simd<VectorType> w)
+{
+  const Simd<VectorType> in[4]={x, y, z, w};
+  impl_::store_interleaved_(unaligned_addr, in,
+    std::make_integer_sequence<int, 4>{});
+}
+
+namespace impl_ {
+
+template<typename VectorType>
+inline
+auto // one bit per lane, taken from the most significant bit of the lane
+mask_bits_(Simd<VectorType> mask)
+{
+  constexpr auto value_count=Simd<VectorType>::value_count;
+  [[maybe_unused]] constexpr auto vector_size=Simd<VectorType>::vector_size;
+  [[maybe_unused]] constexpr auto value_size=Simd<VectorType>::value_size;
+  using bits_t =
+    std::conditional_t<value_count==64, std::uint64_t,
+    std::conditional_t<value_count==32, std::uint32_t,
+    std::conditional_t<value_count==16, std::uint16_t,
+    std::uint8_t>>>;
+#if __AVX512F__
+  if constexpr(vector_size==64)
+  {
+    [[maybe_unused]] const auto v=reinterpret_cast<__m512i>(mask.vec());
+# if __AVX512DQ__
+    if constexpr(value_size==4)
+    {
+      return bits_t(_mm512_movepi32_mask(v));
+    }
+    else if constexpr(value_size==8)
+    {
+      return bits_t(_mm512_movepi64_mask(v));
+    }
+# endif
+# if __AVX512BW__
+    if constexpr(value_size==2)
+    {
+      return bits_t(_mm512_movepi16_mask(v));
+    }
+    else if constexpr(value_size==1)
+    {
+      return bits_t(_mm512_movepi8_mask(v));
+    }
+# endif
+  }
+#endif
+#if __AVX2__
+  if constexpr(vector_size==32)
+  {
+    const auto v=reinterpret_cast<__m256i>(mask.vec());
+    if constexpr(value_size==1)
+    {
+      return bits_t(_mm256_movemask_epi8(v));
+    }
+    else if constexpr(value_size==2)
+    {
+      // packing works within each 128-bit half
+      const auto b=std::uint32_t(_mm256_movemask_epi8(
+        _mm256_packs_epi16(v, _mm256_setzero_si256())));
+      return bits_t((b&0x00FFu)|((b>>8)&0xFF00u));
+    }
+    else if constexpr(value_size==4)
+    {
+      return bits_t(_mm256_movemask_ps(_mm256_castsi256_ps(v)));
+    }
+    else
+    {
+      return bits_t(_mm256_movemask_pd(_mm256_castsi256_pd(v)));
+    }
+  }
+#endif
+#if __SSE2__
+  if constexpr(vector_size==16)
+  {
+    const auto v=reinterpret_cast<__m128i>(mask.vec());
+    if constexpr(value_size==1)
+    {
+      return bits_t(_mm_movemask_epi8(v));
+    }
+    else if constexpr(value_size==2)
+    {
+      return bits_t(_mm_movemask_epi8(
+        _mm_packs_epi16(v, _mm_setzero_si128())));
+    }
+    else if constexpr(value_size==4)
+    {
+      return bits_t(_mm_movemask_ps(_mm_castsi128_ps(v)));
+    }
+    else
+    {
+      return bits_t(_mm_movemask_pd(_mm_castsi128_pd(v)));
+    }
+  }
+#endif
+  auto bits=bits_t{};
+  for(auto i=0; i<value_count; ++i)
+  {
+    bits|=bits_t(mask[i]<0 ? 1 : 0)<<i;
+  }
+  return bits;
+}
+
+template<typename IndexSimdType,
+         typename ValueType>
+constexpr auto native_gather_scatter_=
+  ((sizeof(ValueType)==4)||(sizeof(ValueType)==8))&&
+  ((IndexSimdType::value_size==8)||
+   ((IndexSimdType::value_size==4)&&
+    std::is_signed_v<typename IndexSimdType::value_type>));
+
+template<typename ResultType,
+         typename IndexVectorType,
+         typename MaskVectorType>
+inline
+ResultType // lanes not selected by mask are taken from fallback
+gather_(Simd<IndexVectorType> index,
+        const typename ResultType::value_type *source,
+        Simd<MaskVectorType> mask,
+        ResultType fallback)
+{
+  using index_t = Simd<IndexVectorType>;
+  using vector_t [[maybe_unused]] = typename ResultType::vector_type;
+  constexpr auto value_count=index_t::value_count;
+  static_assert(value_count==ResultType::value_count,
+                "index/value count mismatch");
+  static_assert(value_count==Simd<MaskVectorType>::value_count,
+                "mask/value count mismatch");
+  [[maybe_unused]] constexpr auto index_size=index_t::value_size;
+  [[maybe_unused]] constexpr auto value_size=ResultType::value_size;
+  [[maybe_unused]] const auto *p=static_cast<const void *>(source);
+  if constexpr(native_gather_scatter_<index_t,
+                                      typename ResultType::value_type>)
+  {
+#if __AVX512F__
+    if constexpr((index_t::vector_size==64)||(ResultType::vector_size==64))
+    {
+      const auto k=mask_bits_(mask);
+      if constexpr((index_size==4)&&(value_size==4))
+      {
+        return {reinterpret_cast<vector_t>(_mm512_mask_i32gather_epi32(
+          reinterpret_cast<__m512i>(fallback.vec()), k,
+          reinterpret_cast<__m512i>(index.vec()), p, 4))};
+      }
+      else if constexpr(index_size==4)
+      {
+        return {reinterpret_cast<vector_t>(_mm512_mask_i32gather_epi64(
+          reinterpret_cast<__m512i>(fallback.vec()), k,
+          reinterpret_cast<__m256i>(index.vec()), p, 8))};
+      }
+      else if constexpr(value_size==4)
+      {
+        return {reinterpret_cast<vector_t>(_mm512_mask_i64gather_epi32(
+          reinterpret_cast<__m256i>(fallback.vec()), k,
+          reinterpret_cast<__m512i>(index.vec()), p, 4))};
+      }
+      else
+      {
+        return {reinterpret_cast<vector_t>(_mm512_mask_i64gather_epi64(
+          reinterpret_cast<__m512i>(fallback.vec()), k,
+          reinterpret_cast<__m512i>(index.vec()), p, 8))};
+      }
+    }
+#endif
+#if __AVX2__
+    // the mask lanes must have the size of the values
+    if constexpr(Simd<MaskVectorType>::value_size==value_size)
+    {
+      using ip_t = std::conditional_t<value_size==4, int, long long>;
+      const auto *ip=static_cast<const ip_t *>(p);
+      if constexpr((index_size==4)&&(value_size==4)&&(value_count==8))
+      {
+        return {reinterpret_cast<vector_t>(_mm256_mask_i32gather_epi32(
+          reinterpret_cast<__m256i>(fallback.vec()), ip,
+          reinterpret_cast<__m256i>(index.vec()),
+          reinterpret_cast<__m256i>(mask.vec()), 4))};
+      }
+      else if constexpr((index_size==4)&&(value_size==4)&&(value_count==4))
+      {
+        return {reinterpret_cast<vector_t>(_mm_mask_i32gather_epi32(
+          reinterpret_cast<__m128i>(fallback.vec()), ip,
+          reinterpret_cast<__m128i>(index.vec()),
+          reinterpret_cast<__m128i>(mask.vec()), 4))};
+      }
+      else if constexpr((index_size==4)&&(value_size==8)&&(value_count==4))
+      {
+        return {reinterpret_cast<vector_t>(_mm256_mask_i32gather_epi64(
+          reinterpret_cast<__m256i>(fallback.vec()), ip,
+          reinterpret_cast<__m128i>(index.vec()),
+          reinterpret_cast<__m256i>(mask.vec()), 8))};
+      }
+      else if constexpr((index_size==8)&&(value_size==4)&&(value_count==4))
+      {
+        return {reinterpret_cast<vector_t>(_mm256_mask_i64gather_epi32(
+          reinterpret_cast<__m128i>(fallback.vec()), ip,
+          reinterpret_cast<__m256i>(index.vec()),
+          reinterpret_cast<__m128i>(mask.vec()), 4))};
+      }
+      else if constexpr((index_size==8)&&(value_size==8)&&(value_count==4))
+      {
+        return {reinterpret_cast<vector_t>(_mm256_mask_i64gather_epi64(
+          reinterpret_cast<__m256i>(fallback.vec()), ip,
+          reinterpret_cast<__m256i>(index.vec()),
+          reinterpret_cast<__m256i>(mask.vec()), 8))};
+      }
+      else if constexpr((index_size==8)&&(value_size==8)&&(value_count==2))
+      {
+        return {reinterpret_cast<vector_t>(_mm_mask_i64gather_epi64(
+          reinterpret_cast<__m128i>(fallback.vec()), ip,
+          reinterpret_cast<__m128i>(index.vec()),
+          reinterpret_cast<__m128i>(mask.vec()), 8))};
+      }
+    }
+#endif
+  }
+  auto result=fallback;
+  for(auto i=0; i<value_count; ++i)
+  {
+    if(mask[i])
+    {
+      result.vec()[i]=source[index[i]];
+    }
+  }
+  return result;
+}
+
+template<typename VectorType,
+         typename IndexVectorType,
+         typename MaskVectorType>
+inline
+void // only the lanes selected by mask are stored
+scatter_(Simd<VectorType> values,
+         Simd<IndexVectorType> index,
+         typename Simd<VectorType>::value_type *destination,
+         Simd<MaskVectorType> mask)
+{
+  using value_simd_t = Simd<VectorType>;
+  using index_t = Simd<IndexVectorType>;
+  constexpr auto value_count=index_t::value_count;
+  static_assert(value_count==value_simd_t::value_count,
+                "index/value count mismatch");
+  static_assert(value_count==Simd<MaskVectorType>::value_count,
+                "mask/value count mismatch");
+  [[maybe_unused]] constexpr auto index_size=index_t::value_size;
+  [[maybe_unused]] constexpr auto value_size=value_simd_t::value_size;
+  [[maybe_unused]] auto *p=static_cast<void *>(destination);
+#if __AVX512F__
+  // when several lanes have the same index, the last one is stored, as in
+  // the sequential loop
+  if constexpr(native_gather_scatter_<index_t,
+                                      typename value_simd_t::value_type>&&
+               ((index_t::vector_size==64)||(value_simd_t::vector_size==64)))
+  {
+    const auto k=mask_bits_(mask);
+    if constexpr((index_size==4)&&(value_size==4))
+    {
+      _mm512_mask_i32scatter_epi32(p, k,
+        reinterpret_cast<__m512i>(index.vec()),
+        reinterpret_cast<__m512i>(values.vec()), 4);
+    }
+    else if constexpr(index_size==4)
+    {
+      _mm512_mask_i32scatter_epi64(p, k,
+        reinterpret_cast<__m256i>(index.vec()),
+        reinterpret_cast<__m512i>(values.vec()), 8);
+    }
+    else if constexpr(value_size==4)
+    {
+      _mm512_mask_i64scatter_epi32(p, k,
+        reinterpret_cast<__m512i>(index.vec()),
+        reinterpret_cast<__m256i>(values.vec()), 4);
+    }
+    else
+    {
+      _mm512_mask_i64scatter_epi64(p, k,
+        reinterpret_cast<__m512i>(index.vec()),
+        reinterpret_cast<__m512i>(values.vec()), 8);
+    }
+    return;
+  }
+#endif
+  for(auto i=0; i<value_count; ++i)
+  {
+    if(mask[i])
+    {
+      destination[index[i]]=values[i];
+    }
+  }
+}
+
+#if __AVX512CD__
+template<typename VectorType,
+         typename IndexVectorType>
+inline
+Simd<VectorType> // in each lane, the sum of the values of the lanes up to
+                 // this one which have the same index
+conflict_sum_(Simd<VectorType> values,
+              Simd<IndexVectorType> index)
+{
+  constexpr auto value_size=Simd<VectorType>::value_size;
+  const auto idx=reinterpret_cast<__m512i>(index.vec());
+  // bit j of lane i is set when j<i and index[j]==index[i]
+  const auto conflicts=(value_size==4) ? _mm512_conflict_epi32(idx)
+                                       : _mm512_conflict_epi64(idx);
+  if(!_mm512_test_epi32_mask(conflicts, conflicts))
+  {
+    return values;
+  }
+  // pointer jumping along the previous lane with the same index (-1 if
+  // none): the number of steps is logarithmic in the length of the chains
+  const auto bit_count=_mm512_set1_epi32(8*value_size-1);
+  auto previous=(value_size==4)
+    ? _mm512_sub_epi32(bit_count, _mm512_lzcnt_epi32(conflicts))
+    : _mm512_sub_epi64(_mm512_set1_epi64(8*value_size-1),
+                       _mm512_lzcnt_epi64(conflicts));
+  const auto none=_mm512_set1_epi32(-1);
+  auto sum=reinterpret_cast<__m512i>(values.vec());
+  for(;;)
+  {
+    const auto valid=(value_size==4)
+      ? __mmask16(_mm512_cmpge_epi32_mask(previous, _mm512_setzero_si512()))
+      : __mmask16(_mm512_cmpge_epi64_mask(previous, _mm512_setzero_si512()));
+    if(!valid)
+    {
+      break;
+    }
+    if constexpr(value_size==4)
+    {
+      const auto pulled=_mm512_maskz_permutexvar_epi32(valid, previous, sum);
+      const auto added=
+        Simd<VectorType>{reinterpret_cast<VectorType>(sum)}+
+        Simd<VectorType>{reinterpret_cast<VectorType>(pulled)};
+      sum=_mm512_mask_mov_epi32(sum, valid,
+                                reinterpret_cast<__m512i>(added.vec()));
+      previous=_mm512_mask_permutexvar_epi32(none, valid,
+                                             previous, previous);
+    }
+    else
+    {
+      const auto k=__mmask8(valid);
+      const auto pulled=_mm512_maskz_permutexvar_epi64(k, previous, sum);
+      const auto added=
+        Simd<VectorType>{reinterpret_cast<VectorType>(sum)}+
+        Simd<VectorType>{reinterpret_cast<VectorType>(pulled)};
+      sum=_mm512_mask_mov_epi64(sum, k,
+                                reinterpret_cast<__m512i>(added.vec()));
+      previous=_mm512_mask_permutexvar_epi64(none, k, previous, previous);
+    }
+  }
+  return {reinterpret_cast<VectorType>(sum)};
+}
+#endif
+
+} // namespace impl_
+
+template<typename IndexVectorType,
+         typename ValueType>
+inline
+auto // source[index[i]] in lane i
+gather(Simd<IndexVectorType> index,
+       const ValueType *aligned_source)
+{
+  constexpr auto value_count=Simd<IndexVectorType>::value_count;
+  using result_t = simd_t<ValueType, value_count*sizeof(ValueType)>;
+  using mask_t = typename result_t::mask_type;
+  const auto zero=typename mask_t::vector_type{};
+  return impl_::gather_(index, aligned_source, mask_t{zero==zero},
+                        result_t{});
+}
+
+template<typename IndexVectorType,
+         typename ValueType,
+         typename MaskVectorType>
+inline
+auto // source[index[i]] where mask is set, fallback elsewhere (no access)
+gather(Simd<IndexVectorType> index,
+       const ValueType *aligned_source,
+       Simd<MaskVectorType> mask,
+       simd_t<ValueType, Simd<IndexVectorType>::value_count*sizeof(ValueType)>
+         fallback)
+{
+  return impl_::gather_(index, aligned_source, mask, fallback);
+}
+
+template<typename VectorType,
+         typename IndexVectorType>
+inline
+void // values[i] to destination[index[i]], the last lane wins on conflicts
+scatter(Simd<VectorType> values,
+        Simd<IndexVectorType> index,
+        typename Simd<VectorType>::value_type *aligned_destination)
+{
+  using mask_t = typename Simd<VectorType>::mask_type;
+  const auto zero=typename mask_t::vector_type{};
+  impl_::scatter_(values, index, aligned_destination, mask_t{zero==zero});
+}
+
+template<typename VectorType,
+         typename IndexVectorType,
+         typename MaskVectorType>
+inline
+void // only where mask is set
+scatter(Simd<VectorType> values,
+        Simd<IndexVectorType> index,
+        typename Simd<VectorType>::value_type *aligned_destination,
+        Simd<MaskVectorType> mask)
+{
+  impl_::scatter_(values, index, aligned_destination, mask);
+}
+
+template<typename VectorType,
+         typename IndexVectorType>
+inline
+void // destination[index[i]]+=values[i], even when indices are repeated
+scatter_add(Simd<VectorType> values,
+            Simd<IndexVectorType> index,
+            typename Simd<VectorType>::value_type *destination)
+{
+  using value_simd_t = Simd<VectorType>;
+  using index_t = Simd<IndexVectorType>;
+  static_assert(index_t::value_count==value_simd_t::value_count,
+                "index/value count mismatch");
+#if __AVX512CD__
+  if constexpr(impl_::native_gather_scatter_<index_t,
+                 typename value_simd_t::value_type>&&
+               (index_t::vector_size==64)&&(value_simd_t::vector_size==64))
+  {
+    // the last lane of each group of repeated indices holds the whole sum
+    // of the group and is stored last
+    const auto sum=impl_::conflict_sum_(values, index);
+    scatter(gather(index, destination)+sum, index, destination);
+    return;
+  }
+#endif
+  for(auto i=0; i<value_simd_t::value_count; ++i)
+  {
+    destination[index[i]]+=values[i];
+  }
+}
+
+//~~~~ math functions ~~~~
+
+template<typename VectorType,
+         typename Fnct>
+auto
+transform(Simd<VectorType> s,
+          Fnct fnct)
+{
+  // hopefuly, for simple math functions, the compiler will be able
+  // to call the appropriate simd instruction; in other cases it
+  // will serialise the calls
+  VectorType result{};
+  for(auto i=0; i<s.value_count; ++i)
+  {
+    result[i]=fnct(s[i]);
+  }
+  return Simd{result};
+}
+
+#define DIM_SIMD_TRANSFORM_STD_MATH(name) \
+        template<typename VectorType> \
+        auto \
+        name(Simd<VectorType> s) \
+        { \
+          using value_t = typename Simd<VectorType>::value_type; \
+          return transform(s, static_cast<value_t (*)(value_t)>(std::name)); \
+        }
+
+DIM_SIMD_TRANSFORM_STD_MATH(fabs)
+DIM_SIMD_TRANSFORM_STD_MATH(sqrt)
+DIM_SIMD_TRANSFORM_STD_MATH(cbrt)
+DIM_SIMD_TRANSFORM_STD_MATH(asin)
+DIM_SIMD_TRANSFORM_STD_MATH(acos)
+DIM_SIMD_TRANSFORM_STD_MATH(sinh)
+DIM_SIMD_TRANSFORM_STD_MATH(cosh)
+DIM_SIMD_TRANSFORM_STD_MATH(ceil)
+DIM_SIMD_TRANSFORM_STD_MATH(floor)
+DIM_SIMD_TRANSFORM_STD_MATH(trunc)
+DIM_SIMD_TRANSFORM_STD_MATH(round)
+
+#undef DIM_SIMD_TRANSFORM_STD_MATH
+
+// exp, log, sin, cos, tan, atan and tanh are actually vectorised
+// (see simd_math.hpp, included at the end of this file, as well as
+// simd_multi.hpp which packs several vectors for unrolling)
+
+//~~~~ horizontal operations ~~~~
+
+namespace impl_ {
+
+template<int Half,
+         typename VectorType,
+         typename BinaryOp>
+inline
+auto
+horizontal_fold_(Simd<VectorType> s,
+                 BinaryOp op)
+{
+  if constexpr(Half==0)
+  {
+    return s[0];
+  }
+  else
+  {
+    // only the lanes below Half are meaningful from now on
+    return horizontal_fold_<Half/2>(Simd<VectorType>{op(s, down<Half>(s))},
+                                    op);
+  }
+}
+
+} // namespace impl_
+
+template<typename VectorType,
+         typename BinaryOp>
+inline
+auto // op(op(s[0], s[c/2]), op(s[c/4], s[3*c/4]))... in log2(c) shuffles
+horizontal_reduce(const Simd<VectorType> &s,
+                  BinaryOp op)
+{
+  return impl_::horizontal_fold_<Simd<VectorType>::value_count/2>(s, op);
+}
+
+template<typename VectorType>
+inline
+auto
+horizontal_sum(const Simd<VectorType> &s)
+{
+  return horizontal_reduce(s, std::plus<>{});
+}
+
+template<typename VectorType>
+inline
+auto
+horizontal_product(const Simd<VectorType> &s)
+{
+  return horizontal_reduce(s, std::multiplies<>{});
+}
+
+template<typename VectorType>
+inline
+auto
+horizontal_fmin(const Simd<VectorType> &s)
+{
+  return horizontal_reduce(s,
+    [](const auto &a, const auto &b)
+    {
+      return fmin(a, b);
+    });
+}
+
+template<typename VectorType>
+inline
+auto
+horizontal_fmax(const Simd<VectorType> &s)
+{
+  return horizontal_reduce(s,
+    [](const auto &a, const auto &b)
+    {
+      return fmax(a, b);
+    });
+}
+
+template<typename VectorType>
+inline
+bool
+horizontal_null(const Simd<VectorType> &s)
+{
+  using value_t = typename Simd<VectorType>::value_type;
+  return horizontal_reduce(s, std::bit_or<>{})==value_t{};
+}
+
+//~~~~ mask operations ~~~~
+
+// the lanes of a mask are expected to be all-zero or all-one bits, as
+// produced by comparisons and lane_mask()
+
+template<typename VectorType>
+inline
+auto // bit i set when lane i of mask is set (uint8_t to uint64_t)
+movemask(Simd<VectorType> mask)
+{
+  return impl_::mask_bits_(mask);
+}
+
+template<typename VectorType>
+inline
+bool
+any(Simd<VectorType> mask)
+{
+  return movemask(mask)!=0;
+}
+
+template<typename VectorType>
+inline
+bool
+all(Simd<VectorType> mask)
+{
+  constexpr auto value_count=Simd<VectorType>::value_count;
+  const auto bits=std::uint64_t{movemask(mask)};
+  return bits==(value_count==64 ? ~std::uint64_t{}
+                                : (std::uint64_t{1}<<value_count)-1);
+}
+
+template<typename VectorType>
+inline
+bool
+none(Simd<VectorType> mask)
+{
+  return movemask(mask)==0;
+}
+
+template<typename VectorType>
+inline
+int // number of set lanes
+count_true(Simd<VectorType> mask)
+{
+  return __builtin_popcountll(movemask(mask));
+}
+
+template<typename VectorType>
+inline
+int // index of the first set lane, value_count if none
+first_set(Simd<VectorType> mask)
+{
+  const auto bits=std::uint64_t{movemask(mask)};
+  return bits ? __builtin_ctzll(bits) : Simd<VectorType>::value_count;
+}
+
+namespace impl_ {
+
+template<bool Compress,
+         typename VectorType,
+         typename MaskVectorType>
+inline
+Simd<VectorType> // compress() or expand()
+compress_expand_(Simd<VectorType> s,
+                 Simd<MaskVectorType> mask)
+{
+  using simd_t = Simd<VectorType>;
+  using vector_t = VectorType;
+  constexpr auto value_count=simd_t::value_count;
+  static_assert(value_count==Simd<MaskVectorType>::value_count,
+                "mask/value count mismatch");
+  [[maybe_unused]] constexpr auto vector_size=simd_t::vector_size;
+  [[maybe_unused]] constexpr auto value_size=simd_t::value_size;
+  [[maybe_unused]] const auto k=mask_bits_(mask);
+#if __AVX512F__
+  if constexpr((vector_size==64)&&(value_size>=4))
+  {
+    const auto v=reinterpret_cast<__m512i>(s.vec());
+    const auto r=(value_size==4)
+      ? (Compress ? _mm512_maskz_compress_epi32(k, v)
+                  : _mm512_maskz_expand_epi32(k, v))
+      : (Compress ? _mm512_maskz_compress_epi64(__mmask8(k), v)
+                  : _mm512_maskz_expand_epi64(__mmask8(k), v));
+    return {reinterpret_cast<vector_t>(r)};
+  }
+#endif
+#if __AVX512VBMI2__
+  if constexpr((vector_size==64)&&(value_size<=2))
+  {
+    const auto v=reinterpret_cast<__m512i>(s.vec());
+    if constexpr(value_size==2)
+    {
+      return {reinterpret_cast<vector_t>(
+        Compress ? _mm512_maskz_compress_epi16(k, v)
+                 : _mm512_maskz_expand_epi16(k, v))};
+    }
+    else
+    {
+      return {reinterpret_cast<vector_t>(
+        Compress ? _mm512_maskz_compress_epi8(k, v)
+                 : _mm512_maskz_expand_epi8(k, v))};
+    }
+  }
+#endif
+#if __AVX512VL__
+  if constexpr((vector_size==32)&&(value_size>=4))
+  {
+    const auto v=reinterpret_cast<__m256i>(s.vec());
+    const auto r=(value_size==4)
+      ? (Compress ? _mm256_maskz_compress_epi32(k, v)
+                  : _mm256_maskz_expand_epi32(k, v))
+      : (Compress ? _mm256_maskz_compress_epi64(k, v)
+                  : _mm256_maskz_expand_epi64(k, v));
+    return {reinterpret_cast<vector_t>(r)};
+  }
+  if constexpr((vector_size==16)&&(value_size>=4))
+  {
+    const auto v=reinterpret_cast<__m128i>(s.vec());
+    const auto r=(value_size==4)
+      ? (Compress ? _mm_maskz_compress_epi32(k, v)
+                  : _mm_maskz_expand_epi32(k, v))
+      : (Compress ? _mm_maskz_compress_epi64(k, v)
+                  : _mm_maskz_expand_epi64(k, v));
+    return {reinterpret_cast<vector_t>(r)};
+  }
+#elif __AVX2__ && __BMI2__
+  if constexpr((vector_size==32)&&(value_size>=4))
+  {
+    // one byte per 32-bit lane (two for 64-bit values) selects the lane
+    // indices to be moved, then a single cross-lane permutation
+    const auto k32=(value_size==4) ? std::uint32_t(k)
+                                   : _pdep_u32(k, 0x55u)*3u;
+    const auto bytes=_pdep_u64(k32, 0x0101010101010101ull)*0xFFull;
+    const auto lanes=0x0706050403020100ull;
+    const auto index=Compress ? _pext_u64(lanes, bytes)
+                              : _pdep_u64(lanes, bytes);
+    const auto r=_mm256_permutevar8x32_epi32(
+      reinterpret_cast<__m256i>(s.vec()),
+      _mm256_cvtepu8_epi32(_mm_cvtsi64_si128(
+        static_cast<long long>(index))));
+    const auto keep=Compress
+      ? _pext_u64(bytes, bytes) // the lowest popcount(k32) bytes
+      : bytes;
+    const auto m=_mm256_cvtepi8_epi32(_mm_cvtsi64_si128(
+      static_cast<long long>(keep)));
+    return {reinterpret_cast<vector_t>(_mm256_and_si256(r, m))};
+  }
+#endif
+  // no branch: n never exceeds i, the extra lanes are finally cleared
+  auto result=vector_t{};
+  auto n=0;
+  for(auto i=0; i<value_count; ++i)
+  {
+    const auto selected=int((k>>i)&1);
+    if constexpr(Compress)
+    {
+      result[n]=s[i];
+    }
+    else
+    {
+      result[i]=s[n];
+    }
+    n+=selected;
+  }
+  if constexpr(Compress)
+  {
+    return select(lane_mask<simd_t>(0, n), simd_t{result}, simd_t{});
+  }
+  else
+  {
+    return select(mask, simd_t{result}, simd_t{});
+  }
+}
+
+} // namespace impl_
+
+template<typename VectorType,
+         typename MaskVectorType>
+inline
+auto // the lanes of s selected by mask, packed in the lowest lanes, then zero
+compress(Simd<VectorType> s,
+         Simd<MaskVectorType> mask)
+{
+  return impl_::compress_expand_<true>(s, mask);
+}
+
+template<typename VectorType,
+         typename MaskVectorType>
+inline
+auto // the lowest lanes of s, spread in the lanes selected by mask, else zero
+expand(Simd<VectorType> s,
+       Simd<MaskVectorType> mask)
+{
+  return impl_::compress_expand_<false>(s, mask);
+}
+
+template<typename VectorType,
+         typename MaskVectorType>
+inline
+int // the count_true(mask) values of compress(s, mask) to unaligned_addr
+compress_store(typename Simd<VectorType>::value_type *unaligned_addr,
+               Simd<VectorType> s,
+               Simd<MaskVectorType> mask)
+{
+  // nothing is written beyond the stored values
+  const auto count=count_true(mask);
+#if __AVX512F__
+  if constexpr((Simd<VectorType>::vector_size==64)&&
+               (Simd<VectorType>::value_size>=4))
+  {
+    const auto k=impl_::mask_bits_(mask);
+    const auto v=reinterpret_cast<__m512i>(s.vec());
+    if constexpr(Simd<VectorType>::value_size==4)
+    {
+      _mm512_mask_compressstoreu_epi32(unaligned_addr, k, v);
+    }
+    else
+    {
+      _mm512_mask_compressstoreu_epi64(unaligned_addr, __mmask8(k), v);
+    }
+    return count;
+  }
+#endif
+  store_suffix(unaligned_addr, count, compress(s, mask));
+  return count;
+}
+
+//~~~~ display operations ~~~~
+
+template<typename VectorType>
+inline
+std::string
+to_string(const Simd<VectorType> &s)
+{
+  auto result=std::string{'{'};
   for(auto i=0; i<s.value_count; ++i)
   {
     if(i!=0)
@@ -1062,6 +2280,10 @@ operator<<(std::ostream &os,
 
 } // namespace dim::simd
 
+#include "simd_math.hpp"
+#include "simd_integer.hpp"
+#include "simd_multi.hpp"
+
 #endif // DIM_SIMD_HPP
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
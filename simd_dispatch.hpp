@@ -0,0 +1,162 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef DIM_SIMD_DISPATCH_HPP
+#define DIM_SIMD_DISPATCH_HPP
+
+#include "simd.hpp"
+
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+// The same kernel body is compiled for every vector size (16, 32 and 64
+// bytes on x86) and the widest one the running cpu supports is selected,
+// whatever the compiler options.  The kernel is a generic callable which
+// receives the vector size as an std::integral_constant<int, N>, so that it
+// can be forwarded as the VectorSize parameter of the AlignedBuffer kernels:
+//
+//   team.run(
+//     [&](int part_id, int part_count)
+//     {
+//       dim::simd::dispatch(
+//         [&](auto vector_size)
+//         {
+//           dim::apply1<vector_size()>(buffer, part_id, part_count,
+//             [&](auto &p) { p*=2; });
+//         });
+//     });
+//
+// Everything called by the kernel is inlined into a function compiled with
+// the suitable target attribute; thus the dispatch must happen inside the
+// job of each part (the Team machinery itself is not compiled for the wider
+// instructions).
+//
+// Only the code which relies on the vector extensions of the compiler (the
+// arithmetic, comparisons, select(), load_a/u(), store_a/u(), the shuffles
+// and the functions of simd_math.hpp) benefits from the wider instructions.
+// The operations which call intrinsics are chosen at compile time from the
+// isa macros of the compiler options (__AVX2__, __AVX512F__...), thus, in a
+// dispatched kernel, they keep using their generic (per-lane or emulated)
+// code:
+//   - masked_load() and masked_store() (also used for the tails of the
+//     AlignedBuffer kernels), movemask() and the mask reductions,
+//   - gather(), scatter(), scatter_add() and the conflict detection,
+//   - compress(), expand() and compress_store(),
+//   - store_stream() on 32- and 64-byte vectors (a plain store),
+//   - the saturating, averaging and widening operations of simd_integer.hpp.
+// The kernels of reduce.hpp and AlignedBuffer2D do not take a vector size
+// and always use default_vector_size, which follows the compiler options.
+// When these operations matter, the program should rather be compiled with
+// the suitable -m options (several times, for several targets).
+//
+// The wider vectors make g++ report the change of their calling convention
+// (a note, "the ABI for passing parameters with 64-byte alignment has
+// changed"); it does not matter since everything is inlined, but this note
+// cannot be silenced from a header: compile with -Wno-psabi.
+
+namespace dim::simd {
+
+inline
+int // widest vector size (in bytes) supported by the cpu and the os
+dispatch_vector_size()
+{
+  static const auto vector_size=[]()
+  {
+#if __i386__ || __x86_64__
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f")&&
+       __builtin_cpu_supports("avx512bw")&&
+       __builtin_cpu_supports("avx512dq")&&
+       __builtin_cpu_supports("avx512vl"))
+    {
+      return std::max(64, max_vector_size);
+    }
+    if(__builtin_cpu_supports("avx2")&&
+       __builtin_cpu_supports("fma"))
+    {
+      return std::max(32, max_vector_size);
+    }
+    return std::max(16, max_vector_size);
+#else
+    return max_vector_size;
+#endif
+  }();
+  return vector_size;
+}
+
+namespace impl_ {
+
+#if __i386__ || __x86_64__
+template<typename Fnct>
+__attribute__((target("avx512f,avx512bw,avx512dq,avx512vl,"
+                      "avx2,fma,bmi,bmi2"), flatten))
+inline
+decltype(auto)
+dispatch_64_(Fnct &fnct)
+{
+  return fnct(std::integral_constant<int, 64>{});
+}
+
+template<typename Fnct>
+__attribute__((target("avx2,fma,bmi,bmi2"), flatten))
+inline
+decltype(auto)
+dispatch_32_(Fnct &fnct)
+{
+  return fnct(std::integral_constant<int, 32>{});
+}
+#endif
+
+} // namespace impl_
+
+template<typename Fnct>
+inline
+decltype(auto) // fnct(std::integral_constant<int, N>) for the widest N
+               // which is supported and does not exceed vector_size
+dispatch(int vector_size,
+         Fnct &&fnct)
+{
+  const auto supported=std::min(vector_size, dispatch_vector_size());
+#if __i386__ || __x86_64__
+  if(supported>=64)
+  {
+    if constexpr(max_vector_size>=64)
+    {
+      return fnct(std::integral_constant<int, 64>{});
+    }
+    else
+    {
+      return impl_::dispatch_64_(fnct);
+    }
+  }
+  if(supported>=32)
+  {
+    if constexpr(max_vector_size>=32)
+    {
+      return fnct(std::integral_constant<int, 32>{});
+    }
+    else
+    {
+      return impl_::dispatch_32_(fnct);
+    }
+  }
+  return fnct(std::integral_constant<int, 16>{});
+#else
+  static_cast<void>(supported);
+  return fnct(std::integral_constant<int, max_vector_size>{});
+#endif
+}
+
+template<typename Fnct>
+inline
+decltype(auto) // fnct(std::integral_constant<int, N>) for the widest N
+dispatch(Fnct &&fnct)
+{
+  return dispatch(dispatch_vector_size_limit, std::forward<Fnct>(fnct));
+}
+
+} // namespace dim::simd
+
+#endif // DIM_SIMD_DISPATCH_HPP
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -0,0 +1,485 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef DIM_SIMD_INTEGER_HPP
+#define DIM_SIMD_INTEGER_HPP
+
+#include "simd.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+// Saturating, averaging and widening arithmetic for the integer simd types,
+// as needed by 8-bit and 16-bit image kernels (which would otherwise have
+// to widen everything to 32-bit by hand).  Each function maps to a single
+// SSE2, AVX2 or AVX-512BW instruction when one exists for the value type,
+// and to portable vector code otherwise.
+//
+//   adds(a, b), subs(a, b)  a+b, a-b clamped to the range of the type
+//   avg(a, b)               (a+b+1)>>1 without overflow
+//   mulhi(a, b)             high half of the double-width product
+//   absdiff(a, b)           |a-b|
+//   widen_low(s)            lanes of the lower half of s, with twice the
+//   widen_high(s)           width (zero or sign extension)
+//   narrow<R>(low, high)    all the lanes of low then high, converted to R
+//                           with saturation (packus/packs)
+//   sad(a, b)               for u8: sum of |a-b| over each group of 8 lanes,
+//                           in the u64 lanes of the same vector size
+
+namespace dim::simd {
+
+namespace impl_ {
+
+template<typename T>
+using wider_t_ =
+  std::conditional_t<std::is_signed_v<T>,
+    std::conditional_t<sizeof(T)==1, std::int16_t,
+    std::conditional_t<sizeof(T)==2, std::int32_t, std::int64_t>>,
+    std::conditional_t<sizeof(T)==1, std::uint16_t,
+    std::conditional_t<sizeof(T)==2, std::uint32_t, std::uint64_t>>>;
+
+template<typename VectorType>
+inline
+auto // same bits, as unsigned integers (no undefined overflow)
+as_unsigned_(Simd<VectorType> s)
+{
+  using value_t = typename Simd<VectorType>::value_type;
+  using u_t = simd_t<std::make_unsigned_t<value_t>,
+                     Simd<VectorType>::vector_size>;
+  return u_t{reinterpret_cast<typename u_t::vector_type>(s.vec())};
+}
+
+template<typename SimdType,
+         typename VectorType>
+inline
+SimdType
+from_unsigned_(Simd<VectorType> s)
+{
+  return {reinterpret_cast<typename SimdType::vector_type>(s.vec())};
+}
+
+} // namespace impl_
+
+#if __i386__ || __x86_64__
+# define DIM_SIMD_INTEGER_NATIVE(condition, bits, intrinsic) \
+         if constexpr(condition) \
+         { \
+           return simd_t{reinterpret_cast<typename simd_t::vector_type>( \
+             intrinsic(reinterpret_cast<__m##bits##i>(a.vec()), \
+                       reinterpret_cast<__m##bits##i>(b.vec())))}; \
+         }
+// one case per isa for 8-bit and 16-bit values, unsigned then signed
+# if __AVX512BW__
+#  define DIM_SIMD_INTEGER_NATIVE_512(size, u8, i8, u16, i16) \
+          DIM_SIMD_INTEGER_NATIVE((vs==64)&&((size)==1)&&u, 512, u8) \
+          DIM_SIMD_INTEGER_NATIVE((vs==64)&&((size)==1)&&!u, 512, i8) \
+          DIM_SIMD_INTEGER_NATIVE((vs==64)&&((size)==2)&&u, 512, u16) \
+          DIM_SIMD_INTEGER_NATIVE((vs==64)&&((size)==2)&&!u, 512, i16)
+# else
+#  define DIM_SIMD_INTEGER_NATIVE_512(size, u8, i8, u16, i16)
+# endif
+# if __AVX2__
+#  define DIM_SIMD_INTEGER_NATIVE_256(size, u8, i8, u16, i16) \
+          DIM_SIMD_INTEGER_NATIVE((vs==32)&&((size)==1)&&u, 256, u8) \
+          DIM_SIMD_INTEGER_NATIVE((vs==32)&&((size)==1)&&!u, 256, i8) \
+          DIM_SIMD_INTEGER_NATIVE((vs==32)&&((size)==2)&&u, 256, u16) \
+          DIM_SIMD_INTEGER_NATIVE((vs==32)&&((size)==2)&&!u, 256, i16)
+# else
+#  define DIM_SIMD_INTEGER_NATIVE_256(size, u8, i8, u16, i16)
+# endif
+# if __SSE2__
+#  define DIM_SIMD_INTEGER_NATIVE_128(size, u8, i8, u16, i16) \
+          DIM_SIMD_INTEGER_NATIVE((vs==16)&&((size)==1)&&u, 128, u8) \
+          DIM_SIMD_INTEGER_NATIVE((vs==16)&&((size)==1)&&!u, 128, i8) \
+          DIM_SIMD_INTEGER_NATIVE((vs==16)&&((size)==2)&&u, 128, u16) \
+          DIM_SIMD_INTEGER_NATIVE((vs==16)&&((size)==2)&&!u, 128, i16)
+# else
+#  define DIM_SIMD_INTEGER_NATIVE_128(size, u8, i8, u16, i16)
+# endif
+# define DIM_SIMD_INTEGER_NATIVE_ALL(size, name, u8, i8, u16, i16) \
+         DIM_SIMD_INTEGER_NATIVE_512(size, _mm512_##name##_##u8, \
+           _mm512_##name##_##i8, _mm512_##name##_##u16, \
+           _mm512_##name##_##i16) \
+         DIM_SIMD_INTEGER_NATIVE_256(size, _mm256_##name##_##u8, \
+           _mm256_##name##_##i8, _mm256_##name##_##u16, \
+           _mm256_##name##_##i16) \
+         DIM_SIMD_INTEGER_NATIVE_128(size, _mm_##name##_##u8, \
+           _mm_##name##_##i8, _mm_##name##_##u16, \
+           _mm_##name##_##i16)
+#else
+# define DIM_SIMD_INTEGER_NATIVE_ALL(size, name, u8, i8, u16, i16)
+#endif
+
+#define DIM_SIMD_INTEGER_PROLOGUE \
+        using simd_t = Simd<VectorType>; \
+        using value_t = typename simd_t::value_type; \
+        static_assert(std::is_integral_v<value_t>, \
+                      "integer simd type expected"); \
+        [[maybe_unused]] constexpr auto vs=simd_t::vector_size; \
+        [[maybe_unused]] constexpr auto size=simd_t::value_size; \
+        [[maybe_unused]] constexpr auto u=std::is_unsigned_v<value_t>;
+
+template<typename VectorType>
+inline
+auto // a+b, clamped to the range of the value type
+adds(Simd<VectorType> a,
+     Simd<VectorType> b)
+{
+  DIM_SIMD_INTEGER_PROLOGUE
+  DIM_SIMD_INTEGER_NATIVE_ALL(size, adds, epu8, epi8, epu16, epi16)
+  const auto r=impl_::from_unsigned_<simd_t>(
+    impl_::as_unsigned_(a)+impl_::as_unsigned_(b));
+  constexpr auto hi=std::numeric_limits<value_t>::max();
+  if constexpr(u)
+  {
+    return select(r<a, simd_t{hi}, r);
+  }
+  else
+  {
+    // overflow when a and b have the same sign, which r does not have
+    constexpr auto lo=std::numeric_limits<value_t>::min();
+    return select(((a^r)&(b^r))<value_t{0},
+                  select(a<value_t{0}, simd_t{lo}, simd_t{hi}), r);
+  }
+}
+
+template<typename VectorType>
+inline
+auto // a-b, clamped to the range of the value type
+subs(Simd<VectorType> a,
+     Simd<VectorType> b)
+{
+  DIM_SIMD_INTEGER_PROLOGUE
+  DIM_SIMD_INTEGER_NATIVE_ALL(size, subs, epu8, epi8, epu16, epi16)
+  const auto r=impl_::from_unsigned_<simd_t>(
+    impl_::as_unsigned_(a)-impl_::as_unsigned_(b));
+  if constexpr(u)
+  {
+    return select(a<b, simd_t{}, r);
+  }
+  else
+  {
+    // overflow when a and b have different signs, and r not the one of a
+    constexpr auto lo=std::numeric_limits<value_t>::min();
+    constexpr auto hi=std::numeric_limits<value_t>::max();
+    return select(((a^b)&(a^r))<value_t{0},
+                  select(a<value_t{0}, simd_t{lo}, simd_t{hi}), r);
+  }
+}
+
+template<typename VectorType>
+inline
+auto // (a+b+1)>>1, without overflow
+avg(Simd<VectorType> a,
+    Simd<VectorType> b)
+{
+  DIM_SIMD_INTEGER_PROLOGUE
+  if constexpr(u)
+  {
+    // only unsigned averages exist (epi8/epi16 are never selected here)
+    DIM_SIMD_INTEGER_NATIVE_ALL(size, avg, epu8, epu8, epu16, epu16)
+  }
+  // a+b=2*(a&b)+(a^b), and the shift rounds down, even for negative values
+  return (a&b)+((a^b)-((a^b)>>1));
+}
+
+template<typename VectorType>
+inline
+auto // high half of the double-width product a*b
+mulhi(Simd<VectorType> a,
+      Simd<VectorType> b)
+{
+  DIM_SIMD_INTEGER_PROLOGUE
+  static_assert(size<=4, "no wider type for the product");
+  // only 16-bit values (the 8-bit cases never match)
+  DIM_SIMD_INTEGER_NATIVE_ALL((size==2) ? 2 : 0,
+                              mulhi, epu16, epi16, epu16, epi16)
+  using wide_t = impl_::wider_t_<value_t>;
+  auto result=VectorType{};
+  for(auto i=0; i<simd_t::value_count; ++i)
+  {
+    result[i]=value_t((wide_t(a[i])*wide_t(b[i]))>>(8*size));
+  }
+  return simd_t{result};
+}
+
+#undef DIM_SIMD_INTEGER_NATIVE_ALL
+#undef DIM_SIMD_INTEGER_NATIVE_512
+#undef DIM_SIMD_INTEGER_NATIVE_256
+#undef DIM_SIMD_INTEGER_NATIVE_128
+#undef DIM_SIMD_INTEGER_NATIVE
+
+template<typename VectorType>
+inline
+auto // |a-b|, as the value type (thus wraps for extreme signed values)
+absdiff(Simd<VectorType> a,
+        Simd<VectorType> b)
+{
+  DIM_SIMD_INTEGER_PROLOGUE
+  if constexpr(u)
+  {
+    return subs(a, b)|subs(b, a); // one of them is zero
+  }
+  else
+  {
+    // in unsigned arithmetic, the difference which is not kept may wrap
+    const auto ua=impl_::as_unsigned_(a), ub=impl_::as_unsigned_(b);
+    return impl_::from_unsigned_<simd_t>(select(a>b, ua-ub, ub-ua));
+  }
+}
+
+namespace impl_ {
+
+template<bool High,
+         typename VectorType>
+inline
+auto
+widen_(Simd<VectorType> s)
+{
+  using arg_t = Simd<VectorType>;
+  using value_t = typename arg_t::value_type;
+  static_assert(std::is_integral_v<value_t>&&(arg_t::value_size<=4),
+                "8-bit to 32-bit integer simd type expected");
+  using wide_t = wider_t_<value_t>;
+  using result_t = simd_t<wide_t, arg_t::vector_size>;
+  using result_v = typename result_t::vector_type;
+  [[maybe_unused]] constexpr auto vs=arg_t::vector_size;
+  [[maybe_unused]] constexpr auto size=arg_t::value_size;
+  [[maybe_unused]] constexpr auto u=std::is_unsigned_v<value_t>;
+#if __AVX512BW__
+  if constexpr(vs==64)
+  {
+    // the masked forms avoid the uninitialised placeholders of gcc
+    const auto v=reinterpret_cast<__m512i>(s.vec());
+    const auto h=_mm512_maskz_extracti64x4_epi64(0xF, v, High ? 1 : 0);
+    auto r=__m512i{};
+    if constexpr(size==1)
+    {
+      r=u ? _mm512_maskz_cvtepu8_epi16(__mmask32(-1), h)
+          : _mm512_maskz_cvtepi8_epi16(__mmask32(-1), h);
+    }
+    else if constexpr(size==2)
+    {
+      r=u ? _mm512_maskz_cvtepu16_epi32(__mmask16(-1), h)
+          : _mm512_maskz_cvtepi16_epi32(__mmask16(-1), h);
+    }
+    else
+    {
+      r=u ? _mm512_maskz_cvtepu32_epi64(__mmask8(-1), h)
+          : _mm512_maskz_cvtepi32_epi64(__mmask8(-1), h);
+    }
+    return result_t{reinterpret_cast<result_v>(r)};
+  }
+#endif
+#if __AVX2__
+  if constexpr(vs==32)
+  {
+    const auto v=reinterpret_cast<__m256i>(s.vec());
+    const auto h=High ? _mm256_extracti128_si256(v, 1)
+                      : _mm256_castsi256_si128(v);
+    const auto r=(size==1) ? (u ? _mm256_cvtepu8_epi16(h)
+                                : _mm256_cvtepi8_epi16(h))
+               : (size==2) ? (u ? _mm256_cvtepu16_epi32(h)
+                                : _mm256_cvtepi16_epi32(h))
+                           : (u ? _mm256_cvtepu32_epi64(h)
+                                : _mm256_cvtepi32_epi64(h));
+    return result_t{reinterpret_cast<result_v>(r)};
+  }
+#endif
+#if __SSE2__
+  if constexpr(vs==16)
+  {
+    // interleaving with zero, or with the sign, extends the values
+    const auto v=reinterpret_cast<__m128i>(s.vec());
+    const auto zero=_mm_setzero_si128();
+    const auto ext=u ? zero
+                     : (size==1) ? _mm_cmpgt_epi8(zero, v)
+                     : (size==2) ? _mm_cmpgt_epi16(zero, v)
+                                 : _mm_cmpgt_epi32(zero, v);
+    const auto r=High ? ((size==1) ? _mm_unpackhi_epi8(v, ext)
+                       : (size==2) ? _mm_unpackhi_epi16(v, ext)
+                                   : _mm_unpackhi_epi32(v, ext))
+                      : ((size==1) ? _mm_unpacklo_epi8(v, ext)
+                       : (size==2) ? _mm_unpacklo_epi16(v, ext)
+                                   : _mm_unpacklo_epi32(v, ext));
+    return result_t{reinterpret_cast<result_v>(r)};
+  }
+#endif
+  constexpr auto offset=High ? result_t::value_count : 0;
+  auto result=result_v{};
+  for(auto i=0; i<result_t::value_count; ++i)
+  {
+    result[i]=wide_t(s[offset+i]);
+  }
+  return result_t{result};
+}
+
+} // namespace impl_
+
+template<typename VectorType>
+inline
+auto // the lanes of the lower half of s, with twice the width
+widen_low(Simd<VectorType> s)
+{
+  return impl_::widen_<false>(s);
+}
+
+template<typename VectorType>
+inline
+auto // the lanes of the upper half of s, with twice the width
+widen_high(Simd<VectorType> s)
+{
+  return impl_::widen_<true>(s);
+}
+
+template<typename ResultValueType,
+         typename VectorType>
+inline
+auto // the lanes of low then high, converted with saturation
+narrow(Simd<VectorType> low,
+       Simd<VectorType> high)
+{
+  using arg_t = Simd<VectorType>;
+  using value_t = typename arg_t::value_type;
+  using narrow_t = ResultValueType;
+  static_assert(std::is_integral_v<value_t>&&std::is_integral_v<narrow_t>&&
+                (arg_t::value_size==2*int(sizeof(narrow_t))),
+                "integer values of half the size expected");
+  using result_t = simd_t<narrow_t, arg_t::vector_size>;
+  using result_v = typename result_t::vector_type;
+  [[maybe_unused]] constexpr auto vs=arg_t::vector_size;
+  [[maybe_unused]] constexpr auto size=int(sizeof(narrow_t));
+  [[maybe_unused]] constexpr auto u=std::is_unsigned_v<narrow_t>;
+  // packus/packs consider signed inputs; they work within 128-bit lanes,
+  // thus the 64-bit blocks must then be reordered
+  [[maybe_unused]] constexpr auto native=
+    std::is_signed_v<value_t>&&(size<=2);
+#if __AVX512BW__
+  if constexpr(native&&(vs==64))
+  {
+    const auto l=reinterpret_cast<__m512i>(low.vec());
+    const auto h=reinterpret_cast<__m512i>(high.vec());
+    const auto r=(size==1) ? (u ? _mm512_packus_epi16(l, h)
+                                : _mm512_packs_epi16(l, h))
+                           : (u ? _mm512_packus_epi32(l, h)
+                                : _mm512_packs_epi32(l, h));
+    const auto order=_mm512_setr_epi64(0, 2, 4, 6, 1, 3, 5, 7);
+    return result_t{reinterpret_cast<result_v>(
+      _mm512_maskz_permutexvar_epi64(0xFF, order, r))};
+  }
+#endif
+#if __AVX2__
+  if constexpr(native&&(vs==32))
+  {
+    const auto l=reinterpret_cast<__m256i>(low.vec());
+    const auto h=reinterpret_cast<__m256i>(high.vec());
+    const auto r=(size==1) ? (u ? _mm256_packus_epi16(l, h)
+                                : _mm256_packs_epi16(l, h))
+                           : (u ? _mm256_packus_epi32(l, h)
+                                : _mm256_packs_epi32(l, h));
+    return result_t{reinterpret_cast<result_v>(
+      _mm256_permute4x64_epi64(r, 0xD8))};
+  }
+#endif
+#if __SSE2__
+  // no 32-bit to unsigned 16-bit before SSE4.1
+# if __SSE4_1__
+  constexpr auto packus32=true;
+# else
+  constexpr auto packus32=false;
+# endif
+  if constexpr(native&&(vs==16)&&((size==1)||!u||packus32))
+  {
+    const auto l=reinterpret_cast<__m128i>(low.vec());
+    const auto h=reinterpret_cast<__m128i>(high.vec());
+    if constexpr(size==1)
+    {
+      return result_t{reinterpret_cast<result_v>(
+        u ? _mm_packus_epi16(l, h) : _mm_packs_epi16(l, h))};
+    }
+    else if constexpr(!u)
+    {
+      return result_t{reinterpret_cast<result_v>(_mm_packs_epi32(l, h))};
+    }
+# if __SSE4_1__
+    else
+    {
+      return result_t{reinterpret_cast<result_v>(_mm_packus_epi32(l, h))};
+    }
+# endif
+  }
+#endif
+  constexpr auto lo=std::numeric_limits<narrow_t>::min();
+  constexpr auto hi=std::numeric_limits<narrow_t>::max();
+  constexpr auto half=arg_t::value_count;
+  auto result=result_v{};
+  for(auto i=0; i<result_t::value_count; ++i)
+  {
+    const auto v=(i<half) ? low[i] : high[i-half];
+    // the limits of the narrow type fit in the wide one, except the
+    // negative lower limit when the wide type is unsigned
+    if constexpr(std::is_signed_v<value_t>)
+    {
+      if(v<value_t(lo))
+      {
+        result[i]=lo;
+        continue;
+      }
+    }
+    result[i]=(v>value_t(hi)) ? hi : narrow_t(v);
+  }
+  return result_t{result};
+}
+
+template<typename VectorType>
+inline
+auto // for u8: sum of |a-b| over each group of 8 lanes, in u64 lanes
+sad(Simd<VectorType> a,
+    Simd<VectorType> b)
+{
+  using arg_t = Simd<VectorType>;
+  static_assert(std::is_same_v<typename arg_t::value_type, std::uint8_t>,
+                "u8 simd type expected");
+  using result_t = simd_t<std::uint64_t, arg_t::vector_size>;
+  using result_v = typename result_t::vector_type;
+  [[maybe_unused]] constexpr auto vs=arg_t::vector_size;
+#if __AVX512BW__
+  if constexpr(vs==64)
+  {
+    return result_t{reinterpret_cast<result_v>(_mm512_sad_epu8(
+      reinterpret_cast<__m512i>(a.vec()),
+      reinterpret_cast<__m512i>(b.vec())))};
+  }
+#endif
+#if __AVX2__
+  if constexpr(vs==32)
+  {
+    return result_t{reinterpret_cast<result_v>(_mm256_sad_epu8(
+      reinterpret_cast<__m256i>(a.vec()),
+      reinterpret_cast<__m256i>(b.vec())))};
+  }
+#endif
+#if __SSE2__
+  if constexpr(vs==16)
+  {
+    return result_t{reinterpret_cast<result_v>(_mm_sad_epu8(
+      reinterpret_cast<__m128i>(a.vec()),
+      reinterpret_cast<__m128i>(b.vec())))};
+  }
+#endif
+  const auto d=absdiff(a, b);
+  auto result=result_v{};
+  for(auto i=0; i<arg_t::value_count; ++i)
+  {
+    result[i/8]+=d[i];
+  }
+  return result_t{result};
+}
+
+#undef DIM_SIMD_INTEGER_PROLOGUE
+
+} // namespace dim::simd
+
+#endif // DIM_SIMD_INTEGER_HPP
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -0,0 +1,626 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef DIM_SIMD_MULTI_HPP
+#define DIM_SIMD_MULTI_HPP
+
+#include "simd.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Multi<SimdType, N> packs N simd registers, called parts, and forwards
+// every operation to each of them.  These N operations are independent,
+// thus their latencies overlap: a kernel written once for simd values is
+// unrolled N times by simply changing its vector type (see the Unroll
+// parameter of the AlignedBuffer kernels).
+// Lane i is lane i%c of part i/c (c being SimdType::value_count), thus an
+// array of Multi has the same layout as an array of SimdType.
+
+namespace dim::simd {
+
+template<typename SimdType,
+         int N>
+class Multi
+{
+public:
+
+  static_assert(N>0, "positive part count expected");
+
+  using simd_type = SimdType;
+  using value_type = typename simd_type::value_type;
+  using mask_type = Multi<typename simd_type::mask_type, N>;
+
+  static constexpr auto part_count  = N;
+  static constexpr auto vector_size = N*simd_type::vector_size;
+  static constexpr auto value_size  = simd_type::value_size;
+  static constexpr auto value_count = N*simd_type::value_count;
+
+  constexpr Multi() : p_{} {}
+  constexpr Multi(value_type v) : p_{}
+  {
+    for(auto &p: p_)
+    {
+      p=simd_type{v};
+    }
+  }
+  constexpr Multi & operator=(value_type v) { return operator=(Multi{v}); }
+
+  template<typename... Parts,
+           typename =std::enable_if_t<sizeof...(Parts)==N>>
+  constexpr Multi(std::in_place_t, Parts... parts) : p_{parts...} {}
+
+  constexpr Multi(const Multi &) =default;
+  constexpr Multi & operator=(const Multi &) =default;
+  constexpr Multi(Multi &&) =default;
+  constexpr Multi & operator=(Multi &&) =default;
+  ~Multi() =default;
+
+  constexpr const simd_type & part(int i) const { return p_[i]; }
+  constexpr       simd_type & part(int i)       { return p_[i]; }
+
+  constexpr value_type operator[](int i) const
+  {
+    return p_[i/simd_type::value_count][i%simd_type::value_count];
+  }
+
+private:
+  simd_type p_[N];
+};
+
+template<typename ValueType,
+         int VectorSize,
+         int Unroll=1>
+using multi_t = std::conditional_t<Unroll==1,
+  simd_t<ValueType, VectorSize>,
+  Multi<simd_t<ValueType, VectorSize>, Unroll>>;
+
+namespace impl_ {
+
+template<typename Fnct,
+         int... Id>
+inline constexpr
+auto // Multi{fnct(0), fnct(1)...}
+multi_map_(Fnct fnct,
+           std::integer_sequence<int, Id...>)
+{
+  using part_t = std::decay_t<decltype(fnct(0))>;
+  return Multi<part_t, int(sizeof...(Id))>{
+    std::in_place, fnct(Id)...};
+}
+
+template<int N,
+         typename Fnct>
+inline constexpr
+auto
+multi_map_(Fnct fnct)
+{
+  return multi_map_(fnct, std::make_integer_sequence<int, N>{});
+}
+
+template<typename Fnct,
+         int... Id>
+inline constexpr
+void // fnct(0), fnct(1)...
+multi_for_(Fnct fnct,
+           std::integer_sequence<int, Id...>)
+{
+  (fnct(Id), ...);
+}
+
+template<int N,
+         typename Fnct>
+inline constexpr
+void
+multi_for_(Fnct fnct)
+{
+  multi_for_(fnct, std::make_integer_sequence<int, N>{});
+}
+
+} // namespace impl_
+
+//~~~~ arithmetic and logic operators ~~~~
+
+#define DIM_SIMD_MULTI_FORWARD_UNARY(op) \
+        template<typename SimdType, \
+                 int N> \
+        inline constexpr \
+        auto \
+        operator op(const Multi<SimdType, N> &rhs) \
+        { \
+          return impl_::multi_map_<N>( \
+            [&](int i) { return op rhs.part(i); }); \
+        }
+DIM_SIMD_MULTI_FORWARD_UNARY(+)
+DIM_SIMD_MULTI_FORWARD_UNARY(-)
+DIM_SIMD_MULTI_FORWARD_UNARY(~)
+#undef DIM_SIMD_MULTI_FORWARD_UNARY
+#define DIM_SIMD_MULTI_FORWARD_BINARY(op) \
+        template<typename LhsSimdType, \
+                 typename RhsSimdType, \
+                 int N> \
+        inline constexpr \
+        auto \
+        operator op(const Multi<LhsSimdType, N> &lhs, \
+                    const Multi<RhsSimdType, N> &rhs) \
+        { \
+          return impl_::multi_map_<N>( \
+            [&](int i) { return lhs.part(i) op rhs.part(i); }); \
+        } \
+        template<typename SimdType, \
+                 int N> \
+        inline constexpr \
+        auto \
+        operator op(const Multi<SimdType, N> &lhs, \
+                    typename SimdType::value_type rhs) \
+        { \
+          return impl_::multi_map_<N>( \
+            [&](int i) { return lhs.part(i) op rhs; }); \
+        } \
+        template<typename SimdType, \
+                 int N> \
+        inline constexpr \
+        auto \
+        operator op(typename SimdType::value_type lhs, \
+                    const Multi<SimdType, N> &rhs) \
+        { \
+          return impl_::multi_map_<N>( \
+            [&](int i) { return lhs op rhs.part(i); }); \
+        }
+#define DIM_SIMD_MULTI_FORWARD_BINARY_ASSIGN(op) \
+        DIM_SIMD_MULTI_FORWARD_BINARY(op) \
+        template<typename LhsSimdType, \
+                 typename RhsSimdType, \
+                 int N> \
+        inline constexpr \
+        auto & \
+        operator op##=(Multi<LhsSimdType, N> &lhs, \
+                       const Multi<RhsSimdType, N> &rhs) \
+        { \
+          impl_::multi_for_<N>( \
+            [&](int i) { lhs.part(i) op##= rhs.part(i); }); \
+          return lhs; \
+        } \
+        template<typename SimdType, \
+                 int N> \
+        inline constexpr \
+        auto & \
+        operator op##=(Multi<SimdType, N> &lhs, \
+                       typename SimdType::value_type rhs) \
+        { \
+          impl_::multi_for_<N>( \
+            [&](int i) { lhs.part(i) op##= rhs; }); \
+          return lhs; \
+        }
+DIM_SIMD_MULTI_FORWARD_BINARY_ASSIGN(+)
+DIM_SIMD_MULTI_FORWARD_BINARY_ASSIGN(-)
+DIM_SIMD_MULTI_FORWARD_BINARY_ASSIGN(*)
+DIM_SIMD_MULTI_FORWARD_BINARY_ASSIGN(/)
+DIM_SIMD_MULTI_FORWARD_BINARY_ASSIGN(%)
+DIM_SIMD_MULTI_FORWARD_BINARY_ASSIGN(&)
+DIM_SIMD_MULTI_FORWARD_BINARY_ASSIGN(|)
+DIM_SIMD_MULTI_FORWARD_BINARY_ASSIGN(^)
+DIM_SIMD_MULTI_FORWARD_BINARY_ASSIGN(<<)
+DIM_SIMD_MULTI_FORWARD_BINARY_ASSIGN(>>)
+#undef DIM_SIMD_MULTI_FORWARD_BINARY_ASSIGN
+DIM_SIMD_MULTI_FORWARD_BINARY(==)
+DIM_SIMD_MULTI_FORWARD_BINARY(!=)
+DIM_SIMD_MULTI_FORWARD_BINARY(<)
+DIM_SIMD_MULTI_FORWARD_BINARY(<=)
+DIM_SIMD_MULTI_FORWARD_BINARY(>)
+DIM_SIMD_MULTI_FORWARD_BINARY(>=)
+DIM_SIMD_MULTI_FORWARD_BINARY(&&)
+DIM_SIMD_MULTI_FORWARD_BINARY(||)
+#undef DIM_SIMD_MULTI_FORWARD_BINARY
+
+//~~~~ selection ~~~~
+
+template<typename ConditionSimdType,
+         typename ValueSimdType,
+         int N>
+inline constexpr
+auto
+select(const Multi<ConditionSimdType, N> &condition,
+       const Multi<ValueSimdType, N> &true_value,
+       const Multi<ValueSimdType, N> &false_value)
+{
+  return impl_::multi_map_<N>(
+    [&](int i)
+    {
+      return select(condition.part(i),
+                    true_value.part(i), false_value.part(i));
+    });
+}
+
+#define DIM_SIMD_MULTI_MIN_MAX(name) \
+        template<typename SimdType, \
+                 int N> \
+        inline constexpr \
+        auto \
+        name(const Multi<SimdType, N> &a, \
+             const Multi<SimdType, N> &b) \
+        { \
+          return impl_::multi_map_<N>( \
+            [&](int i) { return name(a.part(i), b.part(i)); }); \
+        } \
+        template<typename SimdType, \
+                 int N> \
+        inline constexpr \
+        auto \
+        name(const Multi<SimdType, N> &a, \
+             typename SimdType::value_type b) \
+        { \
+          return name(a, Multi<SimdType, N>{b}); \
+        } \
+        template<typename SimdType, \
+                 int N> \
+        inline constexpr \
+        auto \
+        name(typename SimdType::value_type a, \
+             const Multi<SimdType, N> &b) \
+        { \
+          return name(Multi<SimdType, N>{a}, b); \
+        }
+DIM_SIMD_MULTI_MIN_MAX(fmin)
+DIM_SIMD_MULTI_MIN_MAX(fmax)
+#undef DIM_SIMD_MULTI_MIN_MAX
+
+//~~~~ load/store ~~~~
+
+template<typename SimdType,
+         int N>
+inline
+auto
+load_u(const Multi<SimdType, N> *unaligned_addr)
+{
+  const auto *p=reinterpret_cast<const SimdType *>(unaligned_addr);
+  return impl_::multi_map_<N>([&](int i) { return load_u(p+i); });
+}
+
+template<typename SimdType,
+         int N>
+inline
+auto
+load_a(const Multi<SimdType, N> *aligned_addr)
+{
+  return *aligned_addr;
+}
+
+#define DIM_SIMD_MULTI_STORE(name) \
+        template<typename SimdType, \
+                 int N> \
+        inline \
+        void \
+        name(Multi<SimdType, N> *addr, \
+             const Multi<SimdType, N> &m) \
+        { \
+          auto *p=reinterpret_cast<SimdType *>(addr); \
+          impl_::multi_for_<N>([&](int i) { name(p+i, m.part(i)); }); \
+        } \
+        template<typename SimdType, \
+                 int N> \
+        inline \
+        void \
+        name(typename SimdType::value_type *addr, \
+             const Multi<SimdType, N> &m) \
+        { \
+          name(reinterpret_cast<Multi<SimdType, N> *>(addr), m); \
+        }
+DIM_SIMD_MULTI_STORE(store_u)
+DIM_SIMD_MULTI_STORE(store_a)
+DIM_SIMD_MULTI_STORE(store_stream)
+#undef DIM_SIMD_MULTI_STORE
+
+template<typename MultiType,
+         int =MultiType::part_count> // Multi only
+inline
+auto // mask selecting the lanes in [first_lane, last_lane)
+lane_mask(int first_lane,
+          int last_lane)
+{
+  using simd_t = typename MultiType::simd_type;
+  constexpr auto c=simd_t::value_count;
+  return impl_::multi_map_<MultiType::part_count>(
+    [&](int i)
+    {
+      return lane_mask<simd_t>(std::clamp(first_lane-i*c, 0, c),
+                               std::clamp(last_lane-i*c, 0, c));
+    });
+}
+
+template<typename SimdType,
+         int N,
+         typename MaskSimdType>
+inline
+int // same as for a single simd vector, part after part
+compress_store(typename SimdType::value_type *unaligned_addr,
+               const Multi<SimdType, N> &m,
+               const Multi<MaskSimdType, N> &mask)
+{
+  auto count=0;
+  for(auto i=0; i<N; ++i)
+  {
+    count+=compress_store(unaligned_addr+count, m.part(i), mask.part(i));
+  }
+  return count;
+}
+
+//~~~~ math functions ~~~~
+
+template<typename SimdType,
+         int N,
+         typename Fnct>
+auto
+transform(const Multi<SimdType, N> &m,
+          Fnct fnct)
+{
+  return impl_::multi_map_<N>(
+    [&](int i) { return transform(m.part(i), fnct); });
+}
+
+#define DIM_SIMD_MULTI_MATH(name) \
+        template<typename SimdType, \
+                 int N> \
+        inline \
+        auto \
+        name(const Multi<SimdType, N> &m) \
+        { \
+          return impl_::multi_map_<N>( \
+            [&](int i) { return name(m.part(i)); }); \
+        }
+DIM_SIMD_MULTI_MATH(fabs)
+DIM_SIMD_MULTI_MATH(sqrt)
+DIM_SIMD_MULTI_MATH(cbrt)
+DIM_SIMD_MULTI_MATH(asin)
+DIM_SIMD_MULTI_MATH(acos)
+DIM_SIMD_MULTI_MATH(sinh)
+DIM_SIMD_MULTI_MATH(cosh)
+DIM_SIMD_MULTI_MATH(ceil)
+DIM_SIMD_MULTI_MATH(floor)
+DIM_SIMD_MULTI_MATH(trunc)
+DIM_SIMD_MULTI_MATH(round)
+DIM_SIMD_MULTI_MATH(exp)
+DIM_SIMD_MULTI_MATH(log)
+DIM_SIMD_MULTI_MATH(sin)
+DIM_SIMD_MULTI_MATH(cos)
+DIM_SIMD_MULTI_MATH(tan)
+DIM_SIMD_MULTI_MATH(atan)
+DIM_SIMD_MULTI_MATH(tanh)
+DIM_SIMD_MULTI_MATH(fast_exp)
+DIM_SIMD_MULTI_MATH(fast_log)
+DIM_SIMD_MULTI_MATH(fast_sin)
+DIM_SIMD_MULTI_MATH(fast_cos)
+DIM_SIMD_MULTI_MATH(fast_tan)
+DIM_SIMD_MULTI_MATH(fast_atan)
+DIM_SIMD_MULTI_MATH(fast_tanh)
+#undef DIM_SIMD_MULTI_MATH
+
+template<typename SimdType,
+         int N>
+inline
+auto // {sin(x), cos(x)} sharing the range reduction
+sincos(const Multi<SimdType, N> &x)
+{
+  auto s=Multi<SimdType, N>{}, c=Multi<SimdType, N>{};
+  impl_::multi_for_<N>(
+    [&](int i)
+    {
+      std::tie(s.part(i), c.part(i))=sincos(x.part(i));
+    });
+  return std::make_tuple(s, c);
+}
+
+//~~~~ integer operations ~~~~
+
+#define DIM_SIMD_MULTI_INTEGER(name) \
+        template<typename SimdType, \
+                 int N> \
+        inline \
+        auto \
+        name(const Multi<SimdType, N> &a, \
+             const Multi<SimdType, N> &b) \
+        { \
+          return impl_::multi_map_<N>( \
+            [&](int i) { return name(a.part(i), b.part(i)); }); \
+        }
+DIM_SIMD_MULTI_INTEGER(adds)
+DIM_SIMD_MULTI_INTEGER(subs)
+DIM_SIMD_MULTI_INTEGER(avg)
+DIM_SIMD_MULTI_INTEGER(mulhi)
+DIM_SIMD_MULTI_INTEGER(absdiff)
+DIM_SIMD_MULTI_INTEGER(sad)
+#undef DIM_SIMD_MULTI_INTEGER
+
+//~~~~ horizontal operations ~~~~
+
+namespace impl_ {
+
+template<int Count,
+         typename SimdType,
+         int N,
+         typename BinaryOp>
+inline
+auto // the parts [0, Count) combined in a balanced tree
+multi_fold_(const Multi<SimdType, N> &m,
+            BinaryOp op)
+{
+  if constexpr(Count==1)
+  {
+    return m.part(0);
+  }
+  else
+  {
+    // the parts at and above Count/2 are not meaningful from now on
+    auto folded=m;
+    constexpr auto half=Count/2;
+    multi_for_<half>(
+      [&](int i)
+      {
+        folded.part(i)=SimdType{op(m.part(i), m.part(i+Count-half))};
+      });
+    return multi_fold_<Count-half>(folded, op);
+  }
+}
+
+} // namespace impl_
+
+template<typename SimdType,
+         int N,
+         typename BinaryOp>
+inline
+auto // the parts combined in a balanced tree, then the lanes
+horizontal_reduce(const Multi<SimdType, N> &m,
+                  BinaryOp op)
+{
+  return horizontal_reduce(impl_::multi_fold_<N>(m, op), op);
+}
+
+template<typename SimdType,
+         int N>
+inline
+auto
+horizontal_sum(const Multi<SimdType, N> &m)
+{
+  return horizontal_reduce(m, std::plus<>{});
+}
+
+template<typename SimdType,
+         int N>
+inline
+auto
+horizontal_product(const Multi<SimdType, N> &m)
+{
+  return horizontal_reduce(m, std::multiplies<>{});
+}
+
+template<typename SimdType,
+         int N>
+inline
+auto
+horizontal_fmin(const Multi<SimdType, N> &m)
+{
+  return horizontal_reduce(m,
+    [](const auto &a, const auto &b)
+    {
+      return fmin(a, b);
+    });
+}
+
+template<typename SimdType,
+         int N>
+inline
+auto
+horizontal_fmax(const Multi<SimdType, N> &m)
+{
+  return horizontal_reduce(m,
+    [](const auto &a, const auto &b)
+    {
+      return fmax(a, b);
+    });
+}
+
+template<typename SimdType,
+         int N>
+inline
+bool
+horizontal_null(const Multi<SimdType, N> &m)
+{
+  return horizontal_null(impl_::multi_fold_<N>(m, std::bit_or<>{}));
+}
+
+//~~~~ mask operations ~~~~
+
+template<typename SimdType,
+         int N>
+inline
+bool
+any(const Multi<SimdType, N> &mask)
+{
+  return any(impl_::multi_fold_<N>(mask, std::bit_or<>{}));
+}
+
+template<typename SimdType,
+         int N>
+inline
+bool
+all(const Multi<SimdType, N> &mask)
+{
+  return all(impl_::multi_fold_<N>(mask, std::bit_and<>{}));
+}
+
+template<typename SimdType,
+         int N>
+inline
+bool
+none(const Multi<SimdType, N> &mask)
+{
+  return !any(mask);
+}
+
+template<typename SimdType,
+         int N>
+inline
+int // number of set lanes
+count_true(const Multi<SimdType, N> &mask)
+{
+  auto count=0;
+  impl_::multi_for_<N>([&](int i) { count+=count_true(mask.part(i)); });
+  return count;
+}
+
+template<typename SimdType,
+         int N>
+inline
+int // index of the first set lane, value_count if none
+first_set(const Multi<SimdType, N> &mask)
+{
+  for(auto i=0; i<N; ++i)
+  {
+    if(const auto lane=first_set(mask.part(i));
+       lane<SimdType::value_count)
+    {
+      return i*SimdType::value_count+lane;
+    }
+  }
+  return Multi<SimdType, N>::value_count;
+}
+
+//~~~~ display operations ~~~~
+
+template<typename SimdType,
+         int N>
+inline
+std::string
+to_string(const Multi<SimdType, N> &m)
+{
+  auto result=std::string{'{'};
+  for(auto i=0; i<m.value_count; ++i)
+  {
+    if(i!=0)
+    {
+      result+=", ";
+    }
+    result+=std::to_string(m[i]);
+  }
+  result+='}';
+  return result;
+}
+
+template<typename SimdType,
+         int N>
+inline
+std::ostream &
+operator<<(std::ostream &os,
+           const Multi<SimdType, N> &m)
+{
+  return os << to_string(m);
+}
+
+} // namespace dim::simd
+
+#endif // DIM_SIMD_MULTI_HPP
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -4,6 +4,7 @@
 #define DIM_SIMD_REAL3_HPP
 
 #include "simd.hpp"
+#include "real3.hpp"
 
 namespace dim::simd {
 
@@ -212,7 +213,7 @@ template<typename SimdType>
 inline constexpr
 void
 rotate_x(Real3<SimdType> &r3,
-         typename SimdType::real_t angle)
+         typename Real3<SimdType>::real_t angle)
 {
   const auto ca=std::cos(angle), sa=std::sin(angle);
   const auto y=r3.y*ca-r3.z*sa,
@@ -225,7 +226,7 @@ template<typename SimdType>
 inline constexpr
 Real3<SimdType>
 rotated_x(const Real3<SimdType> &r3,
-          typename SimdType::real_t angle)
+          typename Real3<SimdType>::real_t angle)
 {
   auto result=r3;
   rotate_x(result, angle);
@@ -236,7 +237,7 @@ template<typename SimdType>
 inline constexpr
 void
 rotate_y(Real3<SimdType> &r3,
-         typename SimdType::real_t angle)
+         typename Real3<SimdType>::real_t angle)
 {
   const auto ca=std::cos(angle), sa=std::sin(angle);
   const auto x=r3.z*sa+r3.x*ca,
@@ -249,7 +250,7 @@ template<typename SimdType>
 inline constexpr
 Real3<SimdType>
 rotated_y(const Real3<SimdType> &r3,
-          typename SimdType::real_t angle)
+          typename Real3<SimdType>::real_t angle)
 {
   auto result=r3;
   rotate_y(result, angle);
@@ -260,7 +261,7 @@ template<typename SimdType>
 inline constexpr
 void
 rotate_z(Real3<SimdType> &r3,
-         typename SimdType::real_t angle)
+         typename Real3<SimdType>::real_t angle)
 {
   const auto ca=std::cos(angle), sa=std::sin(angle);
   const auto x=r3.x*ca-r3.y*sa,
@@ -273,13 +274,55 @@ template<typename SimdType>
 inline constexpr
 Real3<SimdType>
 rotated_z(const Real3<SimdType> &r3,
-          typename SimdType::real_t angle)
+          typename Real3<SimdType>::real_t angle)
 {
   auto result=r3;
   rotate_z(result, angle);
   return result;
 }
 
+template<typename SimdType>
+inline
+Real3<SimdType> // from value_count xyz triples (array of structures)
+load3(const typename SimdType::value_type *unaligned_addr)
+{
+  const auto [x, y, z]=impl_::load_interleaved_<SimdType, 3>(unaligned_addr,
+    std::make_integer_sequence<int, 3>{});
+  return {x, y, z};
+}
+
+template<typename SimdType>
+inline
+Real3<SimdType>
+load3(const dim::Real3<typename SimdType::value_type> *unaligned_addr)
+{
+  using real_t = typename SimdType::value_type;
+  static_assert(sizeof(dim::Real3<real_t>)==3*sizeof(real_t));
+  return load3<SimdType>(reinterpret_cast<const real_t *>(unaligned_addr));
+}
+
+template<typename SimdType>
+inline
+void // as value_count xyz triples (array of structures)
+store3(typename SimdType::value_type *unaligned_addr,
+       const Real3<SimdType> &r3)
+{
+  const SimdType in[3]={r3.x, r3.y, r3.z};
+  impl_::store_interleaved_(unaligned_addr, in,
+    std::make_integer_sequence<int, 3>{});
+}
+
+template<typename SimdType>
+inline
+void
+store3(dim::Real3<typename SimdType::value_type> *unaligned_addr,
+       const Real3<SimdType> &r3)
+{
+  using real_t = typename SimdType::value_type;
+  static_assert(sizeof(dim::Real3<real_t>)==3*sizeof(real_t));
+  store3(reinterpret_cast<real_t *>(unaligned_addr), r3);
+}
+
 template<typename SimdType>
 inline
 std::string
@@ -0,0 +1,174 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef DIM_SIMD_TRANSFORM3_HPP
+#define DIM_SIMD_TRANSFORM3_HPP
+
+#include "transform3.hpp"
+#include "simd_real3.hpp"
+#include "aligned_buffer.hpp"
+
+// The transformations of transform3.hpp applied to simd::Real3, then in
+// bulk to the points of AlignedBuffer: xyz triples (array of structures)
+// or x, y and z components (structure of arrays).
+// Each coefficient is broadcast once for all, then a point costs nine
+// multiply-adds, whatever the transformation.
+
+namespace dim::simd {
+
+template<typename SimdType>
+inline constexpr
+Real3<SimdType>
+operator*(const dim::Matrix3<typename Real3<SimdType>::real_t> &m,
+          const Real3<SimdType> &r3)
+{
+  return {r3.x*m.x.x+r3.y*m.x.y+r3.z*m.x.z,
+          r3.x*m.y.x+r3.y*m.y.y+r3.z*m.y.z,
+          r3.x*m.z.x+r3.y*m.z.y+r3.z*m.z.z};
+}
+
+template<typename SimdType>
+inline constexpr
+Real3<SimdType>
+operator*(const dim::Quaternion<typename Real3<SimdType>::real_t> &q,
+          const Real3<SimdType> &r3)
+{
+  return matrix(q)*r3;
+}
+
+template<typename SimdType>
+inline constexpr
+Real3<SimdType>
+operator*(const dim::Affine3<typename Real3<SimdType>::real_t> &a,
+          const Real3<SimdType> &r3)
+{
+  const auto &m=a.m;
+  return {r3.x*m.x.x+r3.y*m.x.y+r3.z*m.x.z+a.t.x,
+          r3.x*m.y.x+r3.y*m.y.y+r3.z*m.y.z+a.t.y,
+          r3.x*m.z.x+r3.y*m.z.y+r3.z*m.z.z+a.t.z};
+}
+
+} // namespace dim::simd
+
+namespace dim {
+
+namespace impl_ {
+
+template<typename RealType>
+inline
+Affine3<RealType>
+affine_(const Matrix3<RealType> &m)
+{
+  return {m};
+}
+
+template<typename RealType>
+inline
+Affine3<RealType>
+affine_(const Quaternion<RealType> &q)
+{
+  return {q};
+}
+
+template<typename RealType>
+inline
+Affine3<RealType>
+affine_(const Affine3<RealType> &a)
+{
+  return a;
+}
+
+} // namespace impl_
+
+// The points of the slice processed by a part (the same as in apply0())
+// are transformed in place by a Matrix3, a Quaternion or an Affine3 (a
+// quaternion is turned into a matrix beforehand).
+
+template<int VectorSize=default_vector_size,
+         typename T,
+         typename Transform>
+inline
+void // x, y and z hold the separate components (structure of arrays)
+transform(AlignedBuffer<T> &x,
+          AlignedBuffer<T> &y,
+          AlignedBuffer<T> &z,
+          const Transform &transformation,
+          int part_id, int part_count)
+{
+  const auto a=impl_::affine_(transformation);
+#if DIM_ALIGNED_BUFFER_DISABLE_SIMD
+  auto * DIM_RESTRICT dx=x.data();
+  auto * DIM_RESTRICT dy=y.data();
+  auto * DIM_RESTRICT dz=z.data();
+  for(auto [i, i_end]=sequence_part(x.count(), part_id, part_count);
+      i<i_end; ++i)
+  {
+    const auto r3=a*Real3<T>{dx[i], dy[i], dz[i]};
+    dx[i]=r3.x;
+    dy[i]=r3.y;
+    dz[i]=r3.z;
+  }
+#else
+  using simd_t = simd::simd_t<T, VectorSize>;
+  auto * DIM_RESTRICT dx=x.template simd_data<VectorSize>();
+  auto * DIM_RESTRICT dy=y.template simd_data<VectorSize>();
+  auto * DIM_RESTRICT dz=z.template simd_data<VectorSize>();
+  for(auto [i, i_end]=sequence_part(x.template simd_count<VectorSize>(),
+                                    part_id, part_count);
+      i<i_end; ++i)
+  {
+    const auto r3=a*simd::Real3<simd_t>{dx[i], dy[i], dz[i]};
+    dx[i]=r3.x;
+    dy[i]=r3.y;
+    dz[i]=r3.z;
+  }
+#endif
+}
+
+template<int VectorSize=default_vector_size,
+         typename T,
+         typename Transform>
+inline
+void // xyz holds xyz.count()/3 triples (array of structures)
+transform(AlignedBuffer<T> &xyz,
+          const Transform &transformation,
+          int part_id, int part_count)
+{
+  const auto a=impl_::affine_(transformation);
+  const auto count=xyz.count()/3;
+  auto * DIM_RESTRICT d=xyz.data();
+#if DIM_ALIGNED_BUFFER_DISABLE_SIMD
+  for(auto [i, i_end]=sequence_part(count, part_id, part_count);
+      i<i_end; ++i)
+  {
+    const auto r3=a*Real3<T>{d[3*i+0], d[3*i+1], d[3*i+2]};
+    d[3*i+0]=r3.x;
+    d[3*i+1]=r3.y;
+    d[3*i+2]=r3.z;
+  }
+#else
+  using simd_t = simd::simd_t<T, VectorSize>;
+  constexpr auto vc=simd_t::value_count;
+  const auto [i_begin, i_end]=sequence_part((count+vc-1)/vc,
+                                            part_id, part_count);
+  const auto body_end=std::min(i_end, count/vc);
+  for(auto i=i_begin; i<body_end; ++i)
+  {
+    simd::store3(d+3*vc*i, a*simd::load3<simd_t>(d+3*vc*i));
+  }
+  // the remaining triples one by one: xyz may be used beyond them
+  for(auto id=body_end*vc, id_end=std::min(i_end*vc, count);
+      id<id_end; ++id)
+  {
+    const auto r3=a*Real3<T>{d[3*id+0], d[3*id+1], d[3*id+2]};
+    d[3*id+0]=r3.x;
+    d[3*id+1]=r3.y;
+    d[3*id+2]=r3.z;
+  }
+#endif
+}
+
+} // namespace dim
+
+#endif // DIM_SIMD_TRANSFORM3_HPP
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -3,13 +3,22 @@
 #ifndef DIM_SYNCHRO_HPP
 #define DIM_SYNCHRO_HPP
 
+#if defined __linux__
+# include <linux/futex.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
 #include <cstdint>
+#include <climits>
 #include <atomic>
+#include <thread>
 
 namespace dim {
 
 namespace impl_ {
 
+inline
 void
 cpu_pause_()
 {
@@ -30,6 +39,89 @@ cpu_pause_()
 #endif
 }
 
+// A thread which spins too long on a word (see Synchro) sleeps in
+// futex_wait_() instead, as long as the word holds the expected value;
+// futex_wake_() must then be called after any change of this word.
+// Elsewhere than Linux, the thread only yields.
+
+template<typename T>
+inline
+void
+futex_wait_(std::atomic<T> &word,
+            T expected)
+{
+  static_assert(sizeof(std::atomic<T>)==sizeof(int),
+                "futex requires a 32-bit word");
+#if defined __linux__
+  ::syscall(SYS_futex, reinterpret_cast<int *>(&word), FUTEX_WAIT_PRIVATE,
+            int(expected), nullptr, nullptr, 0);
+#else
+  (void)word;
+  (void)expected;
+  std::this_thread::yield();
+#endif
+}
+
+template<typename T>
+inline
+void
+futex_wake_(std::atomic<T> &word)
+{
+#if defined __linux__
+  ::syscall(SYS_futex, reinterpret_cast<int *>(&word), FUTEX_WAKE_PRIVATE,
+            INT_MAX, nullptr, nullptr, 0);
+#else
+  (void)word;
+#endif
+}
+
+template<typename T,
+         typename Ready>
+inline
+T // first value of word for which ready(value) is true
+spin_then_wait_(std::atomic<T> &word,
+                std::atomic<int> &sleepers,
+                int spin_count,
+                Ready ready)
+{
+  for(;;)
+  {
+    if(const auto value=word.load(std::memory_order_acquire); ready(value))
+    {
+      return value;
+    }
+    if(spin_count>0)
+    {
+      --spin_count;
+      cpu_pause_();
+    }
+    else
+    {
+      // sequentially consistent, as in wake_sleepers_(), so that either
+      // the change of the word is seen here or this sleeper is seen there
+      sleepers.fetch_add(1, std::memory_order_seq_cst);
+      if(const auto value=word.load(std::memory_order_seq_cst); !ready(value))
+      {
+        // woken up by the next change, or immediately if already outdated
+        futex_wait_(word, value);
+      }
+      sleepers.fetch_sub(1, std::memory_order_relaxed);
+    }
+  }
+}
+
+template<typename T>
+inline
+void // after a sequentially consistent change of word
+wake_sleepers_(std::atomic<T> &word,
+               std::atomic<int> &sleepers)
+{
+  if(sleepers.load(std::memory_order_seq_cst))
+  {
+    futex_wake_(word);
+  }
+}
+
 } // namespace impl_
 
 class SpinLock
@@ -143,52 +235,80 @@ public:
 
   using sync_t = unsigned int; // overflow is correct
 
-  Synchro()
+  // a waiting thread polls the shared word spin_count times (with a pause
+  // in between), then sleeps until the word changes; the hot path, when
+  // the word has already changed, is not slowed down, and a sleeper only
+  // costs a system call to the thread which wakes it
+
+  static constexpr auto default_spin_count=1<<14;
+
+  explicit
+  Synchro(int spin_count=default_spin_count)
   : sync_{}
+  , sync_sleepers_{}
   , ack_count_{}
+  , ack_sleepers_{}
+  , spin_count_{spin_count}
   {
     // nothing more to be done
   }
 
+  int
+  spin_count() const
+  {
+    return spin_count_;
+  }
+
+  void
+  spin_count(int count) // 0 sleeps as soon as the word is not ready
+  {
+    spin_count_=count;
+  }
+
   void
   sync(int thread_count)
   {
     ack_count_.store(thread_count-1, std::memory_order_release);
-    sync_.fetch_add(1, std::memory_order_release);
+    sync_.fetch_add(1, std::memory_order_seq_cst);
+    impl_::wake_sleepers_(sync_, sync_sleepers_);
   }
 
   void
   wait_for_sync(sync_t &last_sync)
   {
-    for(;;)
-    {
-      if(const auto sync=sync_.load(std::memory_order_acquire);
-         last_sync!=sync)
+    last_sync=impl_::spin_then_wait_(sync_, sync_sleepers_, spin_count_,
+      [&](sync_t sync)
       {
-        last_sync=sync;
-        break;
-      }
-    }
+        return sync!=last_sync;
+      });
   }
 
   void
   ack()
   {
-    ack_count_.fetch_sub(1, std::memory_order_release);
+    // only the last acknowledgement wakes the waiting thread
+    if(ack_count_.fetch_sub(1, std::memory_order_seq_cst)==1)
+    {
+      impl_::wake_sleepers_(ack_count_, ack_sleepers_);
+    }
   }
 
   void
   wait_for_ack()
   {
-    while(ack_count_.load(std::memory_order_acquire)!=0)
-    {
-      // busy wait
-    }
+    impl_::spin_then_wait_(ack_count_, ack_sleepers_, spin_count_,
+      [&](int count)
+      {
+        return count==0;
+      });
   }
 
 private:
   std::atomic<sync_t> sync_;
+  std::atomic<int> sync_sleepers_;
   std::atomic<int> ack_count_;
+  std::atomic<int> ack_sleepers_;
+  int spin_count_;
 };
 
 } // namespace dim
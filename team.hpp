@@ -0,0 +1,562 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef DIM_TEAM_HPP
+#define DIM_TEAM_HPP
+
+#include "cpu_platform.hpp"
+#include "tree_synchro.hpp"
+#include "aligned_buffer.hpp"
+#include "reduce.hpp"
+
+#include <thread>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <exception>
+#include <utility>
+#include <stdexcept>
+
+namespace dim {
+
+class Team
+{
+public:
+
+  // the constructing thread takes part 0 of every dispatch (it is bound
+  // to the first cpu), one worker thread is started for each other part
+  explicit
+  Team(const cpu::Platform &platform,
+       int thread_count=0) // 0 means one thread per used cpu
+  : thread_count_{thread_count>0 ? thread_count : platform.cpu_count()}
+  , stream_threshold_{
+      cpu::compute_total_cache_size(platform, platform.max_cache_level())}
+  , cpu_ids_{std::make_unique<cpu::CpuId[]>(thread_count_)}
+  , synchro_{platform, thread_count_}
+  , job_{}
+  , context_{}
+  , failed_{}
+  , exception_{}
+  , threads_{}
+  {
+    for(auto id=0; id<thread_count_; ++id)
+    {
+      cpu_ids_[id]=platform.cpu_id(id%platform.cpu_count());
+    }
+    cpu::bind_current_thread(cpu_ids_[0]);
+    threads_.reserve(thread_count_-1);
+    for(auto id=1; id<thread_count_; ++id)
+    {
+      threads_.emplace_back(
+        [this, id]()
+        {
+          work_(id);
+        });
+    }
+  }
+
+  ~Team()
+  {
+    job_=nullptr; // tells the workers to quit
+    synchro_.sync();
+    for(auto &th: threads_)
+    {
+      th.join();
+    }
+  }
+
+  Team(const Team &) =delete;
+  Team & operator=(const Team &) =delete;
+  Team(Team &&) =delete;
+  Team & operator=(Team &&) =delete;
+
+  int
+  thread_count() const
+  {
+    return thread_count_;
+  }
+
+  cpu::CpuId // system id of the cpu the thread is bound to
+  cpu_id(int part_id) const
+  {
+    return cpu_ids_[part_id];
+  }
+
+  std::ptrdiff_t // destinations larger than this bypass the caches
+  stream_threshold() const
+  {
+    return stream_threshold_;
+  }
+
+  void
+  stream_threshold(std::ptrdiff_t bytes) // 0 disables streaming
+  {
+    stream_threshold_=bytes;
+  }
+
+  // If fnct throws in some parts, every part still completes the dispatch
+  // and the first exception is rethrown in the calling thread; a part
+  // which throws must not leave the others waiting in barrier().
+
+  template<typename Fnct>
+  void
+  run(const Fnct &fnct) // fnct(part_id, part_count) in every thread
+  {
+    dispatch_(
+      [&](int part_id, int part_count)
+      {
+        guarded_(
+          [&]()
+          {
+            fnct(part_id, part_count);
+          });
+        if(part_id)
+        {
+          synchro_.ack(part_id);
+        }
+        else
+        {
+          synchro_.wait_for_ack();
+        }
+      });
+  }
+
+  template<typename Fnct,
+           typename BinaryOp>
+  auto
+  reduce(const Fnct &fnct, // fnct(part_id, part_count) --> partial result
+         BinaryOp op)        // associative and commutative
+  {
+    using result_t = std::decay_t<decltype(fnct(0, 1))>;
+    // partial results are combined along the tree of acknowledgements,
+    // not serially by the calling thread
+    auto result=result_t{};
+    dispatch_(
+      [&](int part_id, int part_count)
+      {
+        // a part which throws contributes a default value
+        auto partial=result_t{};
+        guarded_(
+          [&]()
+          {
+            partial=result_t(fnct(part_id, part_count));
+          });
+        if(part_id)
+        {
+          synchro_.ack(part_id, partial, op);
+        }
+        else
+        {
+          result=synchro_.wait_for_ack(partial, op);
+        }
+      });
+    return result;
+  }
+
+  void // within run(), waits for every part
+  barrier(int part_id)
+  {
+    synchro_.barrier(part_id);
+  }
+
+  template<typename T,
+           typename BinaryOp>
+  T // within run(), every part obtains the combination of all the values
+  barrier(int part_id,
+          const T &value,
+          BinaryOp op) // associative and commutative
+  {
+    return synchro_.barrier(part_id, value, op);
+  }
+
+  template<typename... Args> // buffers..., fnct
+  void
+  apply0(const Args &...args)
+  {
+    run(
+      [&](int part_id, int part_count)
+      {
+        dim::apply0(part_id, part_count, args...);
+      });
+  }
+
+  template<typename T1,
+           typename... Args> // buffers..., fnct
+  void
+  apply1(AlignedBuffer<T1> &buffer1,
+         const Args &...args)
+  {
+    run(
+      [&](int part_id, int part_count)
+      {
+        dim::apply1(buffer1, part_id, part_count, args...);
+      });
+  }
+
+  template<typename T1,
+           typename... Args> // buffers..., fnct
+  void // fnct must only write d1, streamed if it exceeds the caches
+  apply1_stream(AlignedBuffer<T1> &buffer1,
+                const Args &...args)
+  {
+    if(streams_(buffer1))
+    {
+      run(
+        [&](int part_id, int part_count)
+        {
+          dim::apply1_stream(buffer1, part_id, part_count, args...);
+        });
+    }
+    else
+    {
+      apply1(buffer1, args...);
+    }
+  }
+
+  template<typename T1,
+           typename T2,
+           typename... Args> // buffers..., fnct
+  void
+  apply2(AlignedBuffer<T1> &buffer1,
+         AlignedBuffer<T2> &buffer2,
+         const Args &...args)
+  {
+    run(
+      [&](int part_id, int part_count)
+      {
+        dim::apply2(buffer1, buffer2, part_id, part_count, args...);
+      });
+  }
+
+  template<typename T1,
+           typename T2,
+           typename T3,
+           typename... Args> // buffers..., fnct
+  void
+  apply3(AlignedBuffer<T1> &buffer1,
+         AlignedBuffer<T2> &buffer2,
+         AlignedBuffer<T3> &buffer3,
+         const Args &...args)
+  {
+    run(
+      [&](int part_id, int part_count)
+      {
+        dim::apply3(buffer1, buffer2, buffer3,
+                    part_id, part_count, args...);
+      });
+  }
+
+  template<typename T1,
+           typename T2,
+           typename T3,
+           typename T4,
+           typename... Args> // buffers..., fnct
+  void
+  apply4(AlignedBuffer<T1> &buffer1,
+         AlignedBuffer<T2> &buffer2,
+         AlignedBuffer<T3> &buffer3,
+         AlignedBuffer<T4> &buffer4,
+         const Args &...args)
+  {
+    run(
+      [&](int part_id, int part_count)
+      {
+        dim::apply4(buffer1, buffer2, buffer3, buffer4,
+                    part_id, part_count, args...);
+      });
+  }
+
+  template<typename T1,
+           typename T2,
+           typename T3,
+           typename T4,
+           typename T5,
+           typename... Args> // buffers..., fnct
+  void
+  apply5(AlignedBuffer<T1> &buffer1,
+         AlignedBuffer<T2> &buffer2,
+         AlignedBuffer<T3> &buffer3,
+         AlignedBuffer<T4> &buffer4,
+         AlignedBuffer<T5> &buffer5,
+         const Args &...args)
+  {
+    run(
+      [&](int part_id, int part_count)
+      {
+        dim::apply5(buffer1, buffer2, buffer3, buffer4, buffer5,
+                    part_id, part_count, args...);
+      });
+  }
+
+  template<typename T1,
+           typename T2,
+           typename T3,
+           typename T4,
+           typename T5,
+           typename T6,
+           typename... Args> // buffers..., fnct
+  void
+  apply6(AlignedBuffer<T1> &buffer1,
+         AlignedBuffer<T2> &buffer2,
+         AlignedBuffer<T3> &buffer3,
+         AlignedBuffer<T4> &buffer4,
+         AlignedBuffer<T5> &buffer5,
+         AlignedBuffer<T6> &buffer6,
+         const Args &...args)
+  {
+    run(
+      [&](int part_id, int part_count)
+      {
+        dim::apply6(buffer1, buffer2, buffer3, buffer4, buffer5, buffer6,
+                    part_id, part_count, args...);
+      });
+  }
+
+  template<typename T>
+  void
+  fill(AlignedBuffer<T> &dst,
+       const T &value)
+  {
+    run(
+      [&](int part_id, int part_count)
+      {
+        if(streams_(dst))
+        {
+          dim::fill_stream(dst, part_id, part_count, value);
+        }
+        else
+        {
+          dim::fill(dst, part_id, part_count, value);
+        }
+      });
+  }
+
+  template<typename T>
+  void
+  first_touch(AlignedBuffer<T> &dst) // expects BufferInit::none
+  {
+    run(
+      [&](int part_id, int part_count)
+      {
+        dim::first_touch(dst, part_id, part_count);
+      });
+  }
+
+  template<typename T>
+  T
+  sum(const AlignedBuffer<T> &buffer)
+  {
+    return reduce(
+      [&](int part_id, int part_count)
+      {
+        return dim::sum(buffer, part_id, part_count);
+      },
+      std::plus<>{});
+  }
+
+  template<typename T,
+           bool Compensated>
+  T // same result whatever the thread count
+  sum(const AlignedBuffer<T> &buffer,
+      ReproducibleSum<T, Compensated> &reproducible_sum)
+  {
+    // before the dispatch, not within every part
+    if(buffer.count()!=reproducible_sum.count())
+    {
+      throw std::runtime_error{"ReproducibleSum: unexpected buffer count"};
+    }
+    run(
+      [&](int part_id, int part_count)
+      {
+        reproducible_sum.accumulate(buffer, part_id, part_count);
+      });
+    return reproducible_sum.result();
+  }
+
+  template<typename T>
+  T
+  dot(const AlignedBuffer<T> &buffer1,
+      const AlignedBuffer<T> &buffer2)
+  {
+    return reduce(
+      [&](int part_id, int part_count)
+      {
+        return dim::dot(buffer1, buffer2, part_id, part_count);
+      },
+      std::plus<>{});
+  }
+
+  template<typename T>
+  T
+  min(const AlignedBuffer<T> &buffer)
+  {
+    return reduce(
+      [&](int part_id, int part_count)
+      {
+        return dim::min(buffer, part_id, part_count);
+      },
+      impl_::MinOp_{});
+  }
+
+  template<typename T>
+  T
+  max(const AlignedBuffer<T> &buffer)
+  {
+    return reduce(
+      [&](int part_id, int part_count)
+      {
+        return dim::max(buffer, part_id, part_count);
+      },
+      impl_::MaxOp_{});
+  }
+
+  template<typename T>
+  IndexedValue<T>
+  argmin(const AlignedBuffer<T> &buffer)
+  {
+    return reduce(
+      [&](int part_id, int part_count)
+      {
+        return dim::argmin(buffer, part_id, part_count);
+      },
+      merge_argmin<T>);
+  }
+
+  template<typename T>
+  IndexedValue<T>
+  argmax(const AlignedBuffer<T> &buffer)
+  {
+    return reduce(
+      [&](int part_id, int part_count)
+      {
+        return dim::argmax(buffer, part_id, part_count);
+      },
+      merge_argmax<T>);
+  }
+
+  template<typename T>
+  T
+  norm_l1(const AlignedBuffer<T> &buffer)
+  {
+    return reduce(
+      [&](int part_id, int part_count)
+      {
+        return dim::norm_l1(buffer, part_id, part_count);
+      },
+      std::plus<>{});
+  }
+
+  template<typename T>
+  T
+  sqr_norm_l2(const AlignedBuffer<T> &buffer)
+  {
+    return reduce(
+      [&](int part_id, int part_count)
+      {
+        return dim::sqr_norm_l2(buffer, part_id, part_count);
+      },
+      std::plus<>{});
+  }
+
+  template<typename T,
+           typename Pred>
+  std::ptrdiff_t
+  count_if(const AlignedBuffer<T> &buffer,
+           Pred pred)
+  {
+    return reduce(
+      [&](int part_id, int part_count)
+      {
+        return dim::count_if(buffer, part_id, part_count, pred);
+      },
+      std::plus<>{});
+  }
+
+private:
+
+  template<typename Fnct>
+  void // fnct(part_id, part_count) must acknowledge, and never throw
+  dispatch_(const Fnct &fnct)
+  {
+    // no allocation: the workers only see a plain function and a pointer
+    context_=&fnct;
+    job_=
+      [](const void *context,
+         int part_id,
+         int part_count)
+      {
+        (*static_cast<const Fnct *>(context))(part_id, part_count);
+      };
+    synchro_.sync();
+    fnct(0, thread_count_);
+    // all the parts have acknowledged, thus exception_ is visible
+    if(failed_.load(std::memory_order_relaxed))
+    {
+      failed_.store(false, std::memory_order_relaxed);
+      std::rethrow_exception(std::exchange(exception_, nullptr));
+    }
+  }
+
+  template<typename Fnct>
+  void // an exception must not prevent a part from acknowledging
+  guarded_(const Fnct &fnct) noexcept
+  {
+    try
+    {
+      fnct();
+    }
+    catch(...)
+    {
+      // only the first one is kept
+      if(!failed_.exchange(true, std::memory_order_relaxed))
+      {
+        exception_=std::current_exception();
+      }
+    }
+  }
+
+  template<typename T>
+  bool
+  streams_(const AlignedBuffer<T> &dst) const
+  {
+    // when the destination cannot stay in the caches anyway, reading it
+    // before overwriting it only doubles the memory traffic
+    return (stream_threshold_>0)&&
+           (dst.count()*std::ptrdiff_t(sizeof(T))>stream_threshold_);
+  }
+
+  void
+  work_(int part_id)
+  {
+    cpu::bind_current_thread(cpu_ids_[part_id]);
+    // the team cannot have synchronised before this initial value
+    auto last_sync=TreeSynchro::sync_t{};
+    for(;;)
+    {
+      synchro_.wait_for_sync(part_id, last_sync);
+      if(!job_)
+      {
+        break;
+      }
+      job_(context_, part_id, thread_count_);
+    }
+  }
+
+  using job_t = void (*)(const void *, int, int);
+
+  int thread_count_;
+  std::ptrdiff_t stream_threshold_;
+  std::unique_ptr<cpu::CpuId[]> cpu_ids_;
+  TreeSynchro synchro_;
+  job_t job_;
+  const void *context_;
+  std::atomic<bool> failed_;
+  std::exception_ptr exception_;
+  std::vector<std::thread> threads_;
+};
+
+} // namespace dim
+
+#endif // DIM_TEAM_HPP
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
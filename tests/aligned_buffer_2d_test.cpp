@@ -0,0 +1,263 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "check.hpp"
+
+#include "aligned_buffer_2d.hpp"
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+// fill() and sum() of AlignedBuffer2D on every region of interest of rows
+// 1, 5, 17 and 64 values wide (thus with first and last simd vectors
+// being the same one, starting off a vector boundary, narrower than a
+// vector, touching the left and right edges...), computed in 1, 3 and 7
+// parts; fill() must not write anything outside the region, not even in
+// the padding of the rows.
+// Then the row-wise apply0(), apply1() and apply2() against a serial loop.
+// The values are small integers, thus every sum is exact.
+
+using namespace dim;
+
+template<typename T>
+T
+value_(std::ptrdiff_t x,
+       std::ptrdiff_t y)
+{
+  return T((x*7+y*3)%11)-T(5);
+}
+
+template<typename T>
+void
+init_(AlignedBuffer2D<T> &buffer,
+      int seed)
+{
+  for(auto y=std::ptrdiff_t{}; y<buffer.height(); ++y)
+  {
+    for(auto x=std::ptrdiff_t{}; x<buffer.width(); ++x)
+    {
+      buffer.row(y)[x]=value_<T>(x+seed, y);
+    }
+  }
+}
+
+template<typename V>
+auto // the sum of the lanes of a simd vector, or the value itself
+lanes_sum_(const V &v)
+{
+  if constexpr(std::is_arithmetic_v<V>)
+  {
+    return v;
+  }
+  else
+  {
+    return horizontal_sum(v);
+  }
+}
+
+template<typename T>
+void
+test_roi_(std::ptrdiff_t width)
+{
+  constexpr auto height=std::ptrdiff_t{6};
+  constexpr auto value=T(9);
+  auto buffer=AlignedBuffer2D<T>{width, height};
+  init_(buffer, 0);
+  const auto total=buffer.pitch()*height;
+  auto before=std::vector<T>(buffer.cdata(), buffer.cdata()+total);
+  const std::ptrdiff_t bands[][2]={{0, height}, {1, height-2}, {height-1, 1}};
+  for(const auto part_count: {1, 3, 7})
+  {
+    for(const auto &[y, h]: bands)
+    {
+      for(auto x=std::ptrdiff_t{}; x<width; ++x)
+      {
+        for(auto w=std::ptrdiff_t{}; x+w<=width; ++w)
+        {
+          auto expected=T{};
+          for(auto row=y; row<y+h; ++row)
+          {
+            for(auto col=x; col<x+w; ++col)
+            {
+              expected+=buffer.crow(row)[col];
+            }
+          }
+          auto result=T{};
+          for(auto part_id=0; part_id<part_count; ++part_id)
+          {
+            result+=sum(buffer, part_id, part_count, x, y, w, h);
+          }
+          DIM_CHECK(result==expected);
+          for(auto part_id=0; part_id<part_count; ++part_id)
+          {
+            fill(buffer, part_id, part_count, x, y, w, h, value);
+          }
+          auto same=true;
+          for(auto id=std::ptrdiff_t{}; id<total; ++id)
+          {
+            const auto row=id/buffer.pitch(), col=id%buffer.pitch();
+            const auto inside=(row>=y)&&(row<y+h)&&(col>=x)&&(col<x+w);
+            same=same&&(buffer.cdata()[id]==(inside ? value : before[id]));
+          }
+          DIM_CHECK(same);
+          // restore the initial values
+          std::copy(before.cbegin(), before.cend(), buffer.data());
+        }
+      }
+    }
+  }
+  // whole buffer
+  for(const auto part_count: {1, 3, 7})
+  {
+    auto result=T{};
+    for(auto part_id=0; part_id<part_count; ++part_id)
+    {
+      result+=sum(buffer, part_id, part_count);
+    }
+    DIM_CHECK(result==sum(buffer, 0, 1, 0, 0, width, height));
+    for(auto part_id=0; part_id<part_count; ++part_id)
+    {
+      fill(buffer, part_id, part_count, value);
+    }
+    auto expected=T{};
+    for(auto part_id=0; part_id<part_count; ++part_id)
+    {
+      expected+=sum(buffer, part_id, part_count);
+    }
+    DIM_CHECK(expected==value*T(width*height));
+    std::copy(before.cbegin(), before.cend(), buffer.data());
+  }
+}
+
+template<typename T>
+void
+test_apply_(std::ptrdiff_t width)
+{
+  constexpr auto height=std::ptrdiff_t{9};
+  auto a=AlignedBuffer2D<T>{width, height};
+  auto b=AlignedBuffer2D<T>{width, height};
+  init_(a, 0);
+  init_(b, 4);
+  // the operations keep the padding null, thus apply0() may sum it
+  for(const auto part_count: {1, 3, 7})
+  {
+    auto d=AlignedBuffer2D<T>{width, height};
+    auto e=AlignedBuffer2D<T>{width, height};
+    const auto check=
+      [&](const auto &d_expected, const auto &e_expected)
+      {
+        auto same=true;
+        for(auto y=std::ptrdiff_t{}; y<height; ++y)
+        {
+          for(auto x=std::ptrdiff_t{}; x<width; ++x)
+          {
+            const auto av=a.crow(y)[x], bv=b.crow(y)[x];
+            same=same&&(d.crow(y)[x]==d_expected(av, bv))&&
+                       (e.crow(y)[x]==e_expected(av, bv));
+          }
+        }
+        DIM_CHECK(same);
+      };
+    const auto keep_e=
+      [](T, T)
+      {
+        return T{};
+      };
+    for(auto part_id=0; part_id<part_count; ++part_id)
+    {
+      apply1(d, part_id, part_count, a,
+        [](auto &dv, const auto &av)
+        {
+          dv=av;
+        });
+    }
+    for(auto part_id=0; part_id<part_count; ++part_id)
+    {
+      apply1(d, part_id, part_count,
+        [](auto &dv)
+        {
+          dv=dv+dv;
+        });
+    }
+    check([](T av, T){ return T(av+av); }, keep_e);
+    for(auto part_id=0; part_id<part_count; ++part_id)
+    {
+      apply1(d, part_id, part_count, a, b,
+        [](auto &dv, const auto &av, const auto &bv)
+        {
+          dv=av*bv-av;
+        });
+    }
+    check([](T av, T bv){ return T(av*bv-av); }, keep_e);
+    for(auto part_id=0; part_id<part_count; ++part_id)
+    {
+      apply2(d, e, part_id, part_count,
+        [](auto &dv, auto &ev)
+        {
+          ev=dv;
+          dv=dv+dv;
+        });
+    }
+    check([](T av, T bv){ return T(2*(av*bv-av)); },
+          [](T av, T bv){ return T(av*bv-av); });
+    for(auto part_id=0; part_id<part_count; ++part_id)
+    {
+      apply2(d, e, part_id, part_count, b,
+        [](auto &dv, auto &ev, const auto &bv)
+        {
+          dv=bv-ev;
+          ev=bv*bv;
+        });
+    }
+    check([](T av, T bv){ return T(bv-(av*bv-av)); },
+          [](T, T bv){ return T(bv*bv); });
+    auto expected=std::vector<T>(3);
+    for(auto y=std::ptrdiff_t{}; y<height; ++y)
+    {
+      for(auto x=std::ptrdiff_t{}; x<width; ++x)
+      {
+        const auto av=a.crow(y)[x], bv=b.crow(y)[x], dv=d.crow(y)[x];
+        expected[0]+=av;
+        expected[1]+=av*bv;
+        expected[2]+=av*bv*dv;
+      }
+    }
+    auto result=std::vector<T>(3);
+    for(auto part_id=0; part_id<part_count; ++part_id)
+    {
+      apply0(part_id, part_count, a,
+        [&](const auto &av)
+        {
+          result[0]+=lanes_sum_(av);
+        });
+      apply0(part_id, part_count, a, b,
+        [&](const auto &av, const auto &bv)
+        {
+          result[1]+=lanes_sum_(av*bv);
+        });
+      apply0(part_id, part_count, a, b, d,
+        [&](const auto &av, const auto &bv, const auto &dv)
+        {
+          result[2]+=lanes_sum_(av*bv*dv);
+        });
+    }
+    DIM_CHECK(result==expected);
+  }
+}
+
+int
+main()
+{
+  for(const auto width: {1, 5, 17, 64})
+  {
+    test_roi_<float>(width);
+    test_roi_<double>(width);
+    test_roi_<std::int32_t>(width);
+    test_apply_<float>(width);
+    test_apply_<double>(width);
+    test_apply_<std::int32_t>(width);
+  }
+  return test::check_result();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -0,0 +1,99 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "check.hpp"
+
+#include "aosoa.hpp"
+
+using namespace dim;
+
+template<int VectorSize>
+void
+test_erase_if_resize()
+{
+  using points_t = AoSoA<float, VectorSize, int, double>;
+  using simd_t = typename points_t::simd_t;
+  const auto n=std::ptrdiff_t{5*points_t::value_count+3};
+  auto points=points_t{};
+  for(auto i=std::ptrdiff_t{}; i<n; ++i)
+  {
+    points.push_back({float(i), float(2*i), float(3*i)}, int(i), 0.5*i);
+  }
+  DIM_CHECK(points.count()==n);
+  // erase the points with an x in [3, 11), the order is kept
+  const auto erased=points.erase_if(
+    [&](const auto &c, const int *, const double *)
+    {
+      return (c.x>=simd_t{3.0f})&(c.x<simd_t{11.0f});
+    });
+  DIM_CHECK(erased==8);
+  DIM_CHECK(points.count()==n-8);
+  for(auto id=std::ptrdiff_t{}; id<points.count(); ++id)
+  {
+    const auto i=id<3 ? id : id+8;
+    const auto p=points.position(id);
+    DIM_CHECK((p.x==float(i))&&(p.y==float(2*i))&&(p.z==float(3*i)));
+    DIM_CHECK(points.template cvalue<0>(id)==int(i));
+    DIM_CHECK(points.template cvalue<1>(id)==0.5*double(i));
+  }
+  // growing zeroes the new points, whatever the lanes beyond count() held
+  const auto check_zero=
+    [&](std::ptrdiff_t first)
+    {
+      for(auto id=first; id<points.count(); ++id)
+      {
+        const auto p=points.position(id);
+        DIM_CHECK((p.x==0.0f)&&(p.y==0.0f)&&(p.z==0.0f));
+        DIM_CHECK(points.template cvalue<0>(id)==0);
+        DIM_CHECK(points.template cvalue<1>(id)==0.0);
+      }
+    };
+  auto count=points.count();
+  points.resize(count+points_t::value_count);
+  check_zero(count);
+  points.resize(count-1);
+  apply(points, 0, 1,
+    [&](auto &c, int *i, double *d)
+    {
+      c.x=c.y=c.z=simd_t{1.0f};
+      for(auto lane=0; lane<points_t::value_count; ++lane)
+      {
+        i[lane]=1;
+        d[lane]=1.0;
+      }
+    });
+  count=points.count();
+  points.resize(count+points_t::value_count);
+  check_zero(count);
+  // erasing everything
+  points.erase_if(
+    [&](const auto &c, const int *, const double *)
+    {
+      return c.x==c.x;
+    });
+  DIM_CHECK(points.count()==0);
+  points.resize(3);
+  check_zero(0);
+}
+
+void
+test_no_field()
+{
+  auto points=AoSoA<float>{};
+  points.push_back({1.0f, 2.0f, 3.0f});
+  points.resize(10);
+  DIM_CHECK(points.count()==10);
+  DIM_CHECK(points.position(0).z==3.0f);
+  DIM_CHECK(points.position(9).x==0.0f);
+  DIM_CHECK(std::tuple_size_v<decltype(points.fields(0))> ==0);
+}
+
+int
+main()
+{
+  test_erase_if_resize<16>();
+  test_erase_if_resize<simd::max_vector_size>();
+  test_no_field();
+  return test::check_result();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -0,0 +1,224 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "check.hpp"
+
+#include "cell_list.hpp"
+
+#include <random>
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+// for_each_pair(), neighbours() and update() of CellList against a
+// brute-force loop over all the pairs, built and scanned in several parts,
+// with point counts which are not multiples of the vectors and a few points
+// outside the bounds.
+// A pair whose distance is within rounding of the cutoff may be found or
+// not (contraction into fma differs between the loops), it is ignored.
+
+using namespace dim;
+
+template<typename T>
+struct Points_
+{
+  AlignedBuffer<T> x, y, z;
+};
+
+template<typename T>
+Points_<T>
+random_points_(std::ptrdiff_t count,
+               std::mt19937_64 &gen)
+{
+  auto distrib=std::uniform_real_distribution<T>{T(-0.05), T(1.05)};
+  auto points=Points_<T>{AlignedBuffer<T>{count}, AlignedBuffer<T>{count},
+                         AlignedBuffer<T>{count}};
+  for(auto i=std::ptrdiff_t{}; i<count; ++i)
+  {
+    points.x.data()[i]=distrib(gen);
+    points.y.data()[i]=distrib(gen);
+    points.z.data()[i]=distrib(gen);
+  }
+  return points;
+}
+
+template<typename T>
+T
+sqr_distance_(const Points_<T> &points,
+              std::ptrdiff_t i,
+              const Real3<T> &p)
+{
+  const auto dx=points.x.cdata()[i]-p.x;
+  const auto dy=points.y.cdata()[i]-p.y;
+  const auto dz=points.z.cdata()[i]-p.z;
+  return dx*dx+dy*dy+dz*dz;
+}
+
+template<typename T>
+Real3<T>
+point_(const Points_<T> &points,
+       std::ptrdiff_t i)
+{
+  return {points.x.cdata()[i], points.y.cdata()[i], points.z.cdata()[i]};
+}
+
+template<typename T>
+int // 1 within the cutoff, 0 beyond, -1 too close to tell
+classify_(T sqr_distance,
+          T cutoff)
+{
+  const auto sqr_cutoff=cutoff*cutoff;
+  const auto margin=sqr_cutoff*T(1e-4);
+  return (sqr_distance<sqr_cutoff-margin) ? 1
+       : (sqr_distance>=sqr_cutoff+margin) ? 0 : -1;
+}
+
+template<typename CellListType,
+         typename T>
+void
+check_pairs_(const CellListType &cells,
+             const Points_<T> &points,
+             int part_count)
+{
+  const auto count=points.x.count();
+  const auto cutoff=cells.cutoff();
+  auto found=std::vector<std::pair<std::ptrdiff_t, std::ptrdiff_t>>{};
+  for(auto part_id=0; part_id<part_count; ++part_id)
+  {
+    cells.for_each_pair(part_id, part_count,
+      [&](std::ptrdiff_t i, std::ptrdiff_t j, T sqr_distance)
+      {
+        DIM_CHECK(i!=j);
+        DIM_CHECK(classify_(sqr_distance, cutoff)!=0);
+        found.emplace_back(std::min(i, j), std::max(i, j));
+      });
+  }
+  std::sort(begin(found), end(found));
+  // each pair exactly once
+  DIM_CHECK(std::adjacent_find(begin(found), end(found))==end(found));
+  auto it=begin(found);
+  for(auto i=std::ptrdiff_t{}; i<count; ++i)
+  {
+    for(auto j=i+1; j<count; ++j)
+    {
+      const auto c=classify_(sqr_distance_(points, j, point_(points, i)),
+                             cutoff);
+      const auto is_found=(it!=end(found))&&(*it==std::make_pair(i, j));
+      if(is_found)
+      {
+        ++it;
+      }
+      if(c>=0)
+      {
+        DIM_CHECK(is_found==(c==1));
+      }
+    }
+  }
+  DIM_CHECK(it==end(found));
+}
+
+template<typename CellListType,
+         typename T>
+void
+check_neighbours_(const CellListType &cells,
+                  const Points_<T> &points,
+                  const Real3<T> &p)
+{
+  const auto count=points.x.count();
+  auto list=std::vector<std::ptrdiff_t>{};
+  cells.neighbours(p, list);
+  std::sort(begin(list), end(list));
+  DIM_CHECK(std::adjacent_find(begin(list), end(list))==end(list));
+  for(auto j=std::ptrdiff_t{}; j<count; ++j)
+  {
+    const auto c=classify_(sqr_distance_(points, j, p), cells.cutoff());
+    if(c>=0)
+    {
+      DIM_CHECK(std::binary_search(begin(list), end(list), j)==(c==1));
+    }
+  }
+}
+
+template<typename T,
+         int VectorSize>
+void
+test_cell_list_(std::ptrdiff_t count,
+                T cutoff)
+{
+  auto gen=std::mt19937_64{std::uint64_t(count*VectorSize)};
+  auto points=random_points_<T>(count, gen);
+  const auto skin=T(0.1);
+  for(const auto part_count: {1, 3, 7})
+  {
+    auto cells=CellList<T, VectorSize>{count, {0, 0, 0}, {1, 1, 1},
+                                       cutoff, skin};
+    for(auto part_id=0; part_id<part_count; ++part_id)
+    {
+      cells.bin(points.x, points.y, points.z, part_id, part_count);
+    }
+    cells.index();
+    for(auto part_id=0; part_id<part_count; ++part_id)
+    {
+      cells.fill(points.x, points.y, points.z, part_id, part_count);
+    }
+    check_pairs_(cells, points, part_count);
+    for(auto i=std::ptrdiff_t{}; i<std::min(count, std::ptrdiff_t{20}); ++i)
+    {
+      check_neighbours_(cells, points, point_(points, i));
+      check_neighbours_(cells, points, point_(random_points_<T>(1, gen), 0));
+    }
+    // small moves: update() is enough
+    auto move=std::uniform_real_distribution<T>{-skin/4, skin/4};
+    for(auto i=std::ptrdiff_t{}; i<count; ++i)
+    {
+      points.x.data()[i]+=move(gen)/2;
+      points.y.data()[i]+=move(gen)/2;
+      points.z.data()[i]+=move(gen)/2;
+    }
+    auto valid=true;
+    for(auto part_id=0; part_id<part_count; ++part_id)
+    {
+      valid=cells.update(points.x, points.y, points.z,
+                         part_id, part_count)&&valid;
+    }
+    DIM_CHECK(valid);
+    check_pairs_(cells, points, part_count);
+    check_neighbours_(cells, points, point_(points, 0));
+    // a large move: some part detects it, and a build is needed
+    points.x.data()[count/2]+=skin;
+    valid=true;
+    for(auto part_id=0; part_id<part_count; ++part_id)
+    {
+      valid=cells.update(points.x, points.y, points.z,
+                         part_id, part_count)&&valid;
+    }
+    DIM_CHECK(!valid);
+    cells.build(points.x, points.y, points.z);
+    check_pairs_(cells, points, part_count);
+    check_neighbours_(cells, points, point_(points, count/2));
+  }
+}
+
+template<typename T,
+         int VectorSize>
+void
+test_counts_()
+{
+  for(const auto count: {std::ptrdiff_t{1}, std::ptrdiff_t{63},
+                         std::ptrdiff_t{500}})
+  {
+    test_cell_list_<T, VectorSize>(count, T(0.3));
+    test_cell_list_<T, VectorSize>(count, T(0.07));
+  }
+}
+
+int
+main()
+{
+  test_counts_<float, 16>();
+  test_counts_<float, default_vector_size>();
+  test_counts_<double, 16>();
+  test_counts_<double, default_vector_size>();
+  return test::check_result();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -0,0 +1,69 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef DIM_TESTS_CHECK_HPP
+#define DIM_TESTS_CHECK_HPP
+
+#include <iostream>
+#include <chrono>
+
+// DIM_CHECK(cond) reports a failed condition and counts it; a test
+// program returns check_result() from main(), thus the failures make
+// `make check` fail.
+
+namespace dim::test {
+
+inline
+int &
+failure_count()
+{
+  static auto count=0;
+  return count;
+}
+
+inline
+int
+check_result()
+{
+  if(failure_count())
+  {
+    std::cerr << failure_count() << " failed check(s)\n";
+    return 1;
+  }
+  return 0;
+}
+
+template<typename Fnct>
+inline
+double // seconds per call of fnct(), over at least min_seconds
+time_per_call(Fnct fnct,
+              double min_seconds=0.2)
+{
+  using clock_t = std::chrono::steady_clock;
+  fnct(); // warm up
+  auto count=0LL;
+  const auto start=clock_t::now();
+  auto elapsed=0.0;
+  do
+  {
+    fnct();
+    ++count;
+    elapsed=std::chrono::duration<double>(clock_t::now()-start).count();
+  } while(elapsed<min_seconds);
+  return elapsed/double(count);
+}
+
+} // namespace dim::test
+
+#define DIM_CHECK(cond)                                               \
+  do                                                                  \
+  {                                                                   \
+    if(!(cond))                                                       \
+    {                                                                 \
+      std::cerr << __FILE__ << ':' << __LINE__ << ": " #cond "\n";    \
+      ++dim::test::failure_count();                                   \
+    }                                                                 \
+  } while(0)
+
+#endif // DIM_TESTS_CHECK_HPP
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
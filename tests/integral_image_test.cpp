@@ -0,0 +1,174 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "check.hpp"
+
+#include "integral_image.hpp"
+
+#include <random>
+
+// IntegralImage::build() for widths which are, or are not, multiples of the
+// simd value count, then sum() on every rectangle (inner, on the edges,
+// empty) against a brute-force sum of the source values.
+// Then bands of rows are modified and rebuilt with build_rows() in every
+// part followed by build_columns() in every part (1, 3 and 7 parts), which
+// must give the same table as a full build.
+// The values are small integers, thus every sum is exact.
+
+using namespace dim;
+
+template<typename T>
+void
+random_rows_(AlignedBuffer2D<T> &src,
+             std::mt19937_64 &gen,
+             std::ptrdiff_t y_begin,
+             std::ptrdiff_t y_end)
+{
+  for(auto y=y_begin; y<y_end; ++y)
+  {
+    for(auto x=std::ptrdiff_t{}; x<src.width(); ++x)
+    {
+      src.row(y)[x]=std::is_signed_v<T> ? T(int(gen()%201)-100)
+                                        : T(gen()%256);
+    }
+  }
+}
+
+template<typename T,
+         typename AccumType>
+AccumType
+brute_force_(const AlignedBuffer2D<T> &src,
+             std::ptrdiff_t x, std::ptrdiff_t y,
+             std::ptrdiff_t w, std::ptrdiff_t h)
+{
+  auto result=AccumType{};
+  for(auto row=y; row<y+h; ++row)
+  {
+    for(auto col=x; col<x+w; ++col)
+    {
+      result+=AccumType(src.crow(row)[col]);
+    }
+  }
+  return result;
+}
+
+template<typename T,
+         typename AccumType>
+void
+check_sums_(const IntegralImage<T, AccumType> &integral,
+            const AlignedBuffer2D<T> &src)
+{
+  const auto width=src.width(), height=src.height();
+  // every rectangle of a small image, a sample of them otherwise
+  const auto step=std::ptrdiff_t{(width*height<=400) ? 1 : 5};
+  for(auto y=std::ptrdiff_t{}; y<=height; y+=step)
+  {
+    for(auto x=std::ptrdiff_t{}; x<=width; x+=step)
+    {
+      for(const auto h: {std::ptrdiff_t{0}, std::ptrdiff_t{1}, height-y})
+      {
+        for(const auto w: {std::ptrdiff_t{0}, std::ptrdiff_t{1},
+                           (width-x)/2, width-x})
+        {
+          if((y+h>height)||(x+w>width))
+          {
+            continue;
+          }
+          DIM_CHECK(integral.sum(x, y, w, h)==
+                    (brute_force_<T, AccumType>(src, x, y, w, h)));
+        }
+      }
+    }
+  }
+  DIM_CHECK(integral.sum(0, 0, width, height)==
+            (brute_force_<T, AccumType>(src, 0, 0, width, height)));
+}
+
+template<typename T,
+         typename AccumType>
+bool
+same_table_(const IntegralImage<T, AccumType> &a,
+            const IntegralImage<T, AccumType> &b)
+{
+  for(auto y=std::ptrdiff_t{}; y<=a.height(); ++y)
+  {
+    for(auto x=std::ptrdiff_t{}; x<=a.width(); ++x)
+    {
+      if(a.table().crow(y)[x]!=b.table().crow(y)[x])
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+template<typename T>
+void
+test_integral_image_()
+{
+  using integral_t = IntegralImage<T>;
+  using accum_t = typename integral_t::accum_t;
+  auto gen=std::mt19937_64{sizeof(T)};
+  for(const auto width: {1, 3, 7, 8, 16, 33, 64, 101})
+  {
+    for(const auto height: {1, 2, 9, 23})
+    {
+      auto src=AlignedBuffer2D<T>{width, height};
+      random_rows_(src, gen, 0, height);
+      auto integral=integral_t{width, height};
+      integral.build(src);
+      check_sums_(integral, src);
+      // bands: at the top, inner, a single row, at the bottom, everything
+      const std::ptrdiff_t bands[][2]={{0, 1}, {height/3, 2*height/3+1},
+                                       {height/2, height/2+1},
+                                       {height-1, height}, {0, height}};
+      for(const auto part_count: {1, 3, 7})
+      {
+        for(const auto &[y_begin, y_end]: bands)
+        {
+          random_rows_(src, gen, y_begin, y_end);
+          for(auto part_id=0; part_id<part_count; ++part_id)
+          {
+            integral.build_rows(src, part_id, part_count, y_begin, y_end);
+          }
+          for(auto part_id=0; part_id<part_count; ++part_id)
+          {
+            integral.build_columns(part_id, part_count, y_begin, y_end);
+          }
+          auto reference=integral_t{width, height};
+          reference.build(src);
+          DIM_CHECK(same_table_(integral, reference));
+        }
+        check_sums_(integral, src);
+      }
+      // a full build in several parts
+      for(const auto part_count: {3, 7})
+      {
+        auto parts=integral_t{width, height};
+        for(auto part_id=0; part_id<part_count; ++part_id)
+        {
+          parts.build_rows(src, part_id, part_count);
+        }
+        for(auto part_id=0; part_id<part_count; ++part_id)
+        {
+          parts.build_columns(part_id, part_count);
+        }
+        DIM_CHECK(same_table_(parts, integral));
+        DIM_CHECK(parts.sum(0, 0, width, height)==
+                  (brute_force_<T, accum_t>(src, 0, 0, width, height)));
+      }
+    }
+  }
+}
+
+int
+main()
+{
+  test_integral_image_<std::uint8_t>();
+  test_integral_image_<std::int32_t>();
+  test_integral_image_<float>();
+  test_integral_image_<double>();
+  return test::check_result();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -0,0 +1,127 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "check.hpp"
+
+#include "queue_lock.hpp"
+#include "team.hpp"
+
+#include <atomic>
+#include <thread>
+
+// McsLock and CohortLock (handing the lock over once, then up to the
+// default limit, within a numa node) under a Team of 4 threads: every part
+// increments a plain counter many times within the lock, which must end
+// with the exact count, and no two parts may ever hold the lock together.
+// Then the same with try_lock() retried until it succeeds, and try_lock()
+// failing on a held lock.
+
+using namespace dim;
+
+struct Shared_
+{
+  long long counter{};
+  std::atomic<int> owners{};
+  std::atomic<int> overlaps{};
+
+  void
+  increment()
+  {
+    if(owners.fetch_add(1, std::memory_order_relaxed))
+    {
+      overlaps.fetch_add(1, std::memory_order_relaxed);
+    }
+    ++counter;
+    owners.fetch_sub(1, std::memory_order_relaxed);
+  }
+};
+
+template<typename LockFnct,
+         typename UnlockFnct>
+void
+stress_(Team &team,
+        LockFnct lock_fnct,     // lock_fnct(node, part_id)
+        UnlockFnct unlock_fnct) // unlock_fnct(node, part_id)
+{
+  constexpr auto iterations=2000;
+  auto shared=Shared_{};
+  team.run(
+    [&](int part_id, int)
+    {
+      // a node per thread, the same for lock and unlock
+      auto node=McsLock::Node{};
+      for(auto i=0; i<iterations; ++i)
+      {
+        lock_fnct(node, part_id);
+        shared.increment();
+        unlock_fnct(node, part_id);
+      }
+    });
+  DIM_CHECK(shared.counter==
+            static_cast<long long>(iterations)*team.thread_count());
+  DIM_CHECK(shared.overlaps.load()==0);
+}
+
+int
+main()
+{
+  const auto platform=cpu::Platform{};
+  auto team=Team{platform, 4};
+  {
+    auto lock=McsLock{};
+    stress_(team,
+      [&](McsLock::Node &node, int)
+      {
+        lock.lock(node);
+      },
+      [&](McsLock::Node &node, int)
+      {
+        lock.unlock(node);
+      });
+    stress_(team,
+      [&](McsLock::Node &node, int)
+      {
+        while(!lock.try_lock(node))
+        {
+          std::this_thread::yield();
+        }
+      },
+      [&](McsLock::Node &node, int)
+      {
+        lock.unlock(node);
+      });
+    auto owner=McsLock::Node{}, other=McsLock::Node{};
+    lock.lock(owner);
+    DIM_CHECK(!lock.try_lock(other));
+    lock.unlock(owner);
+    DIM_CHECK(lock.try_lock(other));
+    lock.unlock(other);
+  }
+  for(const auto pass_limit: {1, CohortLock::default_pass_limit})
+  {
+    auto lock=CohortLock{platform, pass_limit};
+    // the cohort of the cpu each part is bound to
+    stress_(team,
+      [&](CohortLock::Node &node, int part_id)
+      {
+        lock.lock(node, lock.cohort(part_id%platform.cpu_count()));
+      },
+      [&](CohortLock::Node &node, int part_id)
+      {
+        lock.unlock(node, lock.cohort(part_id%platform.cpu_count()));
+      });
+    // every part in the last cohort, thus many hand-overs within it
+    const auto last=lock.cohort_count()-1;
+    stress_(team,
+      [&](CohortLock::Node &node, int)
+      {
+        lock.lock(node, last);
+      },
+      [&](CohortLock::Node &node, int)
+      {
+        lock.unlock(node, last);
+      });
+  }
+  return test::check_result();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
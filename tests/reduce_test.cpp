@@ -0,0 +1,247 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "check.hpp"
+
+#include "reduce.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+// sum(), dot(), min(), max(), argmin(), argmax(), norm_l1(), sqr_norm_l2()
+// and count_if(), on a whole buffer and on regions of interest touching
+// the edges, computed in 1, 3 and 7 parts then combined, against a serial
+// loop; the values are small integers (with many ties for the extrema),
+// thus every sum is exact whatever the order.
+// Then NaN values, which the extrema must ignore, and parts with no
+// element at all.
+
+using namespace dim;
+
+template<typename T>
+struct Expected_
+{
+  T sum{}, dot{}, l1{}, l2{};
+  IndexedValue<T> lo{impl_::highest_<T>(), -1};
+  IndexedValue<T> hi{impl_::lowest_<T>(), -1};
+  std::ptrdiff_t positive{};
+};
+
+template<typename T>
+Expected_<T>
+serial_(const AlignedBuffer<T> &a,
+        const AlignedBuffer<T> &b,
+        std::ptrdiff_t width,
+        std::ptrdiff_t x, std::ptrdiff_t y, std::ptrdiff_t w, std::ptrdiff_t h)
+{
+  auto e=Expected_<T>{};
+  for(auto row=y; row<y+h; ++row)
+  {
+    for(auto id=row*width+x; id<row*width+x+w; ++id)
+    {
+      const auto v=a.cdata()[id];
+      e.sum+=v;
+      e.dot+=v*b.cdata()[id];
+      e.l1+=(v<T{}) ? T(-v) : v;
+      e.l2+=v*v;
+      e.positive+=(v>T{});
+      if(v<e.lo.value)
+      {
+        e.lo={v, id};
+      }
+      if(v>e.hi.value)
+      {
+        e.hi={v, id};
+      }
+    }
+  }
+  return e;
+}
+
+const auto positive_=
+  [](const auto &v)
+  {
+    using v_t = std::decay_t<decltype(v)>;
+    return v>v_t{0};
+  };
+
+template<typename T>
+void
+check_(const Expected_<T> &result,
+       const Expected_<T> &expected)
+{
+  DIM_CHECK(result.sum==expected.sum);
+  DIM_CHECK(result.dot==expected.dot);
+  DIM_CHECK(result.l1==expected.l1);
+  DIM_CHECK(result.l2==expected.l2);
+  DIM_CHECK(result.positive==expected.positive);
+  DIM_CHECK((result.lo.value==expected.lo.value)&&
+            (result.lo.index==expected.lo.index));
+  DIM_CHECK((result.hi.value==expected.hi.value)&&
+            (result.hi.index==expected.hi.index));
+}
+
+template<typename T>
+void
+combine_(Expected_<T> &result,
+         T sum, T dot, T l1, T l2, std::ptrdiff_t positive,
+         T lo, T hi, IndexedValue<T> arg_lo, IndexedValue<T> arg_hi)
+{
+  result.sum+=sum;
+  result.dot+=dot;
+  result.l1+=l1;
+  result.l2+=l2;
+  result.positive+=positive;
+  // min() and max() must agree with argmin() and argmax()
+  DIM_CHECK(lo==arg_lo.value);
+  DIM_CHECK(hi==arg_hi.value);
+  result.lo=merge_argmin(result.lo, arg_lo);
+  result.hi=merge_argmax(result.hi, arg_hi);
+}
+
+template<typename T>
+void
+test_reductions_()
+{
+  constexpr auto width=std::ptrdiff_t{203}, height=std::ptrdiff_t{37};
+  auto a=AlignedBuffer<T>{width*height}, b=AlignedBuffer<T>{width*height};
+  auto gen=std::mt19937_64{sizeof(T)};
+  for(auto i=std::ptrdiff_t{}; i<width*height; ++i)
+  {
+    a.data()[i]=T(int(gen()%61)-30);
+    b.data()[i]=T(int(gen()%7)-3);
+  }
+  for(const auto part_count: {1, 3, 7})
+  {
+    // whole buffer
+    auto result=Expected_<T>{};
+    for(auto part_id=0; part_id<part_count; ++part_id)
+    {
+      combine_(result,
+               sum(a, part_id, part_count), dot(a, b, part_id, part_count),
+               norm_l1(a, part_id, part_count),
+               sqr_norm_l2(a, part_id, part_count),
+               count_if(a, part_id, part_count, positive_),
+               min(a, part_id, part_count), max(a, part_id, part_count),
+               argmin(a, part_id, part_count),
+               argmax(a, part_id, part_count));
+    }
+    check_(result, serial_(a, b, width, 0, 0, width, height));
+    // regions of interest: inner, on the left edge (a single column), on
+    // the right edge, and the whole image
+    const std::ptrdiff_t rois[][4]={{5, 3, 61, 30}, {0, 0, 1, height},
+                                    {width-13, 1, 13, height-1},
+                                    {0, 0, width, height}};
+    for(const auto &[x, y, w, h]: rois)
+    {
+      auto roi=Expected_<T>{};
+      for(auto part_id=0; part_id<part_count; ++part_id)
+      {
+        combine_(roi,
+          sum(a, part_id, part_count, width, height, x, y, w, h),
+          dot(a, b, part_id, part_count, width, height, x, y, w, h),
+          norm_l1(a, part_id, part_count, width, height, x, y, w, h),
+          sqr_norm_l2(a, part_id, part_count, width, height, x, y, w, h),
+          count_if(a, part_id, part_count, width, height, x, y, w, h,
+                   positive_),
+          min(a, part_id, part_count, width, height, x, y, w, h),
+          max(a, part_id, part_count, width, height, x, y, w, h),
+          argmin(a, part_id, part_count, width, height, x, y, w, h),
+          argmax(a, part_id, part_count, width, height, x, y, w, h));
+      }
+      check_(roi, serial_(a, b, width, x, y, w, h));
+    }
+  }
+}
+
+template<typename T>
+void
+test_nan_()
+{
+  constexpr auto nan=std::numeric_limits<T>::quiet_NaN();
+  constexpr auto count=std::ptrdiff_t{64};
+  for(const auto nan_index: {std::ptrdiff_t{0}, std::ptrdiff_t{40},
+                             count-1})
+  {
+    auto a=AlignedBuffer<T>{count};
+    for(auto i=std::ptrdiff_t{}; i<count; ++i)
+    {
+      a.data()[i]=T(i+1);
+    }
+    const auto lowest=(nan_index==0) ? T(2) : T(1);
+    const auto highest=(nan_index==count-1) ? T(count-1) : T(count);
+    a.data()[nan_index]=nan;
+    for(const auto part_count: {1, 3, 7})
+    {
+      auto lo=IndexedValue<T>{impl_::highest_<T>(), -1};
+      auto hi=IndexedValue<T>{impl_::lowest_<T>(), -1};
+      for(auto part_id=0; part_id<part_count; ++part_id)
+      {
+        const auto arg_lo=argmin(a, part_id, part_count);
+        const auto arg_hi=argmax(a, part_id, part_count);
+        DIM_CHECK(!std::isnan(min(a, part_id, part_count)));
+        DIM_CHECK(!std::isnan(max(a, part_id, part_count)));
+        // no index only for a part with no number (there may be empty
+        // parts with wide vectors)
+        DIM_CHECK((arg_lo.index>=0)||(arg_lo.value==impl_::highest_<T>()));
+        DIM_CHECK((arg_hi.index>=0)||(arg_hi.value==impl_::lowest_<T>()));
+        lo=merge_argmin(lo, arg_lo);
+        hi=merge_argmax(hi, arg_hi);
+      }
+      DIM_CHECK((lo.value==lowest)&&(lo.index==std::ptrdiff_t(lowest)-1));
+      DIM_CHECK((hi.value==highest)&&(hi.index==std::ptrdiff_t(highest)-1));
+    }
+  }
+  // only NaNs: the same as an empty part
+  auto a=AlignedBuffer<T>{count};
+  std::fill(a.data(), a.data()+count, nan);
+  DIM_CHECK(min(a, 0, 1)==impl_::highest_<T>());
+  DIM_CHECK(max(a, 0, 1)==impl_::lowest_<T>());
+  DIM_CHECK(argmin(a, 0, 1).index==-1);
+  DIM_CHECK(argmax(a, 0, 1).index==-1);
+}
+
+template<typename T>
+void
+test_empty_parts_()
+{
+  // more parts than values: some parts have nothing to consider
+  auto a=AlignedBuffer<T>{3};
+  a.data()[0]=T(5);
+  a.data()[1]=T(-2);
+  a.data()[2]=T(7);
+  constexpr auto part_count=64;
+  auto total=T{};
+  auto lo=IndexedValue<T>{impl_::highest_<T>(), -1};
+  auto hi=IndexedValue<T>{impl_::lowest_<T>(), -1};
+  for(auto part_id=0; part_id<part_count; ++part_id)
+  {
+    total+=sum(a, part_id, part_count);
+    const auto arg_lo=argmin(a, part_id, part_count);
+    if(arg_lo.index<0)
+    {
+      DIM_CHECK(arg_lo.value==impl_::highest_<T>());
+    }
+    lo=merge_argmin(lo, arg_lo);
+    hi=merge_argmax(hi, argmax(a, part_id, part_count));
+  }
+  DIM_CHECK(total==T(10));
+  DIM_CHECK((lo.value==T(-2))&&(lo.index==1));
+  DIM_CHECK((hi.value==T(7))&&(hi.index==2));
+}
+
+int
+main()
+{
+  test_reductions_<float>();
+  test_reductions_<double>();
+  test_reductions_<std::int32_t>();
+  test_nan_<float>();
+  test_nan_<double>();
+  test_empty_parts_<float>();
+  test_empty_parts_<std::int32_t>();
+  return test::check_result();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
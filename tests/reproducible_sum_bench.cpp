@@ -0,0 +1,78 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "check.hpp"
+
+#include "reduce.hpp"
+
+#include <iomanip>
+
+// Cost per value of ReproducibleSum (accumulate() on the whole buffer then
+// result(), in the calling thread), plain and compensated, against sum(),
+// from buffers which stay in the L1 cache to buffers far larger than the
+// caches.
+
+using namespace dim;
+
+template<typename T>
+void
+bench_(std::ptrdiff_t count)
+{
+  auto buffer=AlignedBuffer<T>{count};
+  for(auto i=std::ptrdiff_t{}; i<count; ++i)
+  {
+    buffer.data()[i]=T(i%1000)*T(0.001);
+  }
+  const auto ns=
+    [&](auto fnct)
+    {
+      return 1e9*test::time_per_call(fnct)/double(count);
+    };
+  auto result=T{};
+  const auto naive=ns(
+    [&]()
+    {
+      result+=sum(buffer, 0, 1);
+    });
+  auto plain_sum=ReproducibleSum<T>{count};
+  const auto plain=ns(
+    [&]()
+    {
+      plain_sum.accumulate(buffer, 0, 1);
+      result+=plain_sum.result();
+    });
+  auto compensated_sum=ReproducibleSum<T, true>{count};
+  const auto compensated=ns(
+    [&]()
+    {
+      compensated_sum.accumulate(buffer, 0, 1);
+      result+=compensated_sum.result();
+    });
+  std::cout << std::setw(9) << count << " values:" << std::fixed
+            << std::setprecision(3)
+            << "  sum() " << naive << " ns,"
+            << "  plain " << plain << " ns (x" << std::setprecision(2)
+            << plain/naive << "),"
+            << "  compensated " << std::setprecision(3) << compensated
+            << " ns (x" << std::setprecision(2) << compensated/naive
+            << ")\n" << std::defaultfloat;
+  asm volatile("" :: "r"(&result) : "memory");
+}
+
+int
+main()
+{
+  std::cout << "vector size: " << simd::max_vector_size << " bytes\n";
+  for(const auto count: {4096, 65536, 262144, 1<<24})
+  {
+    std::cout << "double ";
+    bench_<double>(count);
+  }
+  for(const auto count: {4096, 65536, 262144, 1<<24})
+  {
+    std::cout << "float  ";
+    bench_<float>(count);
+  }
+  return 0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -0,0 +1,141 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "check.hpp"
+
+#include "team.hpp"
+
+#include <cstring>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+// ReproducibleSum, plain and compensated, must give bit-identical results
+// whatever the part count (1, 3 and 7 parts, then through Team with 1, 3
+// and 8 threads), on values spanning many magnitudes with both signs, so
+// that any change in the order of the additions would show up.
+// The compensated sum must also stay close to a long double reference.
+// A buffer count which does not match is rejected by Team::sum() before
+// the dispatch.
+
+using namespace dim;
+
+template<typename T>
+bool
+same_bits_(T a,
+           T b)
+{
+  return !std::memcmp(&a, &b, sizeof(T));
+}
+
+template<typename T>
+AlignedBuffer<T>
+random_values_(std::ptrdiff_t count)
+{
+  auto gen=std::mt19937_64{std::uint64_t(count)};
+  auto buffer=AlignedBuffer<T>{count};
+  for(auto i=std::ptrdiff_t{}; i<count; ++i)
+  {
+    if constexpr(std::is_floating_point_v<T>)
+    {
+      auto mantissa=std::uniform_real_distribution<T>{T(-1), T(1)};
+      auto exponent=std::uniform_int_distribution<int>{-20, 20};
+      buffer.data()[i]=std::ldexp(mantissa(gen), exponent(gen));
+    }
+    else
+    {
+      buffer.data()[i]=T(std::int32_t(gen()));
+    }
+  }
+  return buffer;
+}
+
+template<typename T,
+         bool Compensated>
+T
+sum_in_parts_(const AlignedBuffer<T> &buffer,
+              int part_count)
+{
+  auto reproducible_sum=ReproducibleSum<T, Compensated>{buffer.count()};
+  // in reverse order, as if the last parts were the quickest
+  for(auto part_id=part_count-1; part_id>=0; --part_id)
+  {
+    reproducible_sum.accumulate(buffer, part_id, part_count);
+  }
+  return reproducible_sum.result();
+}
+
+template<typename T,
+         bool Compensated>
+void
+test_reproducible_(const cpu::Platform &platform)
+{
+  using sum_t = ReproducibleSum<T, Compensated>;
+  for(const auto count: {std::ptrdiff_t{0}, std::ptrdiff_t{1},
+                         sum_t::block_size-1, sum_t::block_size+1,
+                         std::ptrdiff_t{100003}})
+  {
+    const auto buffer=random_values_<T>(count);
+    const auto reference=sum_in_parts_<T, Compensated>(buffer, 1);
+    for(const auto part_count: {3, 7})
+    {
+      DIM_CHECK(same_bits_(sum_in_parts_<T, Compensated>(buffer, part_count),
+                           reference));
+    }
+    for(const auto thread_count: {1, 3, 8})
+    {
+      auto team=Team{platform, thread_count};
+      auto reproducible_sum=sum_t{count};
+      DIM_CHECK(same_bits_(team.sum(buffer, reproducible_sum), reference));
+    }
+    if constexpr(Compensated)
+    {
+      auto exact=0.0L;
+      for(auto i=std::ptrdiff_t{}; i<count; ++i)
+      {
+        exact+=buffer.cdata()[i];
+      }
+      // a few ulps of the result, whatever the count
+      const auto tolerance=
+        4.0L*std::numeric_limits<T>::epsilon()*std::abs(exact)+
+        std::numeric_limits<T>::min();
+      DIM_CHECK(std::abs(reference-exact)<=tolerance);
+    }
+  }
+}
+
+void
+test_count_mismatch_(const cpu::Platform &platform)
+{
+  auto team=Team{platform, 3};
+  const auto buffer=random_values_<double>(100);
+  auto reproducible_sum=ReproducibleSum<double>{50};
+  auto caught=false;
+  try
+  {
+    team.sum(buffer, reproducible_sum);
+  }
+  catch(const std::runtime_error &)
+  {
+    caught=true;
+  }
+  DIM_CHECK(caught);
+  // the team is still usable
+  auto right_sum=ReproducibleSum<double>{buffer.count()};
+  DIM_CHECK(same_bits_(team.sum(buffer, right_sum),
+                       sum_in_parts_<double, false>(buffer, 1)));
+}
+
+int
+main()
+{
+  const auto platform=cpu::Platform{};
+  test_reproducible_<float, false>(platform);
+  test_reproducible_<float, true>(platform);
+  test_reproducible_<double, false>(platform);
+  test_reproducible_<double, true>(platform);
+  test_reproducible_<std::int64_t, false>(platform);
+  test_count_mismatch_(platform);
+  return test::check_result();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
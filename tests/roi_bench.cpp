@@ -0,0 +1,78 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "check.hpp"
+
+#include "aligned_buffer.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <iomanip>
+
+// Cost per row of fill() and sum() over a region of interest whose rows
+// are narrower than 64 values, thus mostly made of the masked prefix and
+// suffix of the row, against std::fill() and std::accumulate() on each
+// row.  The rows start at x=3, never aligned on a vector, and the buffer
+// stays in the L2 cache.
+
+using namespace dim;
+
+int
+main()
+{
+  constexpr auto width=std::ptrdiff_t{80}, height=std::ptrdiff_t{512};
+  constexpr auto x=std::ptrdiff_t{3}, y=std::ptrdiff_t{0};
+  auto buffer=AlignedBuffer<float>{width*height};
+  fill(buffer, 0, 1, 1.0f);
+  std::cout << "vector size: " << simd::max_vector_size << " bytes, "
+            << height << " rows\n";
+  for(const auto w: {1, 5, 13, 16, 37, 61, 64})
+  {
+    const auto ns=
+      [&](auto fnct)
+      {
+        return 1e9*test::time_per_call(fnct)/double(height);
+      };
+    auto result=0.0f;
+    const auto std_fill=ns(
+      [&]()
+      {
+        for(auto row=y; row<y+height; ++row)
+        {
+          auto *d=buffer.data()+row*width+x;
+          std::fill(d, d+w, 2.0f);
+        }
+        asm volatile("" :: "r"(buffer.data()) : "memory");
+      });
+    const auto roi_fill=ns(
+      [&]()
+      {
+        fill(buffer, 0, 1, width, height, x, y, w, height, 2.0f);
+        asm volatile("" :: "r"(buffer.data()) : "memory");
+      });
+    const auto std_sum=ns(
+      [&]()
+      {
+        auto s=0.0f;
+        for(auto row=y; row<y+height; ++row)
+        {
+          const auto *d=buffer.cdata()+row*width+x;
+          s=std::accumulate(d, d+w, s);
+        }
+        result+=s;
+      });
+    const auto roi_sum=ns(
+      [&]()
+      {
+        result+=sum(buffer, 0, 1, width, height, x, y, w, height);
+      });
+    std::cout << "w=" << std::setw(2) << w << std::fixed
+              << std::setprecision(1)
+              << ":  fill " << std_fill << " -> " << roi_fill
+              << " ns/row,  sum " << std_sum << " -> " << roi_sum
+              << " ns/row\n" << std::defaultfloat;
+    asm volatile("" :: "r"(&result) : "memory");
+  }
+  return 0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -0,0 +1,147 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "check.hpp"
+
+#include "simd.hpp"
+
+#include <cstdint>
+#include <algorithm>
+#include <vector>
+
+// gather(), scatter() (full and masked) and scatter_add() with repeated
+// indices (the conflict detection of AVX-512), for 32 and 64-bit values
+// and indices, against a per-lane computation.  The masked lanes get an
+// index far out of the table, thus an access would be detected by the
+// sanitizers (or crash).
+
+using namespace dim;
+
+template<typename T,
+         typename I,
+         int ValueCount>
+void
+test_gather_scatter_()
+{
+  using value_t = simd::simd_t<T, ValueCount*int(sizeof(T))>;
+  using index_t = simd::simd_t<I, ValueCount*int(sizeof(I))>;
+  using mask_t = typename value_t::mask_type;
+  constexpr auto table_size=3*ValueCount;
+  constexpr auto far=I{1}<<28;
+  alignas(64) T table[table_size];
+  for(auto i=0; i<table_size; ++i)
+  {
+    table[i]=T(10*i+1);
+  }
+  auto v=typename value_t::vector_type{};
+  auto idx=typename index_t::vector_type{};
+  auto m=typename mask_t::vector_type{};
+  for(auto i=0; i<ValueCount; ++i)
+  {
+    v[i]=T(i+1);
+    idx[i]=I((7*i+2)%table_size);
+    m[i]=(i%3!=1) ? -1 : 0;
+  }
+  const auto values=value_t{v}, index=index_t{idx}, mask=mask_t{m};
+  auto far_idx=idx;
+  for(auto i=0; i<ValueCount; ++i)
+  {
+    far_idx[i]=m[i] ? idx[i] : far;
+  }
+  const auto far_index=index_t{far_idx};
+  // gather
+  const auto g=simd::gather(index, table);
+  const auto mg=simd::gather(far_index, table, mask, value_t{T(-1)});
+  for(auto i=0; i<ValueCount; ++i)
+  {
+    DIM_CHECK(g[i]==table[idx[i]]);
+    DIM_CHECK(mg[i]==(m[i] ? table[idx[i]] : T(-1)));
+  }
+  // scatter (the indices are distinct here)
+  alignas(64) T dst[table_size]={};
+  simd::scatter(values, index, dst);
+  alignas(64) T mdst[table_size]={};
+  simd::scatter(values, far_index, mdst, mask);
+  auto expected=std::vector<T>(table_size), mexpected=expected;
+  for(auto i=0; i<ValueCount; ++i)
+  {
+    expected[idx[i]]=v[i];
+    if(m[i])
+    {
+      mexpected[idx[i]]=v[i];
+    }
+  }
+  for(auto i=0; i<table_size; ++i)
+  {
+    DIM_CHECK(dst[i]==expected[i]);
+    DIM_CHECK(mdst[i]==mexpected[i]);
+  }
+  // repeated indices: the last lane wins for scatter(), all the values
+  // are added for scatter_add(), whatever the length of the chains
+  for(const auto modulo: {1, 2, 3, ValueCount/2+1, ValueCount})
+  {
+    auto ridx=typename index_t::vector_type{};
+    for(auto i=0; i<ValueCount; ++i)
+    {
+      ridx[i]=I((i*5)%modulo);
+    }
+    const auto repeated=index_t{ridx};
+    alignas(64) T last[table_size]={};
+    simd::scatter(values, repeated, last);
+    alignas(64) T acc[table_size];
+    for(auto i=0; i<table_size; ++i)
+    {
+      acc[i]=T(i);
+    }
+    simd::scatter_add(values, repeated, acc);
+    auto last_expected=std::vector<T>(table_size);
+    auto acc_expected=std::vector<T>(table_size);
+    for(auto i=0; i<table_size; ++i)
+    {
+      acc_expected[i]=T(i);
+    }
+    for(auto i=0; i<ValueCount; ++i)
+    {
+      last_expected[ridx[i]]=v[i];
+      acc_expected[ridx[i]]+=v[i];
+    }
+    for(auto i=0; i<table_size; ++i)
+    {
+      DIM_CHECK(last[i]==last_expected[i]);
+      DIM_CHECK(acc[i]==acc_expected[i]);
+    }
+  }
+}
+
+template<typename T,
+         typename I,
+         int ValueCount>
+void
+test_all_sizes_()
+{
+  // every value count for which both vectors exist (16 to 64 bytes)
+  constexpr auto narrowest=int(std::min(sizeof(T), sizeof(I)));
+  constexpr auto widest=int(std::max(sizeof(T), sizeof(I)));
+  if constexpr(ValueCount*widest<=simd::dispatch_vector_size_limit)
+  {
+    if constexpr(ValueCount*narrowest>=16)
+    {
+      test_gather_scatter_<T, I, ValueCount>();
+    }
+    test_all_sizes_<T, I, 2*ValueCount>();
+  }
+}
+
+int
+main()
+{
+  test_all_sizes_<float, std::int32_t, 1>();
+  test_all_sizes_<float, std::int64_t, 1>();
+  test_all_sizes_<double, std::int32_t, 1>();
+  test_all_sizes_<double, std::int64_t, 1>();
+  test_all_sizes_<std::int32_t, std::int32_t, 1>();
+  test_all_sizes_<std::int64_t, std::int64_t, 1>();
+  test_all_sizes_<std::uint32_t, std::int64_t, 1>();
+  return test::check_result();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
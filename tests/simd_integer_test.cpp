@@ -0,0 +1,205 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "check.hpp"
+
+#include "reduce.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <algorithm>
+#include <iterator>
+
+// The saturating, averaging and widening operations of simd_integer.hpp,
+// for 8 to 32-bit values at every vector size, and sum_abs_diff(), against
+// a per-lane computation in 64-bit integers; the random lanes often take
+// the limits of the type, where saturation happens.
+
+using namespace dim;
+
+template<typename SimdType>
+SimdType
+random_(std::mt19937_64 &gen)
+{
+  using value_t = typename SimdType::value_type;
+  using limits_t = std::numeric_limits<value_t>;
+  const value_t specials[]={limits_t::min(), limits_t::max(), value_t(0),
+                            value_t(1), value_t(limits_t::max()-1),
+                            value_t(limits_t::min()+1)};
+  auto v=typename SimdType::vector_type{};
+  for(auto i=0; i<SimdType::value_count; ++i)
+  {
+    const auto r=gen();
+    v[i]=(r%4==0) ? specials[(r>>8)%std::size(specials)]
+                  : value_t(r>>16);
+  }
+  return {v};
+}
+
+template<typename T>
+T
+clamp_(std::int64_t v)
+{
+  using limits_t = std::numeric_limits<T>;
+  return T(std::clamp(v, std::int64_t(limits_t::min()),
+                         std::int64_t(limits_t::max())));
+}
+
+template<typename T,
+         int VectorSize>
+void
+test_arithmetic_()
+{
+  using simd_t = simd::simd_t<T, VectorSize>;
+  using wide_t = std::conditional_t<std::is_signed_v<T>, std::int64_t,
+                                    std::uint64_t>;
+  auto gen=std::mt19937_64{sizeof(T)*VectorSize};
+  for(auto round=0; round<200; ++round)
+  {
+    const auto a=random_<simd_t>(gen), b=random_<simd_t>(gen);
+    const auto sum=simd::adds(a, b);
+    const auto diff=simd::subs(a, b);
+    const auto average=simd::avg(a, b);
+    const auto high=simd::mulhi(a, b);
+    const auto absolute=simd::absdiff(a, b);
+    for(auto i=0; i<simd_t::value_count; ++i)
+    {
+      const auto ai=std::int64_t(a[i]), bi=std::int64_t(b[i]);
+      DIM_CHECK(sum[i]==clamp_<T>(ai+bi));
+      DIM_CHECK(diff[i]==clamp_<T>(ai-bi));
+      // (a+b+1)>>1 rounds towards +infinity, also for negative sums
+      DIM_CHECK(average[i]==T((ai+bi+1)>>1));
+      DIM_CHECK(high[i]==T((wide_t(a[i])*wide_t(b[i]))>>(8*sizeof(T))));
+      DIM_CHECK(absolute[i]==T(ai>bi ? ai-bi : bi-ai));
+    }
+  }
+}
+
+template<typename T,
+         int VectorSize>
+void
+test_widen_narrow_()
+{
+  using simd_t = simd::simd_t<T, VectorSize>;
+  constexpr auto vc=simd_t::value_count;
+  auto gen=std::mt19937_64{3*sizeof(T)+VectorSize};
+  for(auto round=0; round<50; ++round)
+  {
+    const auto s=random_<simd_t>(gen);
+    const auto low=simd::widen_low(s), high=simd::widen_high(s);
+    static_assert(sizeof(low[0])==2*sizeof(T));
+    for(auto i=0; i<vc/2; ++i)
+    {
+      DIM_CHECK(std::int64_t(low[i])==std::int64_t(s[i]));
+      DIM_CHECK(std::int64_t(high[i])==std::int64_t(s[vc/2+i]));
+    }
+    if constexpr(sizeof(T)<=2)
+    {
+      // narrowing the wider values, signed or unsigned, into T
+      using wide_t = std::decay_t<decltype(low[0])>;
+      using wide_simd_t = simd::simd_t<wide_t, VectorSize>;
+      const auto wl=random_<wide_simd_t>(gen);
+      const auto wh=random_<wide_simd_t>(gen);
+      const auto n=simd::narrow<T>(wl, wh);
+      for(auto i=0; i<vc; ++i)
+      {
+        const auto w=(i<vc/2) ? wl[i] : wh[i-vc/2];
+        DIM_CHECK(n[i]==clamp_<T>(std::int64_t(w)));
+      }
+      DIM_CHECK(simd::all(simd::narrow<T>(low, high)==s));
+    }
+  }
+}
+
+template<int VectorSize>
+void
+test_sad_()
+{
+  using simd_t = simd::simd_t<std::uint8_t, VectorSize>;
+  auto gen=std::mt19937_64{VectorSize};
+  for(auto round=0; round<50; ++round)
+  {
+    const auto a=random_<simd_t>(gen), b=random_<simd_t>(gen);
+    const auto s=simd::sad(a, b);
+    for(auto g=0; g<simd_t::value_count/8; ++g)
+    {
+      auto expected=std::uint64_t{};
+      for(auto i=8*g; i<8*g+8; ++i)
+      {
+        expected+=std::uint64_t(a[i]>b[i] ? a[i]-b[i] : b[i]-a[i]);
+      }
+      DIM_CHECK(s[g]==expected);
+    }
+  }
+}
+
+template<typename T>
+void
+test_all_sizes_()
+{
+  test_arithmetic_<T, 16>();
+  test_arithmetic_<T, 32>();
+  test_arithmetic_<T, simd::dispatch_vector_size_limit>();
+  test_widen_narrow_<T, 16>();
+  test_widen_narrow_<T, 32>();
+  test_widen_narrow_<T, simd::dispatch_vector_size_limit>();
+}
+
+void
+test_sum_abs_diff_()
+{
+  constexpr auto width=std::ptrdiff_t{203}, height=std::ptrdiff_t{37};
+  auto a=AlignedBuffer<std::uint8_t>{width*height};
+  auto b=AlignedBuffer<std::uint8_t>{width*height};
+  auto gen=std::mt19937_64{42};
+  for(auto i=std::ptrdiff_t{}; i<width*height; ++i)
+  {
+    a.data()[i]=std::uint8_t(gen());
+    b.data()[i]=std::uint8_t(gen());
+  }
+  const auto expected=
+    [&](std::ptrdiff_t x, std::ptrdiff_t y,
+        std::ptrdiff_t w, std::ptrdiff_t h)
+    {
+      auto s=std::uint64_t{};
+      for(auto row=y; row<y+h; ++row)
+      {
+        for(auto col=x; col<x+w; ++col)
+        {
+          const auto i=row*width+col;
+          s+=std::uint64_t(std::abs(int(a.data()[i])-int(b.data()[i])));
+        }
+      }
+      return s;
+    };
+  for(const auto part_count: {1, 3})
+  {
+    auto whole=std::uint64_t{}, roi=std::uint64_t{};
+    for(auto part_id=0; part_id<part_count; ++part_id)
+    {
+      whole+=sum_abs_diff(a, b, part_id, part_count);
+      roi+=sum_abs_diff(a, b, part_id, part_count,
+                        width, height, 5, 3, 61, 30);
+    }
+    DIM_CHECK(whole==expected(0, 0, width, height));
+    DIM_CHECK(roi==expected(5, 3, 61, 30));
+  }
+}
+
+int
+main()
+{
+  test_all_sizes_<std::uint8_t>();
+  test_all_sizes_<std::int8_t>();
+  test_all_sizes_<std::uint16_t>();
+  test_all_sizes_<std::int16_t>();
+  test_all_sizes_<std::uint32_t>();
+  test_all_sizes_<std::int32_t>();
+  test_sad_<16>();
+  test_sad_<32>();
+  test_sad_<simd::dispatch_vector_size_limit>();
+  test_sum_abs_diff_();
+  return test::check_result();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -0,0 +1,125 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "check.hpp"
+
+#include "aligned_buffer.hpp"
+#include "simd_real3.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// load3/store3 and load4/store4 at every vector size, then
+// deinterleave()/interleave() between an array of xyz triples and three
+// buffers, with element counts which are not multiples of the vectors;
+// the values of the triples are unique, thus any misplaced lane shows up.
+
+using namespace dim;
+
+template<typename T,
+         int VectorSize>
+void
+test_load_store_()
+{
+  using simd_t = simd::simd_t<T, VectorSize>;
+  constexpr auto vc=simd_t::value_count;
+  auto aos=std::vector<T>(4*vc+1);
+  for(auto i=0; i<4*vc; ++i)
+  {
+    aos[i]=T(i+1);
+  }
+  // the extra element, just after the quadruples, must be left untouched
+  aos[4*vc]=T(-1);
+  const auto [x, y, z, w]=simd::load4<simd_t>(aos.data());
+  for(auto i=0; i<vc; ++i)
+  {
+    DIM_CHECK((x[i]==aos[4*i+0])&&(y[i]==aos[4*i+1])&&
+              (z[i]==aos[4*i+2])&&(w[i]==aos[4*i+3]));
+  }
+  auto stored=std::vector<T>(4*vc+1, T(-1));
+  simd::store4(stored.data(), x, y, z, w);
+  DIM_CHECK(stored==aos);
+  if constexpr(std::is_floating_point_v<T>)
+  {
+    aos[3*vc]=T(-1);
+    const auto r3=simd::load3<simd_t>(aos.data());
+    for(auto i=0; i<vc; ++i)
+    {
+      DIM_CHECK((r3.x[i]==aos[3*i+0])&&(r3.y[i]==aos[3*i+1])&&
+                (r3.z[i]==aos[3*i+2]));
+    }
+    auto stored3=std::vector<T>(3*vc+1, T(-1));
+    simd::store3(stored3.data(), r3);
+    DIM_CHECK(std::equal(stored3.begin(), stored3.end(), aos.begin()));
+    // through dim::Real3
+    auto reals=std::vector<dim::Real3<T>>(vc);
+    simd::store3(reals.data(), r3);
+    const auto back=simd::load3<simd_t>(reals.data());
+    DIM_CHECK(simd::all((back.x==r3.x)&(back.y==r3.y)&(back.z==r3.z)));
+  }
+}
+
+template<typename T>
+void
+test_all_sizes_()
+{
+  test_load_store_<T, 16>();
+  test_load_store_<T, 32>();
+  test_load_store_<T, simd::dispatch_vector_size_limit>();
+}
+
+template<int VectorSize,
+         typename T>
+void
+test_conversion_()
+{
+  for(const auto count: {std::ptrdiff_t{1}, std::ptrdiff_t{21},
+                         std::ptrdiff_t{64}, std::ptrdiff_t{1000},
+                         std::ptrdiff_t{1001}})
+  {
+    auto xyz=AlignedBuffer<T>{3*count};
+    for(auto i=std::ptrdiff_t{}; i<3*count; ++i)
+    {
+      xyz.data()[i]=T(i+1);
+    }
+    for(const auto part_count: {1, 3})
+    {
+      auto x=AlignedBuffer<T>{count}, y=AlignedBuffer<T>{count},
+           z=AlignedBuffer<T>{count};
+      for(auto part_id=0; part_id<part_count; ++part_id)
+      {
+        deinterleave<VectorSize>(x, y, z, xyz, part_id, part_count);
+      }
+      for(auto i=std::ptrdiff_t{}; i<count; ++i)
+      {
+        DIM_CHECK((x.cdata()[i]==T(3*i+1))&&(y.cdata()[i]==T(3*i+2))&&
+                  (z.cdata()[i]==T(3*i+3)));
+      }
+      // one more element after the triples must be left untouched
+      auto back=AlignedBuffer<T>{3*count+1};
+      back.data()[3*count]=T(-1);
+      for(auto part_id=0; part_id<part_count; ++part_id)
+      {
+        interleave<VectorSize>(back, x, y, z, part_id, part_count);
+      }
+      DIM_CHECK(std::equal(xyz.cdata(), xyz.cdata()+3*count, back.cdata()));
+      DIM_CHECK(back.cdata()[3*count]==T(-1));
+    }
+  }
+}
+
+int
+main()
+{
+  test_all_sizes_<float>();
+  test_all_sizes_<double>();
+  test_all_sizes_<std::int32_t>();
+  test_all_sizes_<std::int64_t>();
+  test_all_sizes_<std::int16_t>();
+  test_all_sizes_<std::uint8_t>();
+  test_conversion_<16, float>();
+  test_conversion_<default_vector_size, float>();
+  test_conversion_<default_vector_size, double>();
+  return test::check_result();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -0,0 +1,206 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "check.hpp"
+
+#include "aligned_buffer.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Mask reductions, compress/expand, prefix/suffix loads and stores and
+// compact(), for every value size and vector size, against a per-lane
+// computation from the bits of the mask.
+
+using namespace dim;
+
+template<typename SimdType>
+typename SimdType::mask_type
+mask_from_bits_(std::uint64_t bits)
+{
+  using mask_t = typename SimdType::mask_type;
+  auto m=typename mask_t::vector_type{};
+  for(auto i=0; i<SimdType::value_count; ++i)
+  {
+    m[i]=((bits>>i)&1) ? -1 : 0;
+  }
+  return {m};
+}
+
+template<typename T,
+         int VectorSize>
+void
+test_mask_()
+{
+  using simd_t = simd::simd_t<T, VectorSize>;
+  constexpr auto vc=simd_t::value_count;
+  const auto all_bits=(vc==64) ? ~std::uint64_t{}
+                               : (std::uint64_t{1}<<vc)-1;
+  auto v=typename simd_t::vector_type{};
+  for(auto i=0; i<vc; ++i)
+  {
+    v[i]=T(i+1);
+  }
+  const auto s=simd_t{v};
+  for(const auto pattern: {std::uint64_t{0}, ~std::uint64_t{},
+                           std::uint64_t{1}, std::uint64_t{1}<<(vc-1),
+                           std::uint64_t{0x5A5A5A5A5A5A5A5Aull},
+                           std::uint64_t{0x0123456789ABCDEFull},
+                           std::uint64_t{0xF00FF00FF00FF00Full}})
+  {
+    const auto bits=pattern&all_bits;
+    const auto mask=mask_from_bits_<simd_t>(bits);
+    const auto count=__builtin_popcountll(bits);
+    DIM_CHECK(std::uint64_t{simd::movemask(mask)}==bits);
+    DIM_CHECK(simd::any(mask)==(bits!=0));
+    DIM_CHECK(simd::none(mask)==(bits==0));
+    DIM_CHECK(simd::all(mask)==(bits==all_bits));
+    DIM_CHECK(simd::count_true(mask)==count);
+    DIM_CHECK(simd::first_set(mask)==(bits ? __builtin_ctzll(bits) : vc));
+    const auto c=simd::compress(s, mask);
+    const auto e=simd::expand(s, mask);
+    auto stored=std::vector<T>(vc+1, T(-1));
+    DIM_CHECK(simd::compress_store(stored.data(), s, mask)==count);
+    auto n=0;
+    for(auto i=0; i<vc; ++i)
+    {
+      if((bits>>i)&1)
+      {
+        DIM_CHECK(c[n]==s[i]);
+        DIM_CHECK(stored[n]==s[i]);
+        DIM_CHECK(e[i]==s[n]);
+        ++n;
+      }
+      else
+      {
+        DIM_CHECK(e[i]==T(0));
+      }
+    }
+    for(auto i=n; i<vc; ++i)
+    {
+      DIM_CHECK(c[i]==T(0));
+    }
+    // nothing is written beyond the stored values
+    for(auto i=n; i<vc+1; ++i)
+    {
+      DIM_CHECK(stored[i]==T(-1));
+    }
+  }
+}
+
+template<typename T,
+         int VectorSize>
+void
+test_prefix_suffix_()
+{
+  // every length, including zero, on both sides of an aligned address, as
+  // split() provides them: a prefix ends there, a suffix starts there
+  using simd_t = simd::simd_t<T, VectorSize>;
+  constexpr auto vc=simd_t::value_count;
+  auto v=typename simd_t::vector_type{};
+  for(auto i=0; i<vc; ++i)
+  {
+    v[i]=T(i+1);
+  }
+  const auto full=simd_t{v};
+  alignas(VectorSize) T data[2*vc];
+  for(auto i=0; i<2*vc; ++i)
+  {
+    data[i]=T(2*vc-i);
+  }
+  const auto *middle=data+vc;
+  for(auto length=0; length<=vc; ++length)
+  {
+    const auto offset=vc-length;
+    const auto prefix=simd::load_prefix<simd_t>(middle-length, length);
+    const auto suffix=simd::load_suffix<simd_t>(middle, length);
+    for(auto i=0; i<vc; ++i)
+    {
+      DIM_CHECK(prefix[i]==((i>=offset) ? data[i] : T(0)));
+      DIM_CHECK(suffix[i]==((i<length) ? middle[i] : T(0)));
+    }
+    alignas(VectorSize) T stored[2*vc];
+    std::fill(stored, stored+2*vc, T(-1));
+    simd::store_prefix(stored+vc-length, length, full);
+    simd::store_suffix(stored+vc, length, full);
+    for(auto i=0; i<vc; ++i)
+    {
+      DIM_CHECK(stored[i]==((i>=offset) ? full[i] : T(-1)));
+      DIM_CHECK(stored[vc+i]==((i<length) ? full[i] : T(-1)));
+    }
+  }
+}
+
+template<typename T>
+void
+test_mask_all_sizes_()
+{
+  test_mask_<T, 16>();
+  test_mask_<T, 32>();
+  test_mask_<T, simd::dispatch_vector_size_limit>();
+  test_prefix_suffix_<T, 16>();
+  test_prefix_suffix_<T, 32>();
+  test_prefix_suffix_<T, simd::dispatch_vector_size_limit>();
+}
+
+template<int VectorSize,
+         int Unroll>
+void
+test_compact_()
+{
+  const auto count=std::ptrdiff_t{1000};
+  auto src=AlignedBuffer<int>{count};
+  for(auto i=std::ptrdiff_t{}; i<count; ++i)
+  {
+    src.data()[i]=int((i*7919)%1009);
+  }
+  const auto odd=
+    [](const auto &v)
+    {
+      return (v&1)!=0;
+    };
+  auto expected=std::vector<int>{};
+  for(auto i=std::ptrdiff_t{}; i<count; ++i)
+  {
+    if(odd(src.data()[i]))
+    {
+      expected.emplace_back(src.data()[i]);
+    }
+  }
+  for(const auto part_count: {1, 3, 7})
+  {
+    // in place, then stitched in the order of the parts
+    auto buffer=AlignedBuffer<int>{count};
+    std::copy(src.data(), src.data()+count, buffer.data());
+    auto stitched=std::ptrdiff_t{};
+    for(auto part_id=0; part_id<part_count; ++part_id)
+    {
+      const auto part=compact<VectorSize, Unroll>(buffer, buffer,
+                                                  part_id, part_count, odd);
+      std::copy(buffer.data()+part.first,
+                buffer.data()+part.first+part.count,
+                buffer.data()+stitched);
+      stitched+=part.count;
+    }
+    DIM_CHECK(stitched==std::ptrdiff_t(size(expected)));
+    DIM_CHECK(std::equal(buffer.data(), buffer.data()+stitched,
+                         expected.data()));
+  }
+}
+
+int
+main()
+{
+  test_mask_all_sizes_<std::int8_t>();
+  test_mask_all_sizes_<std::int16_t>();
+  test_mask_all_sizes_<std::int32_t>();
+  test_mask_all_sizes_<std::int64_t>();
+  test_mask_all_sizes_<float>();
+  test_mask_all_sizes_<double>();
+  test_compact_<16, 1>();
+  test_compact_<default_vector_size, 1>();
+  test_compact_<default_vector_size, 2>();
+  return test::check_result();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -0,0 +1,122 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "check.hpp"
+
+#include "simd_math.hpp"
+
+#include <random>
+#include <vector>
+#include <string>
+#include <iomanip>
+
+// Throughput of each function of simd_math.hpp (full and fast tiers)
+// against one std:: call per value, in nanoseconds per value, over an
+// array which stays in the L1 cache.
+
+using namespace dim;
+
+template<typename T,
+         typename StdFnct,
+         typename SimdFnct,
+         typename FastFnct>
+void
+bench_(const std::string &name,
+       T low,
+       T high,
+       StdFnct std_fnct,
+       SimdFnct simd_fnct,
+       FastFnct fast_fnct)
+{
+  using simd_t = simd::simd_t<T, simd::max_vector_size>;
+  constexpr auto count=std::size_t{1024};
+  auto gen=std::mt19937_64{1};
+  auto distrib=std::uniform_real_distribution<double>{double(low),
+                                                      double(high)};
+  auto args=std::vector<T>(count), result=std::vector<T>(count);
+  for(auto &a: args)
+  {
+    a=T(distrib(gen));
+  }
+  const auto ns=
+    [&](auto fnct)
+    {
+      return 1e9*test::time_per_call(fnct)/double(count);
+    };
+  const auto with_std=ns(
+    [&]()
+    {
+      for(auto i=std::size_t{}; i<count; ++i)
+      {
+        result[i]=std_fnct(args[i]);
+      }
+      asm volatile("" :: "r"(result.data()) : "memory");
+    });
+  const auto with_simd=
+    [&](auto fnct)
+    {
+      return ns(
+        [&]()
+        {
+          for(auto i=std::size_t{}; i<count; i+=simd_t::value_count)
+          {
+            simd::store_u(result.data()+i,
+                          fnct(simd::load_u<simd_t>(args.data()+i)));
+          }
+          asm volatile("" :: "r"(result.data()) : "memory");
+        });
+    };
+  const auto full=with_simd(simd_fnct);
+  const auto fast=with_simd(fast_fnct);
+  std::cout << std::setw(5) << name << ' ' << sizeof(T)*8
+            << std::fixed << std::setprecision(3)
+            << ":  std " << with_std << " ns,  simd " << full
+            << " ns (x" << std::setprecision(1) << with_std/full
+            << "),  fast " << std::setprecision(3) << fast
+            << " ns (x" << std::setprecision(1) << with_std/fast << ")\n"
+            << std::defaultfloat;
+}
+
+template<typename T>
+void
+bench_all_()
+{
+  bench_<T>("exp", T(-80), T(80),
+            [](T v) { return std::exp(v); },
+            [](auto x) { return simd::exp(x); },
+            [](auto x) { return simd::fast_exp(x); });
+  bench_<T>("log", T(1e-20), T(1e20),
+            [](T v) { return std::log(v); },
+            [](auto x) { return simd::log(x); },
+            [](auto x) { return simd::fast_log(x); });
+  bench_<T>("sin", T(-100), T(100),
+            [](T v) { return std::sin(v); },
+            [](auto x) { return simd::sin(x); },
+            [](auto x) { return simd::fast_sin(x); });
+  bench_<T>("cos", T(-100), T(100),
+            [](T v) { return std::cos(v); },
+            [](auto x) { return simd::cos(x); },
+            [](auto x) { return simd::fast_cos(x); });
+  bench_<T>("tan", T(-100), T(100),
+            [](T v) { return std::tan(v); },
+            [](auto x) { return simd::tan(x); },
+            [](auto x) { return simd::fast_tan(x); });
+  bench_<T>("atan", T(-100), T(100),
+            [](T v) { return std::atan(v); },
+            [](auto x) { return simd::atan(x); },
+            [](auto x) { return simd::fast_atan(x); });
+  bench_<T>("tanh", T(-10), T(10),
+            [](T v) { return std::tanh(v); },
+            [](auto x) { return simd::tanh(x); },
+            [](auto x) { return simd::fast_tanh(x); });
+}
+
+int
+main()
+{
+  std::cout << "vector size: " << simd::max_vector_size << " bytes\n";
+  bench_all_<float>();
+  bench_all_<double>();
+  return 0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -0,0 +1,295 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "check.hpp"
+
+#include "simd_math.hpp"
+
+#include <cstring>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include <string>
+#include <iomanip>
+
+// Sweeps random arguments through each function of simd_math.hpp and
+// compares with libm (evaluated one precision above: double for float,
+// long double for double), then checks the max error against the table
+// of the header: ulp for the full tier, relative error for the fast tier.
+// Special values are checked for the full tier only.
+
+using namespace dim;
+
+template<typename T>
+std::int64_t // position of the value among the ordered reals
+ordered_(T v)
+{
+  using bits_t = std::conditional_t<sizeof(T)==4, std::int32_t, std::int64_t>;
+  auto bits=bits_t{};
+  std::memcpy(&bits, &v, sizeof(v));
+  return bits<0 ? std::int64_t(std::numeric_limits<bits_t>::min())-bits
+                : std::int64_t(bits);
+}
+
+template<typename T>
+double
+ulp_error_(T value,
+           T expected)
+{
+  if((value!=value)||(expected!=expected))
+  {
+    return ((value!=value)==(expected!=expected))
+           ? 0.0 : std::numeric_limits<double>::infinity();
+  }
+  return std::abs(double(ordered_(value)-ordered_(expected)));
+}
+
+template<typename T,
+         typename SimdFnct>
+std::vector<T>
+apply_simd_(const std::vector<T> &args,
+            SimdFnct simd_fnct)
+{
+  using simd_t = simd::simd_t<T, simd::max_vector_size>;
+  auto result=std::vector<T>(args.size());
+  for(auto i=std::size_t{}; i<args.size(); i+=simd_t::value_count)
+  {
+    const auto x=simd::load_u<simd_t>(args.data()+i);
+    simd::store_u(result.data()+i, simd_fnct(x));
+  }
+  return result;
+}
+
+template<typename T>
+std::vector<T> // count arguments in [low, high], a multiple of the lanes
+uniform_(T low,
+         T high,
+         std::size_t count=1<<18)
+{
+  auto gen=std::mt19937_64{12345};
+  auto distrib=std::uniform_real_distribution<double>{double(low),
+                                                      double(high)};
+  auto args=std::vector<T>(count);
+  for(auto &a: args)
+  {
+    a=T(distrib(gen));
+  }
+  return args;
+}
+
+template<typename T>
+std::vector<T> // positive arguments spread over the exponents
+logarithmic_(std::size_t count=1<<18)
+{
+  auto gen=std::mt19937_64{6789};
+  auto mantissa=std::uniform_real_distribution<double>{1.0, 2.0};
+  auto exponent=std::uniform_int_distribution<int>{
+    std::numeric_limits<T>::min_exponent-1,
+    std::numeric_limits<T>::max_exponent-1};
+  auto args=std::vector<T>(count);
+  for(auto &a: args)
+  {
+    a=T(std::ldexp(mantissa(gen), exponent(gen)));
+  }
+  return args;
+}
+
+template<typename T,
+         typename Ref,
+         typename SimdFnct>
+void
+check_ulp_(const std::string &name,
+           const std::vector<T> &args,
+           Ref ref,
+           SimdFnct simd_fnct,
+           double max_ulp)
+{
+  using ref_t = std::conditional_t<sizeof(T)==4, double, long double>;
+  const auto result=apply_simd_(args, simd_fnct);
+  auto worst=0.0;
+  auto worst_arg=T{};
+  for(auto i=std::size_t{}; i<args.size(); ++i)
+  {
+    const auto expected=T(ref(ref_t(args[i])));
+    if(const auto e=ulp_error_(result[i], expected); e>worst)
+    {
+      worst=e;
+      worst_arg=args[i];
+    }
+  }
+  std::cout << std::setw(8) << name << ' ' << sizeof(T)*8 << ": "
+            << worst << " ulp (at " << std::setprecision(17) << worst_arg
+            << std::setprecision(6) << ")\n";
+  DIM_CHECK(worst<=max_ulp);
+}
+
+template<typename T,
+         typename Ref,
+         typename SimdFnct>
+void
+check_relative_(const std::string &name,
+                const std::vector<T> &args,
+                Ref ref,
+                SimdFnct simd_fnct,
+                double max_error)
+{
+  const auto result=apply_simd_(args, simd_fnct);
+  auto worst=0.0;
+  for(auto i=std::size_t{}; i<args.size(); ++i)
+  {
+    const auto expected=double(ref((long double)args[i]));
+    const auto e=std::abs(double(result[i])-expected)/
+                 std::max(std::abs(expected), 1e-30);
+    worst=std::max(worst, e);
+  }
+  std::cout << std::setw(8) << name << ' ' << sizeof(T)*8 << ": "
+            << worst << " relative\n";
+  DIM_CHECK(worst<=max_error);
+}
+
+template<typename T>
+void
+check_specials_()
+{
+  using simd_t = simd::simd_t<T, simd::max_vector_size>;
+  const auto nan=std::numeric_limits<T>::quiet_NaN();
+  const auto inf=std::numeric_limits<T>::infinity();
+  const auto denorm=std::numeric_limits<T>::denorm_min();
+  const auto specials=std::vector<T>{nan, inf, -inf, T(0), -T(0),
+                                     denorm, -denorm};
+  const auto same=
+    [&](T a, T b)
+    {
+      // same value, same sign of zero, or both nan
+      return ((a!=a)&&(b!=b))||
+             ((a==b)&&(std::signbit(a)==std::signbit(b)));
+    };
+  const auto check=
+    [&](const std::string &name, auto simd_fnct, auto ref, bool finite_only)
+    {
+      for(const auto &v: specials)
+      {
+        if(finite_only&&!std::isfinite(v))
+        {
+          continue;
+        }
+        const auto value=simd_fnct(simd_t{v})[0];
+        const auto expected=ref(v);
+        if(!same(value, expected))
+        {
+          std::cerr << name << '(' << v << ")=" << value
+                    << " instead of " << expected << '\n';
+          DIM_CHECK(same(value, expected));
+        }
+      }
+    };
+  check("exp", [](auto x) { return simd::exp(x); },
+        [](T v) { return std::exp(v); }, false);
+  check("log", [](auto x) { return simd::log(x); },
+        [](T v) { return std::log(v); }, false);
+  check("atan", [](auto x) { return simd::atan(x); },
+        [](T v) { return std::atan(v); }, false);
+  check("tanh", [](auto x) { return simd::tanh(x); },
+        [](T v) { return std::tanh(v); }, false);
+  // sin/cos/tan of infinities give nan with any sign
+  check("sin", [](auto x) { return simd::sin(x); },
+        [](T v) { return std::sin(v); }, true);
+  check("cos", [](auto x) { return simd::cos(x); },
+        [](T v) { return std::cos(v); }, true);
+  check("tan", [](auto x) { return simd::tan(x); },
+        [](T v) { return std::tan(v); }, true);
+  DIM_CHECK(std::isnan(simd::sin(simd_t{inf})[0]));
+  DIM_CHECK(std::isnan(simd::cos(simd_t{-inf})[0]));
+  DIM_CHECK(simd::exp(simd_t{T(-1000)})[0]==T(0));
+  DIM_CHECK(simd::exp(simd_t{T(1000)})[0]==inf);
+  DIM_CHECK(std::isnan(simd::log(simd_t{T(-1)})[0]));
+  DIM_CHECK(simd::log(simd_t{T(0)})[0]==-inf);
+}
+
+template<typename T>
+void
+check_full_()
+{
+  constexpr auto is_float=sizeof(T)==4;
+  const auto exp_max=is_float ? T(88) : T(709);
+  const auto trigo_max=is_float ? T(4096) : T(65536);
+  const auto exp_args=uniform_(-exp_max, exp_max);
+  const auto log_args=logarithmic_<T>();
+  const auto trigo_args=uniform_(-trigo_max, trigo_max);
+  const auto small_args=uniform_(T(-4), T(4));
+  const auto large_args=uniform_(-T(1e6), T(1e6));
+  const auto tanh_args=uniform_(T(-20), T(20));
+  check_ulp_("exp", exp_args, [](auto v) { return std::exp(v); },
+             [](auto x) { return simd::exp(x); }, is_float ? 1 : 2);
+  check_ulp_("log", log_args, [](auto v) { return std::log(v); },
+             [](auto x) { return simd::log(x); }, is_float ? 1 : 2);
+  for(const auto *args: {&trigo_args, &small_args})
+  {
+    check_ulp_("sin", *args, [](auto v) { return std::sin(v); },
+               [](auto x) { return simd::sin(x); }, 2);
+    check_ulp_("cos", *args, [](auto v) { return std::cos(v); },
+               [](auto x) { return simd::cos(x); }, 2);
+    check_ulp_("tan", *args, [](auto v) { return std::tan(v); },
+               [](auto x) { return simd::tan(x); }, 4);
+  }
+  check_ulp_("atan", large_args, [](auto v) { return std::atan(v); },
+             [](auto x) { return simd::atan(x); }, is_float ? 4 : 1);
+  check_ulp_("atan", small_args, [](auto v) { return std::atan(v); },
+             [](auto x) { return simd::atan(x); }, is_float ? 4 : 1);
+  check_ulp_("tanh", tanh_args, [](auto v) { return std::tanh(v); },
+             [](auto x) { return simd::tanh(x); }, 2);
+  check_specials_<T>();
+}
+
+template<typename T>
+void
+check_fast_()
+{
+  constexpr auto is_float=sizeof(T)==4;
+  const auto max_error=is_float ? 3e-6 : 3e-8;
+  const auto exp_args=uniform_(T(-80), T(80));
+  const auto trigo_args=uniform_(T(-4000), T(4000));
+  const auto atan_args=uniform_(T(-1e3), T(1e3));
+  const auto tanh_args=uniform_(T(-20), T(20));
+  check_relative_("fast_exp", exp_args,
+                  [](auto v) { return std::exp(v); },
+                  [](auto x) { return simd::fast_exp(x); }, max_error);
+  check_relative_("fast_log", logarithmic_<T>(),
+                  [](auto v) { return std::log(v); },
+                  [](auto x) { return simd::fast_log(x); }, max_error);
+  // near a root of sin/cos/tan the relative error is larger (see the
+  // header), thus the arguments are kept away from them here
+  auto away=std::vector<T>{};
+  for(const auto &a: trigo_args)
+  {
+    const auto r=std::remainder(double(a), 1.5707963267948966);
+    if(std::abs(r)>0.1)
+    {
+      away.emplace_back(a);
+    }
+  }
+  away.resize(away.size()/64*64);
+  check_relative_("fast_sin", away, [](auto v) { return std::sin(v); },
+                  [](auto x) { return simd::fast_sin(x); }, max_error);
+  check_relative_("fast_cos", away, [](auto v) { return std::cos(v); },
+                  [](auto x) { return simd::fast_cos(x); }, max_error);
+  check_relative_("fast_tan", away, [](auto v) { return std::tan(v); },
+                  [](auto x) { return simd::fast_tan(x); }, max_error);
+  check_relative_("fast_atan", atan_args,
+                  [](auto v) { return std::atan(v); },
+                  [](auto x) { return simd::fast_atan(x); }, max_error);
+  check_relative_("fast_tanh", tanh_args,
+                  [](auto v) { return std::tanh(v); },
+                  [](auto x) { return simd::fast_tanh(x); }, max_error);
+}
+
+int
+main()
+{
+  check_full_<float>();
+  check_full_<double>();
+  check_fast_<float>();
+  check_fast_<double>();
+  return test::check_result();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
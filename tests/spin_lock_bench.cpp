@@ -0,0 +1,137 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "check.hpp"
+
+#include "synchro.hpp"
+#include "distributed_spin_lock.hpp"
+#include "cpu_platform.hpp"
+
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+
+// Read throughput (lock_r()/unlock_r() pairs around a read of the shared
+// data, summed over all the readers) of SpinLock and DistributedSpinLock
+// (one slot per cpu, then one per numa node) for growing reader counts;
+// reader i is bound to cpu index i%cpu_count.
+// The readers of SpinLock all write the same cacheline, thus its
+// throughput drops as soon as they run on distinct cpus; with more readers
+// than cpus, the figures mostly measure the scheduler.
+
+using namespace dim;
+
+template<typename ReadFnct>
+double // millions of reads per second, all the readers together
+read_throughput_(const cpu::Platform &platform,
+                 int reader_count,
+                 ReadFnct read_fnct) // read_fnct(cpu_index) --> value read
+{
+  using clock_t = std::chrono::steady_clock;
+  constexpr auto duration=std::chrono::milliseconds{200};
+  auto ready=std::atomic<int>{};
+  auto go=std::atomic<bool>{};
+  auto stop=std::atomic<bool>{};
+  auto total=std::atomic<long long>{};
+  auto threads=std::vector<std::thread>{};
+  for(auto id=0; id<reader_count; ++id)
+  {
+    threads.emplace_back(
+      [&, id]()
+      {
+        const auto cpu_index=id%platform.cpu_count();
+        cpu::bind_current_thread(platform.cpu_id(cpu_index));
+        ready.fetch_add(1);
+        while(!go.load())
+        {
+          std::this_thread::yield();
+        }
+        auto count=0LL;
+        auto sum=0;
+        while(!stop.load(std::memory_order_relaxed))
+        {
+          for(auto i=0; i<64; ++i)
+          {
+            sum+=read_fnct(cpu_index);
+          }
+          count+=64;
+        }
+        total.fetch_add(count);
+        DIM_CHECK(sum>=0);
+      });
+  }
+  while(ready.load()!=reader_count)
+  {
+    std::this_thread::yield();
+  }
+  const auto start=clock_t::now();
+  go.store(true);
+  std::this_thread::sleep_for(duration);
+  stop.store(true);
+  for(auto &th: threads)
+  {
+    th.join();
+  }
+  const auto seconds=
+    std::chrono::duration<double>(clock_t::now()-start).count();
+  return 1e-6*double(total.load())/seconds;
+}
+
+int
+main()
+{
+  const auto platform=cpu::Platform{};
+  const auto cpu_count=platform.cpu_count();
+  std::cout << cpu_count << " cpu(s), " << platform.numa_count()
+            << " numa node(s)\n";
+  auto reader_counts=std::vector<int>{};
+  for(auto n=1; n<cpu_count; n*=2)
+  {
+    reader_counts.emplace_back(n);
+  }
+  reader_counts.emplace_back(cpu_count);
+  if(cpu_count==1)
+  {
+    reader_counts.emplace_back(2);
+  }
+  auto data=std::atomic<int>{1}; // read under the lock
+  for(const auto n: reader_counts)
+  {
+    auto spin_lock=SpinLock{};
+    auto per_cpu=DistributedSpinLock{platform};
+    auto per_numa=DistributedSpinLock{platform, true};
+    const auto with_spin_lock=read_throughput_(platform, n,
+      [&](int)
+      {
+        spin_lock.lock_r();
+        const auto value=data.load(std::memory_order_relaxed);
+        spin_lock.unlock_r();
+        return value;
+      });
+    const auto with_distributed=
+      [&](DistributedSpinLock &lock)
+      {
+        return read_throughput_(platform, n,
+          [&](int cpu_index)
+          {
+            const auto slot=lock.reader_slot(cpu_index);
+            lock.lock_r(slot);
+            const auto value=data.load(std::memory_order_relaxed);
+            lock.unlock_r(slot);
+            return value;
+          });
+      };
+    const auto with_per_cpu=with_distributed(per_cpu);
+    const auto with_per_numa=with_distributed(per_numa);
+    std::cout << std::setw(4) << n << " reader(s):" << std::fixed
+              << std::setprecision(1)
+              << "  SpinLock " << with_spin_lock << " M/s,"
+              << "  per cpu " << with_per_cpu << " M/s,"
+              << "  per numa " << with_per_numa << " M/s\n"
+              << std::defaultfloat;
+  }
+  return test::check_result();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -0,0 +1,171 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "check.hpp"
+
+#include "synchro.hpp"
+#include "tree_synchro.hpp"
+#include "cpu_platform.hpp"
+
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <iomanip>
+
+// Latency of one sync/ack round (part 0 releases every part and waits for
+// all of them, as in Team::run() with an empty job) with the flat Synchro
+// and with TreeSynchro, then of a TreeSynchro::barrier() with a combined
+// value, for growing thread counts; part part_id is bound to cpu index
+// part_id%cpu_count as in Team.
+// The tree only pays off when the parts span several caches or numa nodes;
+// with more threads than cpus, the rounds mostly measure the wake-ups.
+
+using namespace dim;
+
+template<typename Worker>
+double // seconds per round
+run_(const cpu::Platform &platform,
+     int thread_count,
+     Worker worker) // worker(part_id, go) --> go on
+{
+  constexpr auto round_count=200;
+  auto threads=std::vector<std::thread>{};
+  auto seconds=0.0;
+  for(auto part_id=0; part_id<thread_count; ++part_id)
+  {
+    threads.emplace_back(
+      [&, part_id]()
+      {
+        cpu::bind_current_thread(
+          platform.cpu_id(part_id%platform.cpu_count()));
+        if(part_id==0)
+        {
+          seconds=test::time_per_call(
+            [&]()
+            {
+              for(auto r=0; r<round_count; ++r)
+              {
+                worker(0, true);
+              }
+            }, 0.1)/round_count;
+          worker(0, false);
+        }
+        else
+        {
+          while(worker(part_id, true))
+          {
+          }
+        }
+      });
+  }
+  for(auto &th: threads)
+  {
+    th.join();
+  }
+  return seconds;
+}
+
+double
+flat_round_(const cpu::Platform &platform,
+            int thread_count)
+{
+  auto synchro=Synchro{};
+  auto stop=std::atomic<bool>{};
+  auto last_syncs=std::vector<Synchro::sync_t>(thread_count);
+  return run_(platform, thread_count,
+    [&](int part_id, bool go)
+    {
+      if(part_id==0)
+      {
+        stop.store(!go, std::memory_order_relaxed);
+        synchro.sync(thread_count);
+        synchro.wait_for_ack();
+        return go;
+      }
+      synchro.wait_for_sync(last_syncs[part_id]);
+      const auto running=!stop.load(std::memory_order_relaxed);
+      synchro.ack();
+      return running;
+    });
+}
+
+double
+tree_round_(const cpu::Platform &platform,
+            int thread_count)
+{
+  auto synchro=TreeSynchro{platform, thread_count};
+  auto stop=std::atomic<bool>{};
+  auto last_syncs=std::vector<TreeSynchro::sync_t>(thread_count);
+  return run_(platform, thread_count,
+    [&](int part_id, bool go)
+    {
+      if(part_id==0)
+      {
+        stop.store(!go, std::memory_order_relaxed);
+        synchro.sync();
+        synchro.wait_for_ack();
+        return go;
+      }
+      synchro.wait_for_sync(part_id, last_syncs[part_id]);
+      const auto running=!stop.load(std::memory_order_relaxed);
+      synchro.ack(part_id);
+      return running;
+    });
+}
+
+double
+tree_barrier_(const cpu::Platform &platform,
+              int thread_count)
+{
+  auto synchro=TreeSynchro{platform, thread_count};
+  auto stop=std::atomic<bool>{};
+  return run_(platform, thread_count,
+    [&](int part_id, bool go)
+    {
+      if(part_id==0)
+      {
+        stop.store(!go, std::memory_order_relaxed);
+      }
+      // every part sees the stop flag of part 0 once the barrier is done
+      const auto sum=synchro.barrier(part_id, 1,
+        [](int a, int b)
+        {
+          return a+b;
+        });
+      DIM_CHECK(sum==thread_count);
+      const auto running=!stop.load(std::memory_order_relaxed);
+      synchro.barrier(part_id);
+      return running;
+    });
+}
+
+int
+main()
+{
+  const auto platform=cpu::Platform{};
+  const auto cpu_count=platform.cpu_count();
+  std::cout << cpu_count << " cpu(s), " << platform.numa_count()
+            << " numa node(s)\n";
+  auto thread_counts=std::vector<int>{};
+  for(auto n=2; n<cpu_count; n*=2)
+  {
+    thread_counts.emplace_back(n);
+  }
+  thread_counts.emplace_back(std::max(cpu_count, 2));
+  for(const auto n: thread_counts)
+  {
+    const auto us=
+      [&](auto fnct)
+      {
+        return 1e6*fnct(platform, n);
+      };
+    std::cout << std::setw(4) << n << " threads:" << std::fixed
+              << std::setprecision(2)
+              << "  flat sync/ack " << us(flat_round_) << " us,"
+              << "  tree sync/ack " << us(tree_round_) << " us,"
+              << "  tree barrier " << us(tree_barrier_) << " us\n"
+              << std::defaultfloat;
+  }
+  return test::check_result();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
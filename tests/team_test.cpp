@@ -0,0 +1,212 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "check.hpp"
+
+#include "team.hpp"
+
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <stdexcept>
+#include <vector>
+
+// run(), reduce(), fill() and apply1_stream() (streamed or not),
+// first_touch() and the reductions of Team against a serial computation,
+// for several thread counts (possibly more than the cpus); then exceptions
+// thrown by some parts, which must reach the calling thread and leave the
+// team usable, and the construction/destruction of many teams.
+// The values are small integers, thus the floating point sums are exact
+// whatever the order.
+
+using namespace dim;
+
+void
+test_dispatch_(Team &team)
+{
+  const auto n=team.thread_count();
+  for(auto round=0; round<100; ++round)
+  {
+    auto seen=std::vector<int>(n);
+    auto calls=std::atomic<int>{};
+    team.run(
+      [&](int part_id, int part_count)
+      {
+        DIM_CHECK(part_count==n);
+        seen[part_id]+=part_id+1;
+        calls.fetch_add(1);
+      });
+    DIM_CHECK(calls.load()==n);
+    for(auto id=0; id<n; ++id)
+    {
+      DIM_CHECK(seen[id]==id+1);
+    }
+    const auto total=team.reduce(
+      [&](int part_id, int)
+      {
+        return part_id+round;
+      },
+      std::plus<>{});
+    DIM_CHECK(total==n*(n-1)/2+n*round);
+    const auto largest=team.reduce(
+      [&](int part_id, int)
+      {
+        return double(part_id);
+      },
+      [](double a, double b)
+      {
+        return std::max(a, b);
+      });
+    DIM_CHECK(largest==double(n-1));
+  }
+}
+
+void
+test_buffers_(Team &team)
+{
+  constexpr auto count=std::ptrdiff_t{10007};
+  auto src=AlignedBuffer<float>{count};
+  for(auto i=std::ptrdiff_t{}; i<count; ++i)
+  {
+    src.data()[i]=float((i*37)%101)-50.0f;
+  }
+  const auto default_threshold=team.stream_threshold();
+  for(const auto threshold: {std::ptrdiff_t{0}, std::ptrdiff_t{1}})
+  {
+    // 1 byte streams everything, 0 nothing
+    team.stream_threshold(threshold);
+    auto dst=AlignedBuffer<float>{count};
+    team.fill(dst, 3.0f);
+    DIM_CHECK(std::all_of(dst.cdata(), dst.cdata()+count,
+      [](float v)
+      {
+        return v==3.0f;
+      }));
+    team.apply1_stream(dst, src,
+      [](auto &d, const auto &s)
+      {
+        d=s+s;
+      });
+    for(auto i=std::ptrdiff_t{}; i<count; ++i)
+    {
+      DIM_CHECK(dst.cdata()[i]==2.0f*src.cdata()[i]);
+    }
+  }
+  team.stream_threshold(default_threshold);
+  auto touched=AlignedBuffer<float>{count, BufferInit::none};
+  team.first_touch(touched);
+  DIM_CHECK(std::all_of(touched.cdata(), touched.cdata()+count,
+    [](float v)
+    {
+      return v==0.0f;
+    }));
+  // serial references, the minimum and maximum appearing twice
+  src.data()[count-1]=-60.0f;
+  src.data()[count/3]=-60.0f;
+  src.data()[count/2]=70.0f;
+  src.data()[5]=70.0f;
+  auto sum=0.0, sqr_sum=0.0, abs_sum=0.0;
+  auto positive=std::ptrdiff_t{};
+  for(auto i=std::ptrdiff_t{}; i<count; ++i)
+  {
+    const auto v=double(src.cdata()[i]);
+    sum+=v;
+    sqr_sum+=v*v;
+    abs_sum+=std::abs(v);
+    positive+=(v>0.0);
+  }
+  DIM_CHECK(double(team.sum(src))==sum);
+  DIM_CHECK(double(team.dot(src, src))==sqr_sum);
+  DIM_CHECK(double(team.sqr_norm_l2(src))==sqr_sum);
+  DIM_CHECK(double(team.norm_l1(src))==abs_sum);
+  DIM_CHECK(team.min(src)==-60.0f);
+  DIM_CHECK(team.max(src)==70.0f);
+  const auto amin=team.argmin(src), amax=team.argmax(src);
+  DIM_CHECK((amin.value==-60.0f)&&(amin.index==count/3));
+  DIM_CHECK((amax.value==70.0f)&&(amax.index==5));
+  DIM_CHECK(team.count_if(src,
+    [](const auto &v)
+    {
+      using v_t = std::decay_t<decltype(v)>;
+      return v>v_t{0.0f};
+    })==positive);
+}
+
+void
+test_exceptions_(Team &team)
+{
+  const auto n=team.thread_count();
+  for(const auto thrower: {0, n-1, -1}) // -1: every part throws
+  {
+    auto caught=0;
+    auto completed=std::atomic<int>{};
+    try
+    {
+      team.run(
+        [&](int part_id, int)
+        {
+          if((thrower<0)||(part_id==thrower))
+          {
+            throw std::runtime_error{"part "+std::to_string(part_id)};
+          }
+          completed.fetch_add(1);
+        });
+    }
+    catch(const std::runtime_error &)
+    {
+      ++caught;
+    }
+    DIM_CHECK(caught==1);
+    DIM_CHECK(completed.load()==((thrower<0) ? 0 : n-1));
+    caught=0;
+    try
+    {
+      team.reduce(
+        [&](int part_id, int)
+        {
+          if((thrower<0)||(part_id==thrower))
+          {
+            throw std::runtime_error{"part "+std::to_string(part_id)};
+          }
+          return part_id;
+        },
+        std::plus<>{});
+    }
+    catch(const std::runtime_error &)
+    {
+      ++caught;
+    }
+    DIM_CHECK(caught==1);
+    // the next dispatches are not disturbed
+    test_dispatch_(team);
+  }
+}
+
+int
+main()
+{
+  const auto platform=cpu::Platform{};
+  for(const auto thread_count: {1, 3, 8})
+  {
+    auto team=Team{platform, thread_count};
+    DIM_CHECK(team.thread_count()==thread_count);
+    test_dispatch_(team);
+    test_buffers_(team);
+    test_exceptions_(team);
+  }
+  // the destructor stops the workers, whether they ever worked or not
+  for(auto round=0; round<20; ++round)
+  {
+    auto idle=Team{platform, 1+round%5};
+    auto busy=Team{platform, 1+round%7};
+    DIM_CHECK(busy.reduce(
+      [](int, int)
+      {
+        return 1;
+      },
+      std::plus<>{})==busy.thread_count());
+  }
+  return test::check_result();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
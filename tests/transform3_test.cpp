@@ -0,0 +1,197 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "check.hpp"
+
+#include "simd_transform3.hpp"
+
+#include <random>
+#include <cmath>
+
+// Matrix3, Quaternion and Affine3 against rotated_x() and its siblings,
+// against each other and through composition and inversion, then applied
+// to simd::Real3 at every vector size and in bulk to AlignedBuffer (array
+// of structures and structure of arrays, in one and three parts), against
+// the scalar transformation of each point.
+
+using namespace dim;
+
+template<typename T>
+constexpr auto tolerance_=std::is_same_v<T, float> ? T(1e-5) : T(1e-12);
+
+template<typename T>
+bool
+close_(const Real3<T> &lhs,
+       const Real3<T> &rhs)
+{
+  // the points have unit-scale coordinates
+  return magnitude(lhs-rhs)<=tolerance_<T>;
+}
+
+template<typename T>
+Real3<T>
+random_point_(std::mt19937_64 &gen)
+{
+  auto distrib=std::uniform_real_distribution<T>{T(-1), T(1)};
+  return {distrib(gen), distrib(gen), distrib(gen)};
+}
+
+template<typename T>
+void
+test_scalar_()
+{
+  auto gen=std::mt19937_64{sizeof(T)};
+  auto angle=std::uniform_real_distribution<T>{T(-3), T(3)};
+  for(auto round=0; round<100; ++round)
+  {
+    const auto p=random_point_<T>(gen);
+    const auto ax=angle(gen), ay=angle(gen), az=angle(gen);
+    DIM_CHECK(close_(Matrix3<T>::rotation_x(ax)*p, rotated_x(p, ax)));
+    DIM_CHECK(close_(Matrix3<T>::rotation_y(ay)*p, rotated_y(p, ay)));
+    DIM_CHECK(close_(Matrix3<T>::rotation_z(az)*p, rotated_z(p, az)));
+    const auto euler_ref=rotated_z(rotated_y(rotated_x(p, ax), ay), az);
+    const auto m=Matrix3<T>::euler(ax, ay, az);
+    const auto q=Quaternion<T>::euler(ax, ay, az);
+    DIM_CHECK(close_(m*p, euler_ref));
+    DIM_CHECK(close_(q*p, euler_ref));
+    DIM_CHECK(close_(matrix(q)*p, euler_ref));
+    DIM_CHECK(std::abs(determinant(m)-T(1))<=tolerance_<T>);
+    DIM_CHECK(close_(transpose(m)*(m*p), p));
+    DIM_CHECK(close_(conjugate(q)*(q*p), p));
+    // around an arbitrary axis
+    const auto axis=normalised(random_point_<T>(gen));
+    const auto ma=Matrix3<T>::rotation(axis, ax);
+    const auto qa=Quaternion<T>::rotation(axis, ax);
+    DIM_CHECK(close_(ma*p, qa*p));
+    DIM_CHECK(close_(ma*axis, axis));
+    // composition: lhs applied after rhs
+    DIM_CHECK(close_((m*ma)*p, m*(ma*p)));
+    DIM_CHECK(close_(normalised(q*qa)*p, q*(qa*p)));
+    // a non-orthogonal matrix
+    const auto s=Matrix3<T>{{T(2), T(0.5), T(0)},
+                            {T(0), T(1), T(-0.25)},
+                            {T(0.5), T(0), T(3)}};
+    DIM_CHECK(close_(inverse(s)*(s*p), p));
+    DIM_CHECK(close_(inverse(s*m)*((s*m)*p), p));
+    const auto a=Affine3<T>{s, random_point_<T>(gen)};
+    const auto b=Affine3<T>{q, random_point_<T>(gen)};
+    DIM_CHECK(close_(a*p, s*p+a.t));
+    DIM_CHECK(close_(b*p, q*p+b.t));
+    DIM_CHECK(close_((a*b)*p, a*(b*p)));
+    DIM_CHECK(close_(inverse(a)*(a*p), p));
+  }
+}
+
+template<typename T,
+         int VectorSize>
+void
+test_simd_()
+{
+  using simd_t = simd::simd_t<T, VectorSize>;
+  constexpr auto vc=simd_t::value_count;
+  auto gen=std::mt19937_64{sizeof(T)*VectorSize};
+  const auto m=Matrix3<T>::euler(T(0.3), T(-1.2), T(2.5));
+  const auto q=Quaternion<T>::rotation(normalised(Real3<T>{1, 2, 3}),
+                                       T(0.7));
+  const auto a=Affine3<T>{m*matrix(q), Real3<T>{T(0.5), T(-2), T(1)}};
+  for(auto round=0; round<20; ++round)
+  {
+    typename simd_t::vector_type x{}, y{}, z{};
+    for(auto i=0; i<vc; ++i)
+    {
+      const auto p=random_point_<T>(gen);
+      x[i]=p.x;
+      y[i]=p.y;
+      z[i]=p.z;
+    }
+    const auto r3=simd::Real3<simd_t>{simd_t{x}, simd_t{y}, simd_t{z}};
+    const auto rm=m*r3, rq=q*r3, ra=a*r3;
+    for(auto i=0; i<vc; ++i)
+    {
+      const auto p=Real3<T>{x[i], y[i], z[i]};
+      DIM_CHECK(close_(Real3<T>{rm.x[i], rm.y[i], rm.z[i]}, m*p));
+      DIM_CHECK(close_(Real3<T>{rq.x[i], rq.y[i], rq.z[i]}, q*p));
+      DIM_CHECK(close_(Real3<T>{ra.x[i], ra.y[i], ra.z[i]}, a*p));
+    }
+  }
+}
+
+template<int VectorSize,
+         typename T,
+         typename Transform>
+void
+test_bulk_(const Transform &transformation)
+{
+  auto gen=std::mt19937_64{VectorSize+sizeof(T)};
+  for(const auto count: {std::ptrdiff_t{1}, std::ptrdiff_t{21},
+                         std::ptrdiff_t{1001}})
+  {
+    auto points=std::vector<Real3<T>>{};
+    for(auto i=std::ptrdiff_t{}; i<count; ++i)
+    {
+      points.emplace_back(random_point_<T>(gen));
+    }
+    for(const auto part_count: {1, 3})
+    {
+      // one more element after the triples must be left untouched
+      auto xyz=AlignedBuffer<T>{3*count+1};
+      auto x=AlignedBuffer<T>{count}, y=AlignedBuffer<T>{count},
+           z=AlignedBuffer<T>{count};
+      for(auto i=std::ptrdiff_t{}; i<count; ++i)
+      {
+        const auto [px, py, pz]=points[i];
+        xyz.data()[3*i+0]=x.data()[i]=px;
+        xyz.data()[3*i+1]=y.data()[i]=py;
+        xyz.data()[3*i+2]=z.data()[i]=pz;
+      }
+      xyz.data()[3*count]=T(-1);
+      for(auto part_id=0; part_id<part_count; ++part_id)
+      {
+        transform<VectorSize>(xyz, transformation, part_id, part_count);
+        transform<VectorSize>(x, y, z, transformation, part_id, part_count);
+      }
+      for(auto i=std::ptrdiff_t{}; i<count; ++i)
+      {
+        const auto expected=transformation*points[i];
+        const auto *t=xyz.cdata()+3*i;
+        DIM_CHECK(close_(Real3<T>{t[0], t[1], t[2]}, expected));
+        DIM_CHECK(close_(Real3<T>{x.cdata()[i], y.cdata()[i],
+                                  z.cdata()[i]}, expected));
+      }
+      DIM_CHECK(xyz.cdata()[3*count]==T(-1));
+    }
+  }
+}
+
+template<int VectorSize,
+         typename T>
+void
+test_bulk_all_()
+{
+  const auto m=Matrix3<T>::euler(T(0.3), T(-1.2), T(2.5));
+  const auto q=Quaternion<T>::euler(T(-0.4), T(0.9), T(1.7));
+  test_bulk_<VectorSize, T>(m);
+  test_bulk_<VectorSize, T>(q);
+  test_bulk_<VectorSize, T>(Affine3<T>{m, Real3<T>{T(0.5), T(-2), T(1)}});
+}
+
+template<typename T>
+void
+test_all_sizes_()
+{
+  test_scalar_<T>();
+  test_simd_<T, 16>();
+  test_simd_<T, 32>();
+  test_simd_<T, simd::dispatch_vector_size_limit>();
+  test_bulk_all_<16, T>();
+  test_bulk_all_<default_vector_size, T>();
+}
+
+int
+main()
+{
+  test_all_sizes_<float>();
+  test_all_sizes_<double>();
+  return test::check_result();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -0,0 +1,184 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "check.hpp"
+
+#include "tree_synchro.hpp"
+#include "team.hpp"
+
+#include <atomic>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// barrier(part_id, value, op) and ack(part_id, value, op) of TreeSynchro:
+// many rounds of Team::barrier() and Team::reduce() for 1, 3, 8 and 17
+// threads (possibly more than the cpus), every part checking the combined
+// value, with a sum and with a small structure as payload; then the plain
+// barrier() must order the writes done before it.
+// Then TreeSynchro on its own, with several fan-ins and without spinning
+// (the waiters sleep), driven by plain threads: the tree must reach every
+// part once, and the sync/barrier/ack protocol must combine the values.
+
+using namespace dim;
+
+struct Stats_
+{
+  long long sum;
+  int max;
+};
+
+const auto combine_stats_=
+  [](const Stats_ &a, const Stats_ &b)
+  {
+    return Stats_{a.sum+b.sum, std::max(a.max, b.max)};
+  };
+
+void
+test_team_(const cpu::Platform &platform,
+           int thread_count)
+{
+  constexpr auto rounds=50;
+  auto team=Team{platform, thread_count};
+  const auto n=thread_count;
+  auto mismatches=std::atomic<int>{};
+  team.run(
+    [&](int part_id, int)
+    {
+      for(auto k=0; k<rounds; ++k)
+      {
+        const auto total=team.barrier(part_id, part_id+k, std::plus<>{});
+        if(total!=n*(n-1)/2+n*k)
+        {
+          mismatches.fetch_add(1);
+        }
+        const auto stats=team.barrier(part_id,
+          Stats_{part_id*k, (part_id+k)%n}, combine_stats_);
+        if((stats.sum!=static_cast<long long>(k)*(n*(n-1)/2))||
+           (stats.max!=n-1))
+        {
+          mismatches.fetch_add(1);
+        }
+      }
+    });
+  DIM_CHECK(mismatches.load()==0);
+  // the writes before a barrier are seen by every part after it
+  auto slots=std::vector<int>(n);
+  team.run(
+    [&](int part_id, int)
+    {
+      for(auto k=1; k<=rounds; ++k)
+      {
+        slots[part_id]=k;
+        team.barrier(part_id);
+        for(auto id=0; id<n; ++id)
+        {
+          if(slots[id]!=k)
+          {
+            mismatches.fetch_add(1);
+          }
+        }
+        team.barrier(part_id);
+      }
+    });
+  DIM_CHECK(mismatches.load()==0);
+  for(auto k=0; k<rounds; ++k)
+  {
+    DIM_CHECK(team.reduce(
+      [&](int part_id, int)
+      {
+        return part_id+k;
+      },
+      std::plus<>{})==n*(n-1)/2+n*k);
+    const auto stats=team.reduce(
+      [&](int part_id, int)
+      {
+        return Stats_{part_id*k, (part_id+k)%n};
+      },
+      combine_stats_);
+    DIM_CHECK((stats.sum==static_cast<long long>(k)*(n*(n-1)/2))&&
+              (stats.max==n-1));
+  }
+}
+
+void
+test_tree_synchro_(const cpu::Platform &platform,
+                   int thread_count,
+                   int fan_in,
+                   int spin_count)
+{
+  constexpr auto rounds=30;
+  auto synchro=TreeSynchro{platform, thread_count, fan_in, spin_count};
+  const auto n=thread_count;
+  // every part but 0 is the child of exactly one part
+  auto reached=std::vector<int>(n);
+  for(auto id=0; id<n; ++id)
+  {
+    for(auto c=0; c<synchro.child_count(id); ++c)
+    {
+      const auto child=synchro.child(id, c);
+      DIM_CHECK(synchro.parent(child)==id);
+      ++reached[child];
+    }
+  }
+  DIM_CHECK(synchro.parent(0)==-1);
+  DIM_CHECK(reached[0]==0);
+  for(auto id=1; id<n; ++id)
+  {
+    DIM_CHECK(reached[id]==1);
+  }
+  auto mismatches=std::atomic<int>{};
+  const auto check_barrier=
+    [&](int part_id, int k)
+    {
+      if(synchro.barrier(part_id, part_id+k, std::plus<>{})!=
+         n*(n-1)/2+n*k)
+      {
+        mismatches.fetch_add(1);
+      }
+    };
+  auto threads=std::vector<std::thread>{};
+  for(auto id=1; id<n; ++id)
+  {
+    threads.emplace_back(
+      [&, id]()
+      {
+        auto last_sync=TreeSynchro::sync_t{};
+        for(auto k=0; k<rounds; ++k)
+        {
+          synchro.wait_for_sync(id, last_sync);
+          check_barrier(id, k);
+          synchro.ack(id, 2*id+k, std::plus<>{});
+        }
+      });
+  }
+  for(auto k=0; k<rounds; ++k)
+  {
+    synchro.sync();
+    check_barrier(0, k);
+    DIM_CHECK(synchro.wait_for_ack(k, std::plus<>{})==n*(n-1)+n*k);
+  }
+  for(auto &th: threads)
+  {
+    th.join();
+  }
+  DIM_CHECK(mismatches.load()==0);
+}
+
+int
+main()
+{
+  const auto platform=cpu::Platform{};
+  for(const auto thread_count: {1, 3, 8, 17})
+  {
+    test_team_(platform, thread_count);
+    for(const auto fan_in: {2, TreeSynchro::default_fan_in})
+    {
+      test_tree_synchro_(platform, thread_count, fan_in,
+                         Synchro::default_spin_count);
+    }
+    test_tree_synchro_(platform, thread_count, 2, 0);
+  }
+  return test::check_result();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
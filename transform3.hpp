@@ -0,0 +1,379 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef DIM_TRANSFORM3_HPP
+#define DIM_TRANSFORM3_HPP
+
+#include "real3.hpp"
+
+// Matrix3, Quaternion and Affine3 hold a transformation once for all, so
+// that applying it to many points (see simd_transform3.hpp) does not
+// compute the trigonometric functions again and again, as rotate_x() and
+// its siblings do.
+// Euler angles follow these functions: euler(ax, ay, az) rotates around
+// x by ax, then around y by ay, then around z by az.
+
+namespace dim {
+
+//~~~~ 3x3 matrix ~~~~
+
+template<typename RealType>
+struct Matrix3
+{
+  static_assert(std::is_floating_point_v<RealType>,
+                "floating point expected for template type");
+
+  using real_t = RealType;
+
+  Real3<real_t> x, y, z; // rows
+
+  constexpr Matrix3() : x{}, y{}, z{} {}
+  constexpr Matrix3(const Real3<real_t> &x,
+                    const Real3<real_t> &y,
+                    const Real3<real_t> &z) : x{x}, y{y}, z{z} {}
+
+  static constexpr
+  Matrix3
+  identity()
+  {
+    return {{1, 0, 0},
+            {0, 1, 0},
+            {0, 0, 1}};
+  }
+
+  static
+  Matrix3 // same as rotate_x()
+  rotation_x(real_t angle)
+  {
+    const auto ca=std::cos(angle), sa=std::sin(angle);
+    return {{1,  0,   0},
+            {0, ca, -sa},
+            {0, sa,  ca}};
+  }
+
+  static
+  Matrix3 // same as rotate_y()
+  rotation_y(real_t angle)
+  {
+    const auto ca=std::cos(angle), sa=std::sin(angle);
+    return {{ ca, 0, sa},
+            {  0, 1,  0},
+            {-sa, 0, ca}};
+  }
+
+  static
+  Matrix3 // same as rotate_z()
+  rotation_z(real_t angle)
+  {
+    const auto ca=std::cos(angle), sa=std::sin(angle);
+    return {{ca, -sa, 0},
+            {sa,  ca, 0},
+            { 0,   0, 1}};
+  }
+
+  static
+  Matrix3 // rotation_z(az)*rotation_y(ay)*rotation_x(ax)
+  euler(real_t ax,
+        real_t ay,
+        real_t az)
+  {
+    const auto cx=std::cos(ax), sx=std::sin(ax);
+    const auto cy=std::cos(ay), sy=std::sin(ay);
+    const auto cz=std::cos(az), sz=std::sin(az);
+    return {{cz*cy, cz*sy*sx-sz*cx, cz*sy*cx+sz*sx},
+            {sz*cy, sz*sy*sx+cz*cx, sz*sy*cx-cz*sx},
+            {  -sy,          cy*sx,          cy*cx}};
+  }
+
+  static
+  Matrix3 // around a unit axis (right-hand rule)
+  rotation(const Real3<real_t> &axis,
+           real_t angle)
+  {
+    const auto ca=std::cos(angle), sa=std::sin(angle);
+    const auto t=real_t(1)-ca;
+    const auto [ux, uy, uz]=axis;
+    return {{t*ux*ux+ca,    t*ux*uy-sa*uz, t*ux*uz+sa*uy},
+            {t*ux*uy+sa*uz, t*uy*uy+ca,    t*uy*uz-sa*ux},
+            {t*ux*uz-sa*uy, t*uy*uz+sa*ux, t*uz*uz+ca}};
+  }
+};
+
+template<typename RealType>
+inline constexpr
+Real3<RealType>
+operator*(const Matrix3<RealType> &m,
+          const Real3<RealType> &r3)
+{
+  return {dot(m.x, r3),
+          dot(m.y, r3),
+          dot(m.z, r3)};
+}
+
+template<typename RealType>
+inline constexpr
+Matrix3<RealType>
+transpose(const Matrix3<RealType> &m)
+{
+  return {{m.x.x, m.y.x, m.z.x},
+          {m.x.y, m.y.y, m.z.y},
+          {m.x.z, m.y.z, m.z.z}};
+}
+
+template<typename RealType>
+inline constexpr
+Matrix3<RealType> // lhs applied after rhs
+operator*(const Matrix3<RealType> &lhs,
+          const Matrix3<RealType> &rhs)
+{
+  const auto t=transpose(rhs); // columns of rhs as rows
+  return {t*lhs.x,
+          t*lhs.y,
+          t*lhs.z};
+}
+
+template<typename RealType>
+inline constexpr
+RealType
+determinant(const Matrix3<RealType> &m)
+{
+  return dot(m.x, cross(m.y, m.z));
+}
+
+template<typename RealType>
+inline constexpr
+Matrix3<RealType> // the matrix is expected to be invertible
+inverse(const Matrix3<RealType> &m)
+{
+  // the columns of the inverse are the cross products of the rows
+  const auto c0=cross(m.y, m.z), c1=cross(m.z, m.x), c2=cross(m.x, m.y);
+  const auto inv_det=RealType(1)/dot(m.x, c0);
+  return transpose(Matrix3<RealType>{c0*Real3<RealType>{inv_det},
+                                     c1*Real3<RealType>{inv_det},
+                                     c2*Real3<RealType>{inv_det}});
+}
+
+//~~~~ quaternion ~~~~
+
+template<typename RealType>
+struct Quaternion
+{
+  static_assert(std::is_floating_point_v<RealType>,
+                "floating point expected for template type");
+
+  using real_t = RealType;
+
+  real_t w, x, y, z; // w+xi+yj+zk
+
+  constexpr Quaternion() : w{1}, x{}, y{}, z{} {} // identity
+  constexpr Quaternion(real_t w, real_t x, real_t y, real_t z)
+  : w{w}, x{x}, y{y}, z{z} {}
+
+  static
+  Quaternion // around a unit axis (right-hand rule)
+  rotation(const Real3<real_t> &axis,
+           real_t angle)
+  {
+    const auto ch=std::cos(angle/2), sh=std::sin(angle/2);
+    return {ch, sh*axis.x, sh*axis.y, sh*axis.z};
+  }
+
+  static
+  Quaternion // same as Matrix3::euler()
+  euler(real_t ax,
+        real_t ay,
+        real_t az)
+  {
+    const auto cx=std::cos(ax/2), sx=std::sin(ax/2);
+    const auto cy=std::cos(ay/2), sy=std::sin(ay/2);
+    const auto cz=std::cos(az/2), sz=std::sin(az/2);
+    return {cz*cy*cx+sz*sy*sx,
+            cz*cy*sx-sz*sy*cx,
+            cz*sy*cx+sz*cy*sx,
+            sz*cy*cx-cz*sy*sx};
+  }
+};
+
+template<typename RealType>
+inline constexpr
+Quaternion<RealType> // lhs applied after rhs
+operator*(const Quaternion<RealType> &lhs,
+          const Quaternion<RealType> &rhs)
+{
+  return {lhs.w*rhs.w-lhs.x*rhs.x-lhs.y*rhs.y-lhs.z*rhs.z,
+          lhs.w*rhs.x+lhs.x*rhs.w+lhs.y*rhs.z-lhs.z*rhs.y,
+          lhs.w*rhs.y-lhs.x*rhs.z+lhs.y*rhs.w+lhs.z*rhs.x,
+          lhs.w*rhs.z+lhs.x*rhs.y-lhs.y*rhs.x+lhs.z*rhs.w};
+}
+
+template<typename RealType>
+inline constexpr
+Quaternion<RealType> // inverse rotation (for a unit quaternion)
+conjugate(const Quaternion<RealType> &q)
+{
+  return {q.w, -q.x, -q.y, -q.z};
+}
+
+template<typename RealType>
+inline
+void
+normalise(Quaternion<RealType> &q)
+{
+  const auto mag=std::sqrt(q.w*q.w+q.x*q.x+q.y*q.y+q.z*q.z);
+  const auto inv=mag>std::numeric_limits<RealType>::epsilon()
+                 ? RealType(1)/mag : RealType(1);
+  q.w*=inv;
+  q.x*=inv;
+  q.y*=inv;
+  q.z*=inv;
+}
+
+template<typename RealType>
+inline
+Quaternion<RealType>
+normalised(const Quaternion<RealType> &q)
+{
+  auto result=q;
+  normalise(result);
+  return result;
+}
+
+template<typename RealType>
+inline constexpr
+Real3<RealType> // rotation by a unit quaternion
+operator*(const Quaternion<RealType> &q,
+          const Real3<RealType> &r3)
+{
+  // r3+2w(u x r3)+2u x (u x r3), u being the vector part
+  const auto u=Real3<RealType>{q.x, q.y, q.z};
+  const auto t=cross(u, r3)*Real3<RealType>{RealType(2)};
+  return r3+t*Real3<RealType>{q.w}+cross(u, t);
+}
+
+template<typename RealType>
+inline constexpr
+Matrix3<RealType> // same rotation as a unit quaternion
+matrix(const Quaternion<RealType> &q)
+{
+  const auto [w, x, y, z]=q;
+  return {{1-2*(y*y+z*z),   2*(x*y-w*z),   2*(x*z+w*y)},
+          {  2*(x*y+w*z), 1-2*(x*x+z*z),   2*(y*z-w*x)},
+          {  2*(x*z-w*y),   2*(y*z+w*x), 1-2*(x*x+y*y)}};
+}
+
+//~~~~ affine transformation ~~~~
+
+template<typename RealType>
+struct Affine3
+{
+  static_assert(std::is_floating_point_v<RealType>,
+                "floating point expected for template type");
+
+  using real_t = RealType;
+
+  Matrix3<real_t> m; // linear part, applied first
+  Real3<real_t> t;   // translation
+
+  constexpr Affine3() : m{Matrix3<real_t>::identity()}, t{} {}
+  constexpr Affine3(const Matrix3<real_t> &m,
+                    const Real3<real_t> &t={}) : m{m}, t{t} {}
+  Affine3(const Quaternion<real_t> &q,
+          const Real3<real_t> &t={}) : m{matrix(q)}, t{t} {}
+};
+
+template<typename RealType>
+inline constexpr
+Real3<RealType>
+operator*(const Affine3<RealType> &a,
+          const Real3<RealType> &r3)
+{
+  return a.m*r3+a.t;
+}
+
+template<typename RealType>
+inline constexpr
+Affine3<RealType> // lhs applied after rhs
+operator*(const Affine3<RealType> &lhs,
+          const Affine3<RealType> &rhs)
+{
+  return {lhs.m*rhs.m, lhs.m*rhs.t+lhs.t};
+}
+
+template<typename RealType>
+inline constexpr
+Affine3<RealType> // the linear part is expected to be invertible
+inverse(const Affine3<RealType> &a)
+{
+  const auto m=inverse(a.m);
+  return {m, -(m*a.t)};
+}
+
+//~~~~ display operations ~~~~
+
+template<typename RealType>
+inline
+std::string
+to_string(const Matrix3<RealType> &m)
+{
+  return '{'+to_string(m.x)+", "+
+             to_string(m.y)+", "+
+             to_string(m.z)+'}';
+}
+
+template<typename RealType>
+inline
+std::ostream &
+operator<<(std::ostream &os,
+           const Matrix3<RealType> &m)
+{
+  return os << '{' << m.x << ", "
+                   << m.y << ", "
+                   << m.z << '}';
+}
+
+template<typename RealType>
+inline
+std::string
+to_string(const Quaternion<RealType> &q)
+{
+  return '{'+std::to_string(q.w)+", "+
+             std::to_string(q.x)+", "+
+             std::to_string(q.y)+", "+
+             std::to_string(q.z)+'}';
+}
+
+template<typename RealType>
+inline
+std::ostream &
+operator<<(std::ostream &os,
+           const Quaternion<RealType> &q)
+{
+  return os << '{' << q.w << ", "
+                   << q.x << ", "
+                   << q.y << ", "
+                   << q.z << '}';
+}
+
+template<typename RealType>
+inline
+std::string
+to_string(const Affine3<RealType> &a)
+{
+  return '{'+to_string(a.m)+", "+
+             to_string(a.t)+'}';
+}
+
+template<typename RealType>
+inline
+std::ostream &
+operator<<(std::ostream &os,
+           const Affine3<RealType> &a)
+{
+  return os << '{' << a.m << ", "
+                   << a.t << '}';
+}
+
+} // namespace dim
+
+#endif // DIM_TRANSFORM3_HPP
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
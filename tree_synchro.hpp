@@ -0,0 +1,370 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef DIM_TREE_SYNCHRO_HPP
+#define DIM_TREE_SYNCHRO_HPP
+
+#include "cpu_platform.hpp"
+#include "synchro.hpp"
+#include "utils.hpp"
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+// TreeSynchro offers the same protocol as Synchro (part 0 calls sync()
+// then wait_for_ack(), the other parts call wait_for_sync() then ack())
+// but the parts are organised as a combining tree which follows the
+// cache distances of cpu::Platform: the parts sharing a cache are grouped
+// first, then the leaders of these groups are grouped, and so on, thus
+// only the leaders of the groups exchange data across the numa nodes.
+// Each part only polls its own node (one cacheline) which is written by
+// its parent on sync and by its children on ack; ack() waits for the
+// whole subtree of the part before acknowledging to the parent.
+// As in Team, part part_id is expected to run on cpu index
+// part_id%platform.cpu_count().
+// A value (small and trivially copyable) can be given to ack(), then
+// every node combines the values of its children with its own one before
+// acknowledging, and wait_for_ack() obtains the combination of all of
+// them; barrier() does the same between all the parts during a job, then
+// the release carries the result down the tree to every part.
+// The operation must be associative and commutative; the order of the
+// combination is fixed by the tree, thus the result is reproducible for
+// a given platform and thread count.
+
+namespace dim {
+
+class TreeSynchro
+{
+public:
+
+  using sync_t = Synchro::sync_t;
+
+  static constexpr auto default_fan_in=4;
+
+  static constexpr auto max_payload_size=assumed_cacheline_size;
+
+  TreeSynchro(const cpu::Platform &platform,
+              int thread_count,
+              int fan_in=default_fan_in, // max children within a group
+              int spin_count=Synchro::default_spin_count)
+  : thread_count_{thread_count}
+  , spin_count_{spin_count}
+  , nodes_{std::make_unique<Node_[]>(thread_count)}
+  , children_{std::make_unique<int[]>(thread_count)}
+  {
+    build_(platform, fan_in);
+  }
+
+  TreeSynchro(const TreeSynchro &) =delete;
+  TreeSynchro & operator=(const TreeSynchro &) =delete;
+  TreeSynchro(TreeSynchro &&) =delete;
+  TreeSynchro & operator=(TreeSynchro &&) =delete;
+
+  int
+  thread_count() const
+  {
+    return thread_count_;
+  }
+
+  int // -1 for part 0, the root of the tree
+  parent(int part_id) const
+  {
+    return nodes_[part_id].parent;
+  }
+
+  int
+  child_count(int part_id) const
+  {
+    return nodes_[part_id].child_count;
+  }
+
+  int
+  child(int part_id,
+        int child_index) const
+  {
+    return children_[nodes_[part_id].first_child+child_index];
+  }
+
+  int
+  spin_count() const
+  {
+    return spin_count_;
+  }
+
+  void
+  spin_count(int count) // 0 sleeps as soon as the word is not ready
+  {
+    spin_count_=count;
+  }
+
+  void // part 0 only
+  sync()
+  {
+    release_(0);
+  }
+
+  void // every part but 0
+  wait_for_sync(int part_id,
+                sync_t &last_sync)
+  {
+    auto &node=nodes_[part_id];
+    last_sync=impl_::spin_then_wait_(node.sync, node.sync_sleepers,
+                                     spin_count_,
+      [&](sync_t sync)
+      {
+        return sync!=last_sync;
+      });
+    release_(part_id);
+  }
+
+  void // every part but 0
+  ack(int part_id)
+  {
+    wait_for_children_(part_id);
+    auto &parent=nodes_[nodes_[part_id].parent];
+    // only the last acknowledgement wakes the parent
+    if(parent.ack_count.fetch_sub(1, std::memory_order_seq_cst)==1)
+    {
+      impl_::wake_sleepers_(parent.ack_count, parent.ack_sleepers);
+    }
+  }
+
+  template<typename T,
+           typename BinaryOp>
+  void // every part but 0: value combined with the ones of the subtree
+  ack(int part_id,
+      const T &value,
+      BinaryOp op)
+  {
+    wait_for_children_(part_id);
+    store_payload_(part_id, combine_children_(part_id, value, op));
+    auto &parent=nodes_[nodes_[part_id].parent];
+    if(parent.ack_count.fetch_sub(1, std::memory_order_seq_cst)==1)
+    {
+      impl_::wake_sleepers_(parent.ack_count, parent.ack_sleepers);
+    }
+  }
+
+  void // part 0 only
+  wait_for_ack()
+  {
+    wait_for_children_(0);
+  }
+
+  template<typename T,
+           typename BinaryOp>
+  T // part 0 only: value combined with the ones given to ack()
+  wait_for_ack(const T &value,
+               BinaryOp op)
+  {
+    wait_for_children_(0);
+    return combine_children_(0, value, op);
+  }
+
+  template<typename T,
+           typename BinaryOp>
+  T // every part: value combined with the ones of all the other parts
+  barrier(int part_id,
+          const T &value,
+          BinaryOp op)
+  {
+    auto &node=nodes_[part_id];
+    // arrival of the subtree
+    impl_::spin_then_wait_(node.arrive_count, node.arrive_sleepers,
+                           spin_count_,
+      [&](int count)
+      {
+        return count==node.child_count;
+      });
+    // the children cannot arrive again before being released
+    node.arrive_count.store(0, std::memory_order_relaxed);
+    auto result=combine_children_(part_id, value, op);
+    if(node.parent>=0)
+    {
+      store_payload_(part_id, result);
+      auto &parent=nodes_[node.parent];
+      if(parent.arrive_count.fetch_add(1, std::memory_order_seq_cst)+1==
+         parent.child_count)
+      {
+        impl_::wake_sleepers_(parent.arrive_count, parent.arrive_sleepers);
+      }
+      // release, the parent providing the result
+      node.barrier_seen=impl_::spin_then_wait_(
+        node.barrier_sync, node.barrier_sleepers, spin_count_,
+        [&](sync_t sync)
+        {
+          return sync!=node.barrier_seen;
+        });
+      std::memcpy(&result, parent.payload, sizeof(result));
+    }
+    store_payload_(part_id, result);
+    for(auto c=0; c<node.child_count; ++c)
+    {
+      auto &child=nodes_[children_[node.first_child+c]];
+      child.barrier_sync.fetch_add(1, std::memory_order_seq_cst);
+      impl_::wake_sleepers_(child.barrier_sync, child.barrier_sleepers);
+    }
+    return result;
+  }
+
+  void // every part
+  barrier(int part_id)
+  {
+    barrier(part_id, char{},
+      [](char, char)
+      {
+        return char{};
+      });
+  }
+
+private:
+
+  void
+  release_(int part_id)
+  {
+    auto &node=nodes_[part_id];
+    // the children cannot acknowledge before being released
+    node.ack_count.store(node.child_count, std::memory_order_relaxed);
+    for(auto c=0; c<node.child_count; ++c)
+    {
+      auto &child=nodes_[children_[node.first_child+c]];
+      child.sync.fetch_add(1, std::memory_order_seq_cst);
+      impl_::wake_sleepers_(child.sync, child.sync_sleepers);
+    }
+  }
+
+  void
+  wait_for_children_(int part_id)
+  {
+    auto &node=nodes_[part_id];
+    impl_::spin_then_wait_(node.ack_count, node.ack_sleepers, spin_count_,
+      [&](int count)
+      {
+        return count==0;
+      });
+  }
+
+  template<typename T,
+           typename BinaryOp>
+  T // once the children have acknowledged or arrived
+  combine_children_(int part_id,
+                    T value,
+                    BinaryOp op) const
+  {
+    static_assert(std::is_trivially_copyable_v<T>&&
+                  (sizeof(T)<=max_payload_size),
+                  "small trivially copyable value type expected");
+    const auto &node=nodes_[part_id];
+    for(auto c=0; c<node.child_count; ++c)
+    {
+      T partial;
+      std::memcpy(&partial, nodes_[children_[node.first_child+c]].payload,
+                  sizeof(partial));
+      value=T(op(value, partial));
+    }
+    return value;
+  }
+
+  template<typename T>
+  void
+  store_payload_(int part_id,
+                 const T &value)
+  {
+    std::memcpy(nodes_[part_id].payload, &value, sizeof(value));
+  }
+
+  void
+  build_(const cpu::Platform &platform,
+         int fan_in)
+  {
+    fan_in=std::max(1, fan_in);
+    const auto cpu_count=platform.cpu_count();
+    auto parents=std::vector<int>(thread_count_, -1);
+    auto leaders=std::vector<int>(thread_count_);
+    for(auto id=0; id<thread_count_; ++id)
+    {
+      leaders[id]=id;
+    }
+    // at each distance, the leaders within this distance are grouped
+    // and the first of each group (the lowest part_id) leads it, so that
+    // part 0 is the root in the end
+    for(auto distance=0; size(leaders)>1; ++distance)
+    {
+      auto grouped=std::vector<bool>(size(leaders));
+      auto next_leaders=std::vector<int>{};
+      for(auto i=0; i<int(size(leaders)); ++i)
+      {
+        if(grouped[i])
+        {
+          continue;
+        }
+        auto group=std::vector<int>{leaders[i]};
+        for(auto j=i+1; j<int(size(leaders)); ++j)
+        {
+          if(!grouped[j]&&
+             (platform.distance(leaders[i]%cpu_count,
+                                leaders[j]%cpu_count)<=distance))
+          {
+            grouped[j]=true;
+            group.emplace_back(leaders[j]);
+          }
+        }
+        // the group is a fan_in-ary tree, not to contend on its leader
+        for(auto g=1; g<int(size(group)); ++g)
+        {
+          parents[group[g]]=group[(g-1)/fan_in];
+        }
+        next_leaders.emplace_back(group.front());
+      }
+      leaders=std::move(next_leaders);
+    }
+    // store the children of each part contiguously
+    auto child_count=0;
+    for(auto id=0; id<thread_count_; ++id)
+    {
+      auto &node=nodes_[id];
+      node.parent=parents[id];
+      node.first_child=child_count;
+      node.child_count=0;
+      for(auto other=0; other<thread_count_; ++other)
+      {
+        if(parents[other]==id)
+        {
+          children_[child_count++]=other;
+          ++node.child_count;
+        }
+      }
+    }
+  }
+
+  struct alignas(assumed_cacheline_size) Node_
+  {
+    std::atomic<sync_t> sync{};       // written by the parent
+    std::atomic<int> sync_sleepers{};
+    std::atomic<int> ack_count{};     // decremented by the children
+    std::atomic<int> ack_sleepers{};
+    std::atomic<sync_t> barrier_sync{}; // written by the parent
+    std::atomic<int> barrier_sleepers{};
+    std::atomic<int> arrive_count{};  // incremented by the children
+    std::atomic<int> arrive_sleepers{};
+    sync_t barrier_seen{};            // only used by the part itself
+    int parent{-1};
+    int first_child{};
+    int child_count{};
+    // value of the subtree, or result of the barrier for the children
+    alignas(assumed_cacheline_size) unsigned char payload[max_payload_size];
+  };
+
+  int thread_count_;
+  int spin_count_;
+  std::unique_ptr<Node_[]> nodes_;
+  std::unique_ptr<int[]> children_;
+};
+
+} // namespace dim
+
+#endif // DIM_TREE_SYNCHRO_HPP
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~